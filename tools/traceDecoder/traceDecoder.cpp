@@ -0,0 +1,442 @@
+/**
+ ******************************************************************************
+ * @file    traceDecoder.cpp
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host decoder for the binary stream written by the "trace dump"
+ *          console command. Converts it to a Chrome trace JSON file that can
+ *          be opened with chrome://tracing or https://ui.perfetto.dev.
+ *
+ *          Build: g++ -std=c++17 -O2 -o traceDecoder traceDecoder.cpp
+ *          Usage: traceDecoder <console capture> [output.json]
+ *
+ *          The capture may hold console text around the stream, the stream
+ *          is found by its "FRTR" header.
+ ******************************************************************************
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+/* Must match traceEvents.h and traceRecorder.c on the target */
+constexpr uint8_t STREAM_VERSION = 2;
+constexpr size_t HEADER_LEN = 20;
+constexpr size_t EVENT_LEN = 8;
+constexpr int ISR_TID_BASE = 1000;      /* Interrupts get their own rows */
+
+enum EventType : uint8_t
+{
+    EVT_TASK_SWITCH_IN = 1,
+    EVT_TASK_SWITCH_OUT,
+    EVT_TASK_READY,
+    EVT_QUEUE_SEND,
+    EVT_QUEUE_SEND_FROM_ISR,
+    EVT_QUEUE_RECEIVE,
+    EVT_QUEUE_RECEIVE_FROM_ISR,
+    EVT_QUEUE_BLOCK_SEND,
+    EVT_QUEUE_BLOCK_RECEIVE,
+    EVT_NOTIFY,
+    EVT_NOTIFY_FROM_ISR,
+    EVT_NOTIFY_BLOCK,
+    EVT_ISR_ENTER,
+    EVT_ISR_EXIT
+};
+
+struct Event
+{
+    uint32_t uTimestamp;
+    uint8_t uType;
+    uint8_t uAux;
+    uint16_t usObject;
+};
+
+struct Stream
+{
+    uint32_t uCpuHz = 0;
+    uint32_t uLost = 0;
+    std::map<int, std::string> xTaskNames;
+    std::vector<Event> xEvents;
+};
+
+uint16_t readU16(const uint8_t *pucData)
+{
+    return static_cast<uint16_t>(pucData[0] | (pucData[1] << 8));
+}
+
+uint32_t readU32(const uint8_t *pucData)
+{
+    return static_cast<uint32_t>(pucData[0]) | (static_cast<uint32_t>(pucData[1]) << 8) |
+           (static_cast<uint32_t>(pucData[2]) << 16) | (static_cast<uint32_t>(pucData[3]) << 24);
+}
+
+/**
+* @brief Find and parse the trace stream in a console capture.
+* @param xData Capture contents.
+* @param xStream Receives the parsed stream.
+* @param xError Receives the reason of a failure.
+* @retval true if a complete stream was found.
+*/
+bool parseStream(const std::vector<uint8_t> &xData, Stream &xStream, std::string &xError)
+{
+    const std::string xMagic = "FRTR";
+    size_t xPos = std::string(xData.begin(), xData.end()).find(xMagic);
+
+    if (xPos == std::string::npos || xData.size() - xPos < HEADER_LEN)
+    {
+        xError = "no trace header found";
+        return false;
+    }
+
+    const uint8_t *pucHeader = &xData[xPos];
+    if (pucHeader[4] != STREAM_VERSION || pucHeader[5] != EVENT_LEN)
+    {
+        xError = "unsupported stream version or event size";
+        return false;
+    }
+
+    size_t xTasks = pucHeader[6];
+    size_t xNameLen = pucHeader[7];
+    xStream.uCpuHz = readU32(&pucHeader[8]);
+    size_t xEvents = readU32(&pucHeader[12]);
+    xStream.uLost = readU32(&pucHeader[16]);
+    xPos += HEADER_LEN;
+
+    if (xStream.uCpuHz == 0 || xData.size() - xPos < xTasks * (2 + xNameLen) + xEvents * EVENT_LEN)
+    {
+        xError = "stream is truncated";
+        return false;
+    }
+
+    for (size_t xIndex = 0; xIndex < xTasks; xIndex++, xPos += 2 + xNameLen)
+    {
+        const char *pcName = reinterpret_cast<const char *>(&xData[xPos + 2]);
+        std::string xName(pcName, xNameLen);
+        xName = xName.substr(0, xName.find('\0'));
+        xStream.xTaskNames[readU16(&xData[xPos])] = xName;
+    }
+
+    for (size_t xIndex = 0; xIndex < xEvents; xIndex++, xPos += EVENT_LEN)
+    {
+        Event xEvent;
+        xEvent.uTimestamp = readU32(&xData[xPos]);
+        xEvent.uType = xData[xPos + 4];
+        xEvent.uAux = xData[xPos + 5];
+        xEvent.usObject = readU16(&xData[xPos + 6]);
+        xStream.xEvents.push_back(xEvent);
+    }
+
+    return true;
+}
+
+std::string escape(const std::string &xText)
+{
+    std::string xOut;
+
+    for (char c : xText)
+    {
+        if (c == '"' || c == '\\')
+        {
+            xOut += '\\';
+            xOut += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char cHex[8];
+            std::snprintf(cHex, sizeof(cHex), "\\u%04x", c);
+            xOut += cHex;
+        }
+        else
+        {
+            xOut += c;
+        }
+    }
+
+    return xOut;
+}
+
+/* Exception numbers of the interrupts the target traces, 16 + IRQn */
+std::string isrName(uint16_t usException)
+{
+    static const std::map<uint16_t, std::string> xNames =
+    {
+        { 14, "PendSV" },
+        { 15, "SysTick" },
+        { 40, "TIM1_BRK_TIM9" },
+        { 44, "TIM2" },
+        { 53, "USART1" },
+        { 74, "DMA2_Stream2" },
+        { 86, "DMA2_Stream7" },
+    };
+    auto xIt = xNames.find(usException);
+
+    return (xIt != xNames.end()) ? xIt->second : "IRQ " + std::to_string(usException - 16);
+}
+
+/* Writes Chrome trace events, one per line */
+class ChromeTrace
+{
+public:
+    explicit ChromeTrace(std::ostream &xOut) : xOut(xOut) {}
+
+    void begin() { xOut << "{\"traceEvents\":[\n"; }
+    void end() { xOut << "\n],\"displayTimeUnit\":\"ns\"}\n"; }
+
+    void event(const std::string &xBody)
+    {
+        xOut << (xFirst ? "" : ",\n") << "{\"pid\":1," << xBody << "}";
+        xFirst = false;
+    }
+
+    void threadName(int iTid, const std::string &xName, int iSortIndex)
+    {
+        event("\"tid\":" + std::to_string(iTid) + ",\"ph\":\"M\",\"name\":\"thread_name\",\"args\":{\"name\":\"" +
+              escape(xName) + "\"}");
+        event("\"tid\":" + std::to_string(iTid) + ",\"ph\":\"M\",\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":" +
+              std::to_string(iSortIndex) + "}");
+    }
+
+    void slice(char cPhase, int iTid, double dTs, const std::string &xName)
+    {
+        event("\"tid\":" + std::to_string(iTid) + ",\"ph\":\"" + cPhase + "\",\"ts\":" + ts(dTs) +
+              (xName.empty() ? "" : ",\"name\":\"" + escape(xName) + "\""));
+    }
+
+    void instant(int iTid, double dTs, const std::string &xName, const std::string &xArgs)
+    {
+        event("\"tid\":" + std::to_string(iTid) + ",\"ph\":\"i\",\"s\":\"t\",\"ts\":" + ts(dTs) +
+              ",\"name\":\"" + escape(xName) + "\",\"args\":{" + xArgs + "}");
+    }
+
+    void flow(char cPhase, int iTid, double dTs, unsigned uId)
+    {
+        event("\"tid\":" + std::to_string(iTid) + ",\"ph\":\"" + cPhase + "\",\"ts\":" + ts(dTs) +
+              ",\"id\":" + std::to_string(uId) + ",\"name\":\"wakeup\",\"cat\":\"wakeup\"" +
+              (cPhase == 'f' ? ",\"bp\":\"e\"" : ""));
+    }
+
+private:
+    static std::string ts(double dTs)
+    {
+        char cTs[32];
+        std::snprintf(cTs, sizeof(cTs), "%.3f", dTs);
+        return cTs;
+    }
+
+    std::ostream &xOut;
+    bool xFirst = true;
+};
+
+/**
+* @brief Convert the events into Chrome trace events. Tasks and interrupts get
+*        one row each, task executions and handlers are slices, queue and
+*        notification events are instants on the row of the context that
+*        caused them, and wake ups are flow arrows to the next run of the task.
+* @param xStream Parsed stream.
+* @param xOut Output JSON stream.
+* @retval void
+*/
+void writeChromeTrace(const Stream &xStream, std::ostream &xOut)
+{
+    ChromeTrace xTrace(xOut);
+    std::map<int, std::string> xTaskNames = xStream.xTaskNames;
+    std::map<int, bool> xOpen;                  /* Rows with a slice in progress     */
+    std::map<int, unsigned> xPendingWakeups;    /* Task number -> flow id            */
+    std::vector<int> xIsrStack;                 /* Nested interrupts, innermost last */
+    std::map<int, std::string> xIsrRows;
+    int iCurrentTask = 0;                       /* 0 until the first task switch     */
+    bool xUnknownContext = false;
+    uint64_t uCycles = 0;
+    uint32_t uLast = xStream.xEvents.empty() ? 0 : xStream.xEvents.front().uTimestamp;
+    double dCyclesPerUs = xStream.uCpuHz / 1e6;
+    double dTs = 0;
+    unsigned uFlowId = 0;
+
+    auto taskName = [&](int iTask)
+    {
+        auto xIt = xTaskNames.find(iTask);
+        if (xIt == xTaskNames.end())
+        {
+            /* Deleted before the dump, only the number is known */
+            xIt = xTaskNames.emplace(iTask, "task " + std::to_string(iTask)).first;
+        }
+        return xIt->second;
+    };
+    auto context = [&]()
+    {
+        int iTid = xIsrStack.empty() ? iCurrentTask : xIsrStack.back();
+        xUnknownContext |= (iTid == 0);
+        return iTid;
+    };
+
+    xTrace.begin();
+    for (const Event &xEvent : xStream.xEvents)
+    {
+        /* The 32 bit cycle counter wraps, events are assumed less than one
+        *  wrap apart (53 s at 80 MHz).
+        */
+        uCycles += static_cast<uint32_t>(xEvent.uTimestamp - uLast);
+        uLast = xEvent.uTimestamp;
+        dTs = uCycles / dCyclesPerUs;
+
+        int iObject = xEvent.usObject;
+        int iIsrTid = ISR_TID_BASE + iObject;
+        /* Queues are numbered from 1 in creation order on the target */
+        std::string xQueueArgs = "\"queue\":" + std::to_string(xEvent.usObject) + ",\"waiting\":" +
+                                 std::to_string(xEvent.uAux);
+
+        switch (xEvent.uType)
+        {
+            case EVT_TASK_SWITCH_IN:
+                iCurrentTask = iObject;
+                xTrace.slice('B', iObject, dTs, taskName(iObject));
+                xOpen[iObject] = true;
+                if (xPendingWakeups.count(iObject))
+                {
+                    xTrace.flow('f', iObject, dTs, xPendingWakeups[iObject]);
+                    xPendingWakeups.erase(iObject);
+                }
+                break;
+            case EVT_TASK_SWITCH_OUT:
+                /* The first event may close a run that started before the trace */
+                if (xOpen[iObject])
+                {
+                    xTrace.slice('E', iObject, dTs, "");
+                    xOpen[iObject] = false;
+                }
+                iCurrentTask = 0;
+                break;
+            case EVT_TASK_READY:
+                if (xOpen[context()])
+                {
+                    xTrace.flow('s', context(), dTs, ++uFlowId);
+                    xPendingWakeups[iObject] = uFlowId;
+                }
+                break;
+            case EVT_QUEUE_SEND:
+            case EVT_QUEUE_SEND_FROM_ISR:
+                xTrace.instant(context(), dTs, "queue send", xQueueArgs);
+                break;
+            case EVT_QUEUE_RECEIVE:
+            case EVT_QUEUE_RECEIVE_FROM_ISR:
+                xTrace.instant(context(), dTs, "queue receive", xQueueArgs);
+                break;
+            case EVT_QUEUE_BLOCK_SEND:
+                xTrace.instant(context(), dTs, "block on queue send", xQueueArgs);
+                break;
+            case EVT_QUEUE_BLOCK_RECEIVE:
+                xTrace.instant(context(), dTs, "block on queue receive", xQueueArgs);
+                break;
+            case EVT_NOTIFY:
+            case EVT_NOTIFY_FROM_ISR:
+                xTrace.instant(context(), dTs, "notify " + taskName(iObject),
+                               "\"index\":" + std::to_string(xEvent.uAux));
+                break;
+            case EVT_NOTIFY_BLOCK:
+                xTrace.instant(context(), dTs, "block on notification",
+                               "\"index\":" + std::to_string(xEvent.uAux));
+                break;
+            case EVT_ISR_ENTER:
+                xIsrRows[iIsrTid] = isrName(xEvent.usObject);
+                xTrace.slice('B', iIsrTid, dTs, xIsrRows[iIsrTid]);
+                xOpen[iIsrTid] = true;
+                xIsrStack.push_back(iIsrTid);
+                break;
+            case EVT_ISR_EXIT:
+                if (xOpen[iIsrTid])
+                {
+                    xTrace.slice('E', iIsrTid, dTs, "");
+                    xOpen[iIsrTid] = false;
+                }
+                if (!xIsrStack.empty() && xIsrStack.back() == iIsrTid)
+                {
+                    xIsrStack.pop_back();
+                }
+                break;
+            default:
+                std::cerr << "warning: unknown event type " << static_cast<int>(xEvent.uType) << "\n";
+                break;
+        }
+    }
+
+    /* Close what was still running when the trace was stopped */
+    for (const auto &xRow : xOpen)
+    {
+        if (xRow.second)
+        {
+            xTrace.slice('E', xRow.first, dTs, "");
+        }
+    }
+
+    if (xUnknownContext)
+    {
+        xTrace.threadName(0, "(before first switch)", 0);
+    }
+    for (const auto &xTask : xTaskNames)
+    {
+        xTrace.threadName(xTask.first, xTask.second, xTask.first);
+    }
+    for (const auto &xIsr : xIsrRows)
+    {
+        xTrace.threadName(xIsr.first, xIsr.second, xIsr.first);
+    }
+    xTrace.end();
+}
+
+} /* namespace */
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <console capture> [output.json]\n";
+        return 2;
+    }
+
+    std::ifstream xIn(argv[1], std::ios::binary);
+    if (!xIn)
+    {
+        std::cerr << "error: cannot open " << argv[1] << "\n";
+        return 1;
+    }
+    std::vector<uint8_t> xData((std::istreambuf_iterator<char>(xIn)), std::istreambuf_iterator<char>());
+
+    Stream xStream;
+    std::string xError;
+    if (!parseStream(xData, xStream, xError))
+    {
+        std::cerr << "error: " << xError << "\n";
+        return 1;
+    }
+
+    std::ostringstream xJson;
+    writeChromeTrace(xStream, xJson);
+
+    if (argc > 2)
+    {
+        std::ofstream xOut(argv[2]);
+        xOut << xJson.str();
+        if (!xOut)
+        {
+            std::cerr << "error: cannot write " << argv[2] << "\n";
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << xJson.str();
+    }
+
+    std::cerr << xStream.xEvents.size() << " events, " << xStream.uLost << " overwritten before the dump, "
+              << xStream.xTaskNames.size() << " tasks\n";
+
+    return 0;
+}
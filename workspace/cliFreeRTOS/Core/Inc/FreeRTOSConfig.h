@@ -53,15 +53,12 @@
 #define configTICK_RATE_HZ ((TickType_t)1000)
 #define configMAX_PRIORITIES (5)
 #define configMINIMAL_STACK_SIZE ((unsigned short)130)
-//#define configTOTAL_HEAP_SIZE ((size_t)(75 * 1024))
-#define configTOTAL_HEAP_SIZE ((size_t)(75 * 524))
 #define configMAX_TASK_NAME_LEN (10)
 #define configUSE_TRACE_FACILITY 1
 #define configUSE_16_BIT_TICKS 0
 #define configIDLE_SHOULD_YIELD 1
 #define configUSE_MUTEXES 1
 #define configQUEUE_REGISTRY_SIZE 8
-#define configCHECK_FOR_STACK_OVERFLOW 0
 #define configUSE_RECURSIVE_MUTEXES 1
 #define configUSE_MALLOC_FAILED_HOOK 0
 #define configUSE_APPLICATION_TASK_TAG 0
@@ -70,6 +67,11 @@
 #define configUSE_TASK_NOTIFICATIONS 1
 #define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
 #define configCOMMAND_INT_MAX_OUTPUT_SIZE 500
+#define configCOMMAND_INT_STATIC_TABLE 1
+#define configCOMMAND_INT_MAX_COMMANDS 8
+#define configCOMMAND_INT_HASH_SIZE 64
+#define configCOMMAND_INT_ARENA_SIZE 512
+#define configCOMMAND_INT_MAX_INPUT_SIZE 300
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 0
@@ -90,6 +92,8 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend 1
 #define INCLUDE_vTaskDelayUntil 1
 #define INCLUDE_vTaskDelay 1
+#define INCLUDE_xTaskGetIdleTaskHandle 1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -132,10 +136,107 @@ standard names. */
 #define xPortPendSVHandler PendSV_Handler
 #define xPortSysTickHandler SysTick_Handler
 
-/* Functions and macros used for task statistics */
-extern void bspConfigureTimForRunTimeStats(void);
-extern uint16_t bspGetTimStatsCount(void);
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() bspConfigureTimForRunTimeStats()
-#define portGET_RUN_TIME_COUNTER_VALUE() bspGetTimStatsCount();
+/* Functions and macros used for task statistics, RUN_TIME_STATS_CLOCK_DWT
+selects the clock in appConfig.h. RUN_TIME_COUNTER_TO_US converts run time
+counter values to microseconds. */
+#include "appConfig.h"
+
+/* Memory of the kernel objects, STATIC_ALLOCATION_EN selects it in appConfig.h.
+With static allocation the application provides the memory of every object,
+the idle and timer tasks included, and there is no heap. vTaskList() and
+vTaskGetRunTimeStats() need the heap, their formatting helpers are left out. */
+#if (STATIC_ALLOCATION_EN == 1)
+    #define configSUPPORT_STATIC_ALLOCATION 1
+    #define configSUPPORT_DYNAMIC_ALLOCATION 0
+    #define configUSE_STATS_FORMATTING_FUNCTIONS 0
+    #define configTOTAL_HEAP_SIZE ((size_t)0)
+    #if (HEAP_PROFILER_EN == 1)
+        #error "HEAP_PROFILER_EN needs the heap, STATIC_ALLOCATION_EN must be 0"
+    #endif
+#else
+    #define configSUPPORT_STATIC_ALLOCATION 0
+    #define configSUPPORT_DYNAMIC_ALLOCATION 1
+    #define configUSE_STATS_FORMATTING_FUNCTIONS 1
+    //#define configTOTAL_HEAP_SIZE ((size_t)(75 * 1024))
+    #define configTOTAL_HEAP_SIZE ((size_t)(75 * 524))
+    /* ucHeap is defined in main.c, the mem command shows its bounds */
+    #define configAPPLICATION_ALLOCATED_HEAP 1
+#endif
+
+/* The end of each task stack is kept in the TCB and in TaskStatus_t, the mem
+command shows the stack bounds and the stack profiler watches them. */
+#define configRECORD_STACK_HIGH_ADDRESS 1
+
+/* Contention statistics kept by every queue, semaphore and mutex, shown by the
+queues command. QUEUE_STATS_EN selects them in appConfig.h. */
+#define configUSE_QUEUE_STATS QUEUE_STATS_EN
+
+#if (RUN_TIME_STATS_CLOCK_DWT == 1)
+    extern void bspCycleCounterInit(void);
+    extern uint64_t bspGetCycleCount64(void);
+    #define configRUN_TIME_COUNTER_TYPE uint64_t
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() bspCycleCounterInit()
+    #define portGET_RUN_TIME_COUNTER_VALUE() bspGetCycleCount64()
+    #define RUN_TIME_COUNTER_TO_US(x) ((x) / (SystemCoreClock / 1000000UL))
+#else
+    extern void bspConfigureTimForRunTimeStats(void);
+    extern uint32_t bspGetTimStatsCount(void);
+    #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() bspConfigureTimForRunTimeStats()
+    #define portGET_RUN_TIME_COUNTER_VALUE() bspGetTimStatsCount()
+    #define RUN_TIME_COUNTER_TO_US(x) ((x) * 100UL)
+#endif
+
+/* Task registry of the task snapshot used by the stats command. In stack
+profiling mode the stack profiler also learns the stack bounds of each task and
+overflows are checked at every context switch. */
+extern void vTaskSnapshotTaskCreated(void *pvTask);
+extern void vTaskSnapshotTaskDeleted(void *pvTask);
+#if (STACK_PROFILER_EN == 1)
+    extern void vStackProfilerTaskCreated(void *pvTask, const uint32_t *pxStack, const uint32_t *pxEndOfStack);
+    extern void vStackProfilerTaskDeleted(void *pvTask);
+    #define configCHECK_FOR_STACK_OVERFLOW 2
+    #define traceTASK_CREATE(pxNewTCB) \
+        (vTaskSnapshotTaskCreated(pxNewTCB), \
+         vStackProfilerTaskCreated((pxNewTCB), (pxNewTCB)->pxStack, (pxNewTCB)->pxEndOfStack))
+    #define traceTASK_DELETE(pxTaskToDelete) \
+        (vTaskSnapshotTaskDeleted(pxTaskToDelete), vStackProfilerTaskDeleted(pxTaskToDelete))
+#else
+    #define configCHECK_FOR_STACK_OVERFLOW 0
+    #define traceTASK_CREATE(pxNewTCB) vTaskSnapshotTaskCreated(pxNewTCB)
+    #define traceTASK_DELETE(pxTaskToDelete) vTaskSnapshotTaskDeleted(pxTaskToDelete)
+#endif
+
+/* Kernel event trace recorder used by the trace command. The hooks expand in
+tasks.c and queue.c, where pxCurrentTCB, pxTCB and pxQueue are visible. Queues
+are recorded by the uxQueueNumber that traceQUEUE_CREATE gives them, which
+needs configUSE_TRACE_FACILITY. */
+#if (TRACE_RECORDER_EN == 1)
+    #if (configUSE_TRACE_FACILITY != 1)
+        #error "TRACE_RECORDER_EN needs configUSE_TRACE_FACILITY 1"
+    #endif
+    #include "traceEvents.h"
+    extern void vTraceRecord(uint8_t uType, uint8_t uAux, uint16_t usObject);
+    extern void vTraceQueueCreated(void *pvQueue);
+    #define traceRECORD_QUEUE(type, pxQueue) \
+        vTraceRecord((type), (uint8_t)(pxQueue)->uxMessagesWaiting, (uint16_t)(pxQueue)->uxQueueNumber)
+    #define traceQUEUE_CREATE(pxNewQueue) vTraceQueueCreated(pxNewQueue)
+    #define traceTASK_SWITCHED_IN() vTraceRecord(TRACE_EVT_TASK_SWITCH_IN, 0, (uint16_t)pxCurrentTCB->uxTCBNumber)
+    #define traceTASK_SWITCHED_OUT() vTraceRecord(TRACE_EVT_TASK_SWITCH_OUT, 0, (uint16_t)pxCurrentTCB->uxTCBNumber)
+    #define traceMOVED_TASK_TO_READY_STATE(pxTCB) vTraceRecord(TRACE_EVT_TASK_READY, 0, (uint16_t)(pxTCB)->uxTCBNumber)
+    #define traceQUEUE_SEND(pxQueue) traceRECORD_QUEUE(TRACE_EVT_QUEUE_SEND, pxQueue)
+    #define traceQUEUE_SEND_FROM_ISR(pxQueue) traceRECORD_QUEUE(TRACE_EVT_QUEUE_SEND_FROM_ISR, pxQueue)
+    #define traceQUEUE_RECEIVE(pxQueue) traceRECORD_QUEUE(TRACE_EVT_QUEUE_RECEIVE, pxQueue)
+    #define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) traceRECORD_QUEUE(TRACE_EVT_QUEUE_RECEIVE_FROM_ISR, pxQueue)
+    #define traceBLOCKING_ON_QUEUE_SEND(pxQueue) traceRECORD_QUEUE(TRACE_EVT_QUEUE_BLOCK_SEND, pxQueue)
+    #define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) traceRECORD_QUEUE(TRACE_EVT_QUEUE_BLOCK_RECEIVE, pxQueue)
+    #define traceTASK_NOTIFY(uxIndex) \
+        vTraceRecord(TRACE_EVT_NOTIFY, (uint8_t)(uxIndex), (uint16_t)pxTCB->uxTCBNumber)
+    #define traceTASK_NOTIFY_FROM_ISR(uxIndex) \
+        vTraceRecord(TRACE_EVT_NOTIFY_FROM_ISR, (uint8_t)(uxIndex), (uint16_t)pxTCB->uxTCBNumber)
+    #define traceTASK_NOTIFY_GIVE_FROM_ISR(uxIndex) \
+        vTraceRecord(TRACE_EVT_NOTIFY_FROM_ISR, (uint8_t)(uxIndex), (uint16_t)pxTCB->uxTCBNumber)
+    #define traceTASK_NOTIFY_TAKE_BLOCK(uxIndex) vTraceRecord(TRACE_EVT_NOTIFY_BLOCK, (uint8_t)(uxIndex), 0)
+    #define traceTASK_NOTIFY_WAIT_BLOCK(uxIndex) vTraceRecord(TRACE_EVT_NOTIFY_BLOCK, (uint8_t)(uxIndex), 0)
+#endif
 
 #endif /* FREERTOS_CONFIG_H */
@@ -28,11 +28,101 @@
 #define CONSOLE_BAUDRATE                    9600
 #define CONSOLE_TASK_PRIORITY               1
 #define CONSOLE_STACK_SIZE                  3000
+#define CONSOLE_BATCH_STOP_ON_ERROR         0 /* ';' batches: 1 = Stop at the first failing command, 0 = Run all */
+
+/* Console RX mode: circular DMA buffer drained on UART idle line events or
+*  one interrupt per received byte.
+*/
+#define CONSOLE_RX_DMA_EN                   1 /* 1 = DMA + idle line, 0 = Interrupt per byte */
+#define CONSOLE_RX_DMA_STREAM               DMA2_Stream2
+#define CONSOLE_RX_DMA_CHANNEL              DMA_CHANNEL_4
+#define CONSOLE_RX_DMA_IRQ                  DMA2_Stream2_IRQn
+
+/* Console TX mode: ring buffer drained by DMA or polling transmission */
+#define CONSOLE_TX_DMA_EN                   1 /* 1 = DMA ring buffer, 0 = Polling */
+#define CONSOLE_TX_DMA_STREAM               DMA2_Stream7
+#define CONSOLE_TX_DMA_CHANNEL              DMA_CHANNEL_4
+#define CONSOLE_TX_DMA_IRQ                  DMA2_Stream7_IRQn
+
+/* Console binary mode: COBS framed requests with CRC-16 and packed parameters,
+*  entered by sending ASCII SO (0x0E) at the prompt.
+*/
+#define CONSOLE_BINARY_EN                   1   /* 1 = Enable , 0 = Disable */
+#define CONSOLE_BINARY_MAX_FRAME            64  /* Largest encoded request, in bytes */
+#define CONSOLE_BINARY_MAX_RESPONSE         256 /* Largest response, in bytes */
+
+/* Run time statistics clock: 1 = CPU cycles from the DWT cycle counter extended
+*  to 64 bits, 0 = TIM5 counting every 100us.
+*/
+#define RUN_TIME_STATS_CLOCK_DWT            1
+
+/* Task snapshot used by the stats command */
+#define TASK_SNAPSHOT_MAX_TASKS             8 /* Tasks that fit in a snapshot */
+#define TASK_SNAPSHOT_PER_TASK_EN           1 /* 1 = Scheduler suspended for one task at a time, 0 = uxTaskGetSystemState() */
+
+/* CPU sampler used by the top command: windows of 100 ms, 1 s and 10 s */
+#define CPU_SAMPLER_PRIORITY_TASK           1
+#define CPU_SAMPLER_STACK_SIZE              256
+#define CPU_SAMPLER_PERIOD_MS               100 /* Shortest window, one sample each */
+#define CPU_SAMPLER_WINDOW_RATIO            10  /* Each window is this many times the previous one */
+#define CPU_SAMPLER_WINDOWS                 3
+
+/* Interrupt profiler used by the irq command: entry latency and duration of
+*  the USART1, TIM2 and TIM9 handlers, in CPU cycles.
+*/
+#define IRQ_PROFILER_EN                     0  /* 1 = Enable , 0 = Disable, handlers are not instrumented */
+#define IRQ_PROFILER_BINS                   16 /* log2 histogram bins, the last one holds 2^14 cycles and above */
+
+/* Kernel event trace recorder used by the trace command: task switches, queue
+*  and notification events and console interrupts, 8 bytes per event.
+*/
+#define TRACE_RECORDER_EN                   0   /* 1 = Enable , 0 = Disable, kernel hooks stay empty */
+#define TRACE_BUFFER_EVENTS                 512 /* Events kept in RAM, power of two */
+
+/* Stack profiler used by the stack command: peak stack use of every task and
+*  of the main stack, overflow checks at every context switch.
+*/
+#define STACK_PROFILER_EN                   0  /* 1 = Enable , 0 = Disable */
+#define STACK_PROFILER_MAX_TASKS            10 /* Tasks profiled, deleted tasks included */
+#define STACK_PROFILER_LABEL_LEN            12 /* Command name kept with the peak of the console task */
+#define STACK_PROFILER_MARGIN_PCT           25 /* Recommended size: peak plus this margin ... */
+#define STACK_PROFILER_MIN_MARGIN           32 /* ... and at least this many words */
+
+/* Memory of the kernel objects: 1 = Static, every task, queue and mutex is
+*  created with the ...Static() API and no heap is linked, so RAM use is known
+*  at link time, 0 = From the heap.
+*/
+#define STATIC_ALLOCATION_EN                0
+
+/* Heap implementation: 1 = heap_tlsf.c, two level segregated fit with constant
+*  time allocation and free, 0 = heap_4.c, first fit over the free block list.
+*/
+#define HEAP_TLSF_EN                        0
+
+/* Heap allocation profiler used by the heap command: call sites, free block
+*  distribution and CPU cycles spent in pvPortMalloc() and vPortFree().
+*/
+#define HEAP_PROFILER_EN                    0  /* 1 = Enable , 0 = Disable */
+#define HEAP_PROFILER_SITES                 12 /* Call sites kept, the others are counted together */
+#define HEAP_PROFILER_BINS                  8  /* Free block sizes from 16 bytes, the last bin holds 2 KiB and above */
+
+/* Queue statistics used by the queues command: peak fill level, blocking and
+*  priority inheritance of the queues and mutexes in the queue registry.
+*/
+#define QUEUE_STATS_EN                      0 /* 1 = Enable , 0 = Disable */
+
+/* Command timings used by the perf command: lookup, parameter parsing, handler
+*  and output time of each command, measured with the run time stats clock.
+*/
+#define CLI_PERF_EN                         0  /* 1 = Enable , 0 = Disable */
+#define CLI_PERF_MAX_COMMANDS               24 /* Commands timed, in command table order */
+#define CLI_PERF_BINS                       24 /* log2 histogram bins of the total time in us, the last one holds 2^22us and above */
 
 /* PWM signal settings */
 #define PWM_GPIO_INSTANCE                   GPIOA
 #define PWM_GPIO_PINX                       GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3
 #define PWM_GPIO_ALTERNATE                  GPIO_AF1_TIM2
 #define PWM_TIM_INSTANCE                    TIM2
+#define PWM_TIM_MAX_PERIOD                  0xFFFFFFFF /* Largest ARR, TIM2 and TIM5 are 32 bits, TIM3 and TIM4 16 bits */
 
 #endif
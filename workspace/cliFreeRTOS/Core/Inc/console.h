@@ -10,7 +10,9 @@
 #define __CONSOLE__H
 
 #include "FreeRTOS.h"
+#include "FreeRTOS_CLI.h"
 
 BaseType_t xbspConsoleInit(uint16_t usStackSize, UBaseType_t uxPriority, UART_HandleTypeDef *pxUartHandle);
+CLI_Output_Sink_t *pxConsoleGetSink(void);
 
 #endif
@@ -0,0 +1,30 @@
+/**
+ ******************************************************************************
+ * @file    consoleBinary.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Binary framed protocol for the console: COBS framing, CRC-16 and
+ *          packed command parameters.
+ ******************************************************************************
+ */
+
+#ifndef __CONSOLE_BINARY__H
+#define __CONSOLE_BINARY__H
+
+#include "FreeRTOS.h"
+#include "FreeRTOS_CLI.h"
+
+/* Request flags */
+#define CONSOLE_BINARY_FLAG_OUTPUT          0x01 /* Return the command output in the response */
+
+/* Response status, values below 0x10 are CLI_Packed_Status_t */
+#define CONSOLE_BINARY_STATUS_BAD_FRAME     0x10 /* Bad CRC, length or COBS encoding */
+#define CONSOLE_BINARY_STATUS_TRUNCATED     0x80 /* Flag: output did not fit in the response */
+
+/* Command identifier that takes the console back to text mode */
+#define CONSOLE_BINARY_ID_EXIT              0
+
+void vConsoleBinaryInit(CLI_Output_Sink_t *pxTransport, char *pcScratchBuffer, size_t xScratchBufferLength);
+void vConsoleBinaryStart(void);
+BaseType_t xConsoleBinaryReceive(uint8_t ucByte);
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ ******************************************************************************
+ * @file    cpuSampler.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Windowed CPU utilisation sampler: APIs used by the top command.
+ ******************************************************************************
+ */
+
+#ifndef __CPU_SAMPLER__H
+#define __CPU_SAMPLER__H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "appConfig.h"
+
+/* CPU load of one task, in tenths of percent */
+typedef struct
+{
+    char cName[configMAX_TASK_NAME_LEN];
+    uint16_t usLoad[CPU_SAMPLER_WINDOWS];   /* Last completed window            */
+    uint16_t usPeak[CPU_SAMPLER_WINDOWS];   /* Highest window since it was seen */
+} CpuSamplerTask_t;
+
+typedef struct
+{
+    uint16_t usIdle[CPU_SAMPLER_WINDOWS];   /* Idle task load, last completed window */
+    uint32_t uWindowMs[CPU_SAMPLER_WINDOWS];/* Length of each window                 */
+    uint32_t uSamples;                      /* Samples taken                         */
+    uint32_t uSkipped;                      /* Samples skipped, snapshot was busy    */
+    uint32_t uLastCycles;                   /* CPU cycles taken by the last sample   */
+    uint32_t uMaxCycles;                    /* CPU cycles taken by the longest one   */
+} CpuSamplerInfo_t;
+
+BaseType_t xCpuSamplerInit(uint16_t usStackSize, UBaseType_t uxPriority);
+UBaseType_t uxCpuSamplerRead(CpuSamplerTask_t *pxTasks, UBaseType_t uxMaxTasks, CpuSamplerInfo_t *pxInfo);
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ ******************************************************************************
+ * @file    heapProfiler.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Heap allocation profiler: call sites, free block distribution
+ *          and time spent in the allocator, read by the heap command.
+ ******************************************************************************
+ */
+
+#ifndef __HEAP_PROFILER__H
+#define __HEAP_PROFILER__H
+
+#include "FreeRTOS.h"
+#include "appConfig.h"
+
+#if (HEAP_PROFILER_EN == 1)
+
+/* Allocations made from one return address of pvPortMalloc(). Kernel objects
+*  show the kernel function that allocates them, e.g. xTaskCreate().
+*/
+typedef struct
+{
+    void *pvCaller;             /* NULL for the site that collects the rest */
+    uint32_t uAllocs;
+    uint32_t uFrees;
+    uint32_t uLiveBytes;        /* Blocks in use, headers included */
+    uint32_t uMaxRequest;       /* Largest size asked, in bytes    */
+} HeapSite_t;
+
+/* Time spent in one allocator function, in CPU cycles */
+typedef struct
+{
+    uint32_t uCalls;
+    uint32_t uMax;
+    uint64_t uSum;
+} HeapTiming_t;
+
+typedef struct
+{
+    HeapSite_t xSites[HEAP_PROFILER_SITES + 1]; /* The last one collects the sites that did not fit */
+    HeapTiming_t xMalloc;
+    HeapTiming_t xFree;
+    uint32_t uFailedAllocs;
+    uint32_t uLiveBlocks;
+    uint32_t uFreeBytes;
+    uint32_t uFreeBlocks;
+    uint32_t uLargestFree;
+    uint32_t uFreeBins[HEAP_PROFILER_BINS]; /* Free blocks by size, bin n holds 2^(n+4) bytes and above */
+} HeapProfile_t;
+
+void vPortGetHeapProfile(HeapProfile_t *pxProfile);
+
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @file    irqProfiler.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Interrupt latency and duration profiler: wrapper macros used by
+ *          the interrupt handlers and APIs used by the irq command.
+ ******************************************************************************
+ */
+
+#ifndef __IRQ_PROFILER__H
+#define __IRQ_PROFILER__H
+
+#include "stm32f4xx.h"
+#include "appConfig.h"
+
+/* Profiled interrupts */
+typedef enum
+{
+    IRQ_PROFILE_USART1 = 0,
+    IRQ_PROFILE_TIM2,
+    IRQ_PROFILE_TIM9,
+    IRQ_PROFILE_COUNT
+} IrqProfileId_e;
+
+/* Latency of interrupts whose source has no hardware timestamp */
+#define IRQ_PROFILE_NO_LATENCY              0xFFFFFFFFUL
+
+#if (IRQ_PROFILER_EN == 1)
+
+/* Values in CPU cycles. Bin 0 counts zeros, bin n counts values from 2^(n-1)
+*  to 2^n - 1 and the last bin counts everything above.
+*/
+typedef struct
+{
+    uint32_t uCount;
+    uint32_t uMin;
+    uint32_t uMax;
+    uint64_t uSum;
+    uint32_t uBins[IRQ_PROFILER_BINS];
+} IrqProfileStat_t;
+
+typedef struct
+{
+    IrqProfileStat_t xLatency;      /* From the event to the handler entry */
+    IrqProfileStat_t xDuration;     /* From the handler entry to its exit  */
+} IrqProfile_t;
+
+/* Start profiling a handler, must be the first statement of the handler.
+*  latency is the number of cycles since the interrupt event, evaluated after
+*  the entry time is taken, or IRQ_PROFILE_NO_LATENCY.
+*/
+#define IRQ_PROFILE_ENTER(latency)                      \
+    uint32_t uIrqProfileStart = DWT->CYCCNT;            \
+    uint32_t uIrqProfileLatency = (latency)
+
+/* Stop profiling a handler, must be the last statement of the handler */
+#define IRQ_PROFILE_EXIT(id)                            \
+    vIrqProfilerRecord((id), uIrqProfileLatency, DWT->CYCCNT - uIrqProfileStart)
+
+void vIrqProfilerInit(void);
+void vIrqProfilerRecord(IrqProfileId_e eId, uint32_t uLatency, uint32_t uDuration);
+uint32_t uIrqProfilerTimUpdateLatency(const TIM_TypeDef *pxTim);
+uint32_t uIrqProfilerTimCompareLatency(const TIM_TypeDef *pxTim);
+void vIrqProfilerRead(IrqProfileId_e eId, IrqProfile_t *pxProfile);
+void vIrqProfilerReset(void);
+const char *pcIrqProfilerName(IrqProfileId_e eId);
+
+#else
+
+/* Profiling compiled out, handlers are left untouched */
+#define IRQ_PROFILE_ENTER(latency)
+#define IRQ_PROFILE_EXIT(id)
+
+#endif
+
+#endif
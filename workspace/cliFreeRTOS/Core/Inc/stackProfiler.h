@@ -0,0 +1,39 @@
+/**
+ ******************************************************************************
+ * @file    stackProfiler.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Stack usage profiler: peak stack use of every task and of the main
+ *          stack, APIs used by the stack command.
+ ******************************************************************************
+ */
+
+#ifndef __STACK_PROFILER__H
+#define __STACK_PROFILER__H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "appConfig.h"
+
+#if (STACK_PROFILER_EN == 1)
+
+/* Stack use of one task, in words. Deleted tasks keep their last peak. */
+typedef struct
+{
+    char cName[configMAX_TASK_NAME_LEN];
+    char cPeakLabel[STACK_PROFILER_LABEL_LEN]; /* What the task ran when the peak was seen */
+    uint32_t uSize;             /* Usable stack, in words          */
+    uint32_t uPeak;             /* Highest stack use, in words     */
+    BaseType_t xDeleted;
+} StackProfile_t;
+
+void vStackProfilerInit(void);
+void vStackProfilerTaskCreated(void *pvTask, const StackType_t *pxStack, const StackType_t *pxEndOfStack);
+void vStackProfilerTaskDeleted(void *pvTask);
+void vStackProfilerMark(const char *pcLabel);
+UBaseType_t uxStackProfilerRead(StackProfile_t *pxProfiles, UBaseType_t uxMaxProfiles);
+void vStackProfilerMainStack(uint32_t *puSize, uint32_t *puPeak);
+uint32_t uStackProfilerRecommend(uint32_t uPeak);
+
+#endif
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ ******************************************************************************
+ * @file    taskSnapshot.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Preallocated, double buffered snapshot of the state of all tasks.
+ ******************************************************************************
+ */
+
+#ifndef __TASK_SNAPSHOT__H
+#define __TASK_SNAPSHOT__H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "appConfig.h"
+
+typedef struct
+{
+    TaskStatus_t xTasks[TASK_SNAPSHOT_MAX_TASKS];
+    char cTaskNames[TASK_SNAPSHOT_MAX_TASKS][configMAX_TASK_NAME_LEN]; /* pcTaskName points here */
+    UBaseType_t uxCount;        /* Tasks in xTasks                              */
+    UBaseType_t uxMissed;       /* Tasks that did not fit in xTasks             */
+    configRUN_TIME_COUNTER_TYPE uTotalRunTime; /* Run time counter when the snapshot was taken */
+    uint32_t uSequence;         /* Incremented every time a snapshot is taken   */
+    uint32_t uRefreshCycles;    /* CPU cycles taken by the refresh              */
+    uint32_t uMaxLockCycles;    /* Longest time the scheduler was suspended     */
+    BaseType_t xFreeStackSpace; /* usStackHighWaterMark is filled               */
+} TaskSnapshot_t;
+
+BaseType_t xTaskSnapshotRefresh(BaseType_t xGetFreeStackSpace);
+const TaskSnapshot_t *pxTaskSnapshotAcquire(void);
+void vTaskSnapshotRelease(const TaskSnapshot_t *pxSnapshot);
+void vTaskSnapshotTaskCreated(void *pvTask);
+void vTaskSnapshotTaskDeleted(void *pvTask);
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ ******************************************************************************
+ * @file    traceEvents.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Event types of the trace recorder. Kept apart from
+ *          traceRecorder.h so FreeRTOSConfig.h can use them in the kernel
+ *          trace hooks without including the kernel headers.
+ ******************************************************************************
+ */
+
+#ifndef __TRACE_EVENTS__H
+#define __TRACE_EVENTS__H
+
+/* Event types, tools/traceDecoder uses the same values */
+typedef enum
+{
+    TRACE_EVT_TASK_SWITCH_IN = 1,   /* Object: task number                 */
+    TRACE_EVT_TASK_SWITCH_OUT,      /* Object: task number                 */
+    TRACE_EVT_TASK_READY,           /* Object: task number                 */
+    TRACE_EVT_QUEUE_SEND,           /* Object: queue, aux: items waiting   */
+    TRACE_EVT_QUEUE_SEND_FROM_ISR,  /* Object: queue, aux: items waiting   */
+    TRACE_EVT_QUEUE_RECEIVE,        /* Object: queue, aux: items waiting   */
+    TRACE_EVT_QUEUE_RECEIVE_FROM_ISR, /* Object: queue, aux: items waiting */
+    TRACE_EVT_QUEUE_BLOCK_SEND,     /* Object: queue, aux: items waiting   */
+    TRACE_EVT_QUEUE_BLOCK_RECEIVE,  /* Object: queue, aux: items waiting   */
+    TRACE_EVT_NOTIFY,               /* Object: task number, aux: index     */
+    TRACE_EVT_NOTIFY_FROM_ISR,      /* Object: task number, aux: index     */
+    TRACE_EVT_NOTIFY_BLOCK,         /* Aux: index                          */
+    TRACE_EVT_ISR_ENTER,            /* Object: exception number            */
+    TRACE_EVT_ISR_EXIT              /* Object: exception number            */
+} TraceEventType_e;
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @file    traceRecorder.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Kernel event trace recorder: event format, interrupt macros and
+ *          APIs used by the trace command.
+ ******************************************************************************
+ */
+
+#ifndef __TRACE_RECORDER__H
+#define __TRACE_RECORDER__H
+
+#include "FreeRTOS.h"
+#include "FreeRTOS_CLI.h"
+#include "stm32f4xx.h"
+#include "appConfig.h"
+#include "traceEvents.h"
+
+/* One event, 8 bytes. Queues, semaphores and mutexes are identified by the
+*  queue number vTraceQueueCreated() gives them, in creation order.
+*/
+typedef struct
+{
+    uint32_t uTimestamp;            /* DWT cycle counter */
+    uint8_t uType;
+    uint8_t uAux;
+    uint16_t usObject;
+} TraceEvent_t;
+
+#if (TRACE_RECORDER_EN == 1)
+
+/* Mark the entry and exit of an interrupt handler */
+#define TRACE_ISR_ENTER()   vTraceRecord(TRACE_EVT_ISR_ENTER, 0, (uint16_t)__get_IPSR())
+#define TRACE_ISR_EXIT()    vTraceRecord(TRACE_EVT_ISR_EXIT, 0, (uint16_t)__get_IPSR())
+
+void vTraceRecord(uint8_t uType, uint8_t uAux, uint16_t usObject);
+void vTraceQueueCreated(void *pvQueue);
+void vTraceStart(void);
+void vTraceStop(void);
+BaseType_t xTraceIsRunning(void);
+uint32_t uTraceGetEventCount(void);
+BaseType_t xTraceStream(CLI_Output_Sink_t *pxSink);
+
+#else
+
+#define TRACE_ISR_ENTER()
+#define TRACE_ISR_EXIT()
+
+#endif
+
+#endif
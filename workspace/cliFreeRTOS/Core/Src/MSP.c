@@ -9,6 +9,9 @@
 #include "main.h"
 #include "appConfig.h"
 
+extern DMA_HandleTypeDef consoleDmaRxHandle;
+extern DMA_HandleTypeDef consoleDmaTxHandle;
+
 /**
 * @brief Enable peripheral clocks and set NVIC priorities
 * @param void
@@ -25,8 +28,11 @@ void HAL_MspInit(void)
     __HAL_RCC_GPIOB_CLK_ENABLE();
     __HAL_RCC_GPIOC_CLK_ENABLE();
     __HAL_RCC_TIM2_CLK_ENABLE();
+#if (RUN_TIME_STATS_CLOCK_DWT == 0)
     __HAL_RCC_TIM5_CLK_ENABLE();
+#endif
     __HAL_RCC_USART1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
 
     /* Set priority for PWM timer */
     HAL_NVIC_SetPriority(TIM2_IRQn, 14, 0);
@@ -52,6 +58,48 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandler)
         uartGpioInit.Alternate = GPIO_AF7_USART1;
         HAL_GPIO_Init(CONSOLE_GPIO_PORT, &uartGpioInit);
 
+#if (CONSOLE_RX_DMA_EN == 1)
+        /* RX DMA stream runs in circular mode, the console task follows the
+        *  write position reported by half/full transfer and idle line events.
+        */
+        consoleDmaRxHandle.Instance = CONSOLE_RX_DMA_STREAM;
+        consoleDmaRxHandle.Init.Channel = CONSOLE_RX_DMA_CHANNEL;
+        consoleDmaRxHandle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        consoleDmaRxHandle.Init.PeriphInc = DMA_PINC_DISABLE;
+        consoleDmaRxHandle.Init.MemInc = DMA_MINC_ENABLE;
+        consoleDmaRxHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        consoleDmaRxHandle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        consoleDmaRxHandle.Init.Mode = DMA_CIRCULAR;
+        consoleDmaRxHandle.Init.Priority = DMA_PRIORITY_LOW;
+        consoleDmaRxHandle.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&consoleDmaRxHandle) != HAL_OK)
+            Error_Handler();
+        __HAL_LINKDMA(uartHandler, hdmarx, consoleDmaRxHandle);
+
+        HAL_NVIC_SetPriority(CONSOLE_RX_DMA_IRQ, 15, 0);
+        HAL_NVIC_EnableIRQ(CONSOLE_RX_DMA_IRQ);
+#endif
+
+#if (CONSOLE_TX_DMA_EN == 1)
+        /* TX DMA stream sends one contiguous span of the TX ring per transfer */
+        consoleDmaTxHandle.Instance = CONSOLE_TX_DMA_STREAM;
+        consoleDmaTxHandle.Init.Channel = CONSOLE_TX_DMA_CHANNEL;
+        consoleDmaTxHandle.Init.Direction = DMA_MEMORY_TO_PERIPH;
+        consoleDmaTxHandle.Init.PeriphInc = DMA_PINC_DISABLE;
+        consoleDmaTxHandle.Init.MemInc = DMA_MINC_ENABLE;
+        consoleDmaTxHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        consoleDmaTxHandle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        consoleDmaTxHandle.Init.Mode = DMA_NORMAL;
+        consoleDmaTxHandle.Init.Priority = DMA_PRIORITY_LOW;
+        consoleDmaTxHandle.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+        if (HAL_DMA_Init(&consoleDmaTxHandle) != HAL_OK)
+            Error_Handler();
+        __HAL_LINKDMA(uartHandler, hdmatx, consoleDmaTxHandle);
+
+        HAL_NVIC_SetPriority(CONSOLE_TX_DMA_IRQ, 15, 0);
+        HAL_NVIC_EnableIRQ(CONSOLE_TX_DMA_IRQ);
+#endif
+
         HAL_NVIC_SetPriority(USART1_IRQn, 15 , 0);
         HAL_NVIC_EnableIRQ(USART1_IRQn);
     }
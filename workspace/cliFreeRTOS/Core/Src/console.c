@@ -11,19 +11,34 @@
 #include "FreeRTOS_CLI.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
 #include "stm32f401xc.h"
 #include "stm32f4xx_hal.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
 #include "bsp.h"
+#include "appConfig.h"
+#include "consoleBinary.h"
+#include "taskSnapshot.h"
+#include "cpuSampler.h"
+#include "irqProfiler.h"
+#include "traceRecorder.h"
+#include "stackProfiler.h"
+#include "heapProfiler.h"
 
 #define CONSOLE_VERSION_MAJOR                   1
 #define CONSOLE_VERSION_MINOR                   0
 
-#define MAX_IN_STR_LEN                          300
-#define MAX_OUT_STR_LEN                         600
 #define MAX_RX_QUEUE_LEN                        300
+#define RX_DMA_BUF_LEN                          128
+#define TX_RING_BUF_LEN                         512
+#define RX_RESTART_RETRY_MS                     10   /* Retry period of a failed RX DMA restart */
+#define TX_NOTIFY_INDEX                         1    /* Notification slot used by blocked writers */
+#define TX_WAIT_TIMEOUT_MS                      (2 * TX_RING_BUF_LEN * 10 * 1000 / CONSOLE_BAUDRATE) /* Twice the ring on the line */
+#define BATCH_SEPARATOR                         ';'  /* Separates commands on one line */
+#define TOP_REFRESH_MS                          1000 /* Refresh period of the top command */
+#define TOP_DRAIN_MS                            (2 * 10 * 1000 / CONSOLE_BAUDRATE + 1) /* Two characters on the line */
 
                                                       /* ASCII code definition */
 #define ASCII_TAB                               '\t'  /* Tabulate              */
@@ -34,30 +49,114 @@
 #define ASCII_DEL                               127   /* Delete                */
 #define ASCII_CTRL_PLUS_C                         3   /* CTRL + C              */
 #define ASCII_NACK                               21   /* Negative acknowledge  */
+#define ASCII_SHIFT_OUT                          14   /* Shift out             */
+
+typedef struct
+{
+    uint32_t uRxInterrupts;     /* RX interrupts that delivered data        */
+    uint32_t uRxBytes;          /* Bytes received by the UART               */
+    uint32_t uRxDropped;        /* Bytes lost because the task fell behind  */
+    uint32_t uRxErrors;         /* UART errors (noise, framing, overrun)    */
+    uint32_t uRxStartFails;     /* Reception starts refused by HAL          */
+    uint32_t uTxBytesQueued;    /* Bytes written by the console             */
+    uint32_t uTxDmaTransfers;   /* DMA transfers started                    */
+    uint32_t uTxStalls;         /* Writes that blocked on a full TX ring    */
+    uint32_t uTxErrors;         /* TX spans dropped, DMA failed or stuck    */
+} ConsoleStats_t;
+
+/* RAM layout from the linker script, shown by the mem command */
+extern uint32_t _sdata;         /* Start of .data, first address of RAM */
+extern uint32_t _edata;
+extern uint32_t _sbss;
+extern uint32_t _ebss;
+extern uint32_t _end;           /* Start of the sbrk heap               */
+extern uint32_t _estack;        /* Top of the main stack, end of RAM    */
+extern uint32_t _Min_Stack_Size;/* Size reserved for the main stack     */
+#if (STATIC_ALLOCATION_EN == 0)
+extern uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+#endif
 
 char cRxData;
 QueueHandle_t xQueueRxHandle;
 UART_HandleTypeDef *pxUartDevHandle;
+static TaskHandle_t xTaskConsoleHandle;
+static SemaphoreHandle_t xConsoleTxMutex;
+#if (STATIC_ALLOCATION_EN == 1)
+static StaticTask_t xConsoleTaskBuffer;
+static StackType_t xConsoleStack[CONSOLE_STACK_SIZE];
+static StaticSemaphore_t xConsoleTxMutexBuffer;
+#if (CONSOLE_RX_DMA_EN == 0)
+static StaticQueue_t xQueueRxBuffer;
+static uint8_t ucQueueRxStorage[MAX_RX_QUEUE_LEN * sizeof(char)];
+#endif
+#endif
+static volatile ConsoleStats_t xConsoleStats;
+static BaseType_t xBatchStopOnError = CONSOLE_BATCH_STOP_ON_ERROR;
+
+#if (CONSOLE_RX_DMA_EN == 1)
+/* Circular buffer filled by the RX DMA stream. The head is updated from
+*  interrupt context, the tail is only touched by the console task.
+*/
+static uint8_t ucRxDmaBuf[RX_DMA_BUF_LEN];
+static volatile uint16_t usRxDmaHead;
+static uint16_t usRxDmaTail;
+static uint32_t uRxBytesConsumed;
+static volatile BaseType_t xRxRestartPending;  /* Reception aborted by HAL, restarted by the console task */
+#endif
+
+#if (CONSOLE_TX_DMA_EN == 1)
+/* TX ring buffer: tasks write at the head, the DMA reads from the tail.
+*  usTxDmaLen holds the size of the transfer in flight, 0 when DMA is idle.
+*/
+static uint8_t ucTxRingBuf[TX_RING_BUF_LEN];
+static volatile uint16_t usTxHead;
+static volatile uint16_t usTxTail;
+static volatile uint16_t usTxDmaLen;
+static volatile TaskHandle_t xTxWaitingTask;
+#endif
 static const char *pcWelcomeMsg = "Welcome to the console. Enter 'help' to view a list of available commands.\n";
 
 static const char *prvpcTaskListHeader = "Task states: Bl = Blocked, Re = Ready, Ru = Running, De = Deleted,  Su = Suspended\n\n"\
-                                         "Task name         State  Priority  Stack remaining  CPU usage  Runtime(us)\n"\
-                                         "================= =====  ========  ===============  =========  ===========\n";
+                                         "Task name         State  Priority  Stack remaining  CPU usage       Runtime(s)\n"\
+                                         "================= =====  ========  ===============  =========  ===============\n";
 static const char *prvpcPrompt = "#cmd: ";
+static const char *prvpcNoArenaMsg = "Not enough scratch memory, increase configCOMMAND_INT_ARENA_SIZE\n";
 
 /* Command function prototypes */
-static BaseType_t prvCommandPwmSetFreq(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandPwmSetDuty(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandGpioWrite(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandGpioRead( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandEcho( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandTaskStats( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandHeap(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t prvCommandPwmSetFreq(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandPwmSetDuty(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandGpioWrite(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandGpioRead(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandEcho(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandTaskStats(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandHeap(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
 static BaseType_t prvCommandClk(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandTicks(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandRtcGet(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandRtcSet(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
-static BaseType_t prvCommandVersion(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+static BaseType_t prvCommandTicks(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandRtcGet(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandRtcSet(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandVersion(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandUart(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandBatch(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandTop(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+#if (IRQ_PROFILER_EN == 1)
+static BaseType_t prvCommandIrq(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+#endif
+#if (TRACE_RECORDER_EN == 1)
+static BaseType_t prvCommandTrace(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+#endif
+#if (STACK_PROFILER_EN == 1)
+static BaseType_t prvCommandStack(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+#endif
+#if (QUEUE_STATS_EN == 1)
+static BaseType_t prvCommandQueues(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+#endif
+#if (CLI_PERF_EN == 1)
+static BaseType_t prvCommandPerf(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+#endif
+static BaseType_t prvCommandArena(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandMem(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t xConsoleRead(uint8_t *cReadChar, size_t xLen, TickType_t xTicksToWait);
+HAL_StatusTypeDef xConsoleEnableRxInterrupt(void);
 
 /**
 *   @brief  This function is executed in case of error occurrence.
@@ -76,352 +175,590 @@ static const char *prvpcMapTaskState(eTaskState eState)
     }
 }
 
-static const CLI_Command_Definition_t xCommands[] =
+/* Parameter schemas, checked by the CLI before the command runs */
+static const CLI_Param_Schema_t xGpioWriteParams[] =
+{
+    { eCLIParamEnum, 0, 0, "a|b|c|d|e|h" },   /* Same order as BspGpioInstance_e */
+    { eCLIParamU8, BSP_GPIO_PIN_0, BSP_GPIO_PIN_15, NULL },
+    { eCLIParamU8, BSP_GPIO_PIN_LOW, BSP_GPIO_PIN_HIGH, NULL }
+};
+
+static const CLI_Param_Schema_t xGpioReadParams[] =
+{
+    { eCLIParamEnum, 0, 0, "a|b|c|d|e|h" },   /* Same order as BspGpioInstance_e */
+    { eCLIParamU8, BSP_GPIO_PIN_0, BSP_GPIO_PIN_15, NULL }
+};
+
+static const CLI_Param_Schema_t xPwmFreqParams[] =
+{
+    { eCLIParamU32, 1, 0xFFFFFFFF, NULL }       /* Hz, the upper limit depends on the timer clock and is checked by bspPwmSetFreq() */
+};
+
+static const CLI_Param_Schema_t xPwmDutyParams[] =
+{
+    { eCLIParamU8, 0, 100, NULL },              /* Duty cycle in % */
+    { eCLIParamU8, 1, 4, NULL }                 /* Channel */
+};
+
+static const CLI_Param_Schema_t xRtcSetParams[] =
+{
+    { eCLIParamU8, 0, 23, NULL },
+    { eCLIParamU8, 0, 59, NULL },
+    { eCLIParamU8, 0, 59, NULL }
+};
+
+static const CLI_Param_Schema_t xBatchParams[] =
+{
+    { eCLIParamEnum, 0, 0, "continue|stop" }
+};
+
+#if (IRQ_PROFILER_EN == 1)
+static const CLI_Param_Schema_t xIrqParams[] =
+{
+    { eCLIParamEnum, 0, 0, "show|reset" }
+};
+#endif
+
+#if (TRACE_RECORDER_EN == 1)
+static const CLI_Param_Schema_t xTraceParams[] =
+{
+    { eCLIParamEnum, 0, 0, "start|stop|dump" }
+};
+#endif
+
+#if (QUEUE_STATS_EN == 1)
+static const CLI_Param_Schema_t xQueuesParams[] =
+{
+    { eCLIParamEnum, 0, 0, "show|reset" }
+};
+#endif
+
+#if (CLI_PERF_EN == 1)
+static const CLI_Param_Schema_t xPerfParams[] =
+{
+    { eCLIParamEnum, 0, 0, "show|reset" }
+};
+#endif
+
+/* With configCOMMAND_INT_STATIC_TABLE the table is linked into the CLI command
+*  section in flash and needs no registration.
+*/
+static const CLI_Command_Definition_t xCommands[] FreeRTOS_CLI_STATIC_COMMAND =
 {
     {
         "stats",
         "\r\nstats:\r\n Displays a table with the state of each FreeRTOS task.\r\n",
+        NULL,
+        0,
         prvCommandTaskStats,
-        0
+        NULL
     },
     {
         "gpio-w",
         "\r\ngpio-w <gpio port> <pin number> <logical value>: Write a digital value to GPIO pin.\r\n",
+        NULL,
+        3,
         prvCommandGpioWrite,
-        3
+        xGpioWriteParams
     },
     {
         "gpio-r",
         "\r\ngpio-r <gpio port> <pin number>: Read a GPIO pin.\r\n",
+        NULL,
+        2,
         prvCommandGpioRead,
-        2
+        xGpioReadParams
     },
     {
        "echo",
        "\r\necho <string to echo>\r\n",
+       NULL,
+       1,
        prvCommandEcho,
-       1
+       NULL
     },
     {
         "pwm-f",
         "\r\npwm-f <Frequency>: Set a new frequency.\r\n",
+        NULL,
+        1,
         prvCommandPwmSetFreq,
-        1
+        xPwmFreqParams
     },
     {
         "pwm-d",
         "\r\npwm-d <Duty cycle> Channel>: Set a new PWM duty cycle of a giving channel.\r\n",
+        NULL,
+        2,
         prvCommandPwmSetDuty,
-        2
+        xPwmDutyParams
     },
     {
         "heap",
-        "\r\nheap: Display free heap memory.\r\n",
+        "\r\nheap: Display free heap memory, fragmentation and allocation profile.\r\n",
+        NULL,
+        0,
         prvCommandHeap,
-        0
+        NULL
+    },
+    {
+        "mem",
+        "\r\nmem: RAM map: data, bss, kernel heap, task stacks, CLI buffers and main stack.\r\n",
+        NULL,
+        0,
+        prvCommandMem,
+        NULL
     },
     {
         "clk",
         "\r\nclk: Display clock information.\r\n",
         prvCommandClk,
-        0
+        0,
+        NULL,
+        NULL
     },
     {
         "ticks",
         "\r\nticks: Display OS tick count and run time in seconds.\r\n",
+        NULL,
+        0,
         prvCommandTicks,
-        0
+        NULL
     },
     {
         "rtc-g",
         "\r\nrtc-g: Get the current time\r\n",
+        NULL,
+        0,
         prvCommandRtcGet,
-        0
+        NULL
     },
     {
         "rtc-s",
         "\r\nrtc-s <Hours> <Minutes> <Seconds>: Set a new time\r\n",
+        NULL,
+        3,
         prvCommandRtcSet,
-        3
+        xRtcSetParams
     },
     {
         "version",
         "\r\nversion: Get console version\r\n",
+        NULL,
+        0,
         prvCommandVersion,
-        0
+        NULL
+    },
+    {
+        "uart",
+        "\r\nuart: Display console UART statistics.\r\n",
+        NULL,
+        0,
+        prvCommandUart,
+        NULL
+    },
+    {
+        "batch",
+        "\r\nbatch <continue|stop>: Run or skip the rest of a ';' separated line after a command fails.\r\n",
+        NULL,
+        1,
+        prvCommandBatch,
+        xBatchParams
+    },
+    {
+        "top",
+        "\r\ntop: CPU load of each task over the last windows, refreshed until a key is pressed.\r\n",
+        NULL,
+        0,
+        prvCommandTop,
+        NULL
+    },
+#if (IRQ_PROFILER_EN == 1)
+    {
+        "irq",
+        "\r\nirq <show|reset>: Show or clear interrupt latency and duration histograms.\r\n",
+        NULL,
+        1,
+        prvCommandIrq,
+        xIrqParams
+    },
+#endif
+#if (TRACE_RECORDER_EN == 1)
+    {
+        "trace",
+        "\r\ntrace <start|stop|dump>: Record kernel events, dump streams them in binary for tools/traceDecoder.\r\n",
+        NULL,
+        1,
+        prvCommandTrace,
+        xTraceParams
+    },
+#endif
+#if (STACK_PROFILER_EN == 1)
+    {
+        "stack",
+        "\r\nstack: Peak stack use of each task and recommended stack sizes.\r\n",
+        NULL,
+        0,
+        prvCommandStack,
+        NULL
+    },
+#endif
+#if (QUEUE_STATS_EN == 1)
+    {
+        "queues",
+        "\r\nqueues <show|reset>: Show or clear fill level and blocking statistics of the registered queues and mutexes.\r\n",
+        NULL,
+        1,
+        prvCommandQueues,
+        xQueuesParams
+    },
+#endif
+#if (CLI_PERF_EN == 1)
+    {
+        "perf",
+        "\r\nperf <show|reset>: Show or clear lookup, parsing, handler and output times of each command.\r\n",
+        NULL,
+        1,
+        prvCommandPerf,
+        xPerfParams
+    },
+#endif
+    {
+        "arena",
+        "\r\narena: Peak scratch memory used by each command.\r\n",
+        NULL,
+        0,
+        prvCommandArena,
+        NULL
     },
-    { NULL, NULL, NULL, 0 }
 };
 
 /**
 * @brief Command that gets task statistics.
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandTaskStats( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandTaskStats(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    static uint32_t uTaskIndex = 0;
-    static uint32_t uTotalOfTasks = 0;
-    static uint32_t uTotalRunTime = 1;
-    TaskStatus_t *pxTmpTaskStatus = NULL;
-    static TaskStatus_t *pxTaskStatus = NULL;
+    UBaseType_t uxTaskIndex;
+    configRUN_TIME_COUNTER_TYPE uTotalRunTime;
+    configRUN_TIME_COUNTER_TYPE uRunTimeUs;
+    uint32_t uPercent;
+    uint32_t uCyclesPerUs;
+    const TaskSnapshot_t *pxSnapshot;
+    const TaskStatus_t *pxTmpTaskStatus;
+    char cStack[12];
+
+    /* No allocation: the snapshot buffers are preallocated. When the refresh
+    *  is not possible the previous snapshot is shown, it may come from the
+    *  sampler and have no stack high water marks.
+    */
+    (void)xTaskSnapshotRefresh(pdTRUE);
+    pxSnapshot = pxTaskSnapshotAcquire();
+
+    uTotalRunTime = pxSnapshot->uTotalRunTime / 100;
+    /* Prevent from zero division */
+    if (!uTotalRunTime)
+    {
+        uTotalRunTime = 1;
+    }
 
-    if (pxTaskStatus == NULL)
+    /* Rows are streamed one by one, no buffer holds the whole table */
+    FreeRTOS_CLIPut(pxSink, prvpcTaskListHeader);
+    for (uxTaskIndex = 0; uxTaskIndex < pxSnapshot->uxCount; uxTaskIndex++)
     {
-        uTotalOfTasks = uxTaskGetNumberOfTasks();
-        pxTaskStatus = pvPortMalloc(uTotalOfTasks * sizeof(TaskStatus_t));
-        if (pxTaskStatus == NULL)
+        pxTmpTaskStatus = &pxSnapshot->xTasks[uxTaskIndex];
+        uPercent = (uint32_t)(pxTmpTaskStatus->ulRunTimeCounter / uTotalRunTime);
+        /* The run time counter may be 64 bits, printed as seconds and us */
+        uRunTimeUs = RUN_TIME_COUNTER_TO_US(pxTmpTaskStatus->ulRunTimeCounter);
+        if (pxSnapshot->xFreeStackSpace == pdTRUE)
         {
-           snprintf(pcWriteBuffer, xWriteBufferLen, "Error: Not enough memory for task allocation");
-           goto out_cmd_task_stats;
+            snprintf(cStack, sizeof(cStack), "%dB", pxTmpTaskStatus->usStackHighWaterMark);
         }
-        uTotalOfTasks = uxTaskGetSystemState(pxTaskStatus, uTotalOfTasks, &uTotalRunTime);
-        uTaskIndex = 0;
-        uTotalRunTime /= 100;
-        snprintf(pcWriteBuffer, xWriteBufferLen, prvpcTaskListHeader);
-    }
-    else
-    {
-        memset(pcWriteBuffer, 0x00, MAX_OUT_STR_LEN);
-        /* Prevent from zero division */
-        if (!uTotalRunTime)
+        else
         {
-            uTotalRunTime = 1;
+            strcpy(cStack, "-");
         }
-
-        pxTmpTaskStatus = &pxTaskStatus[uTaskIndex];
-        if (pxTmpTaskStatus->ulRunTimeCounter / uTotalRunTime < 1)
+        if (uPercent < 1)
         {
-         snprintf(pcWriteBuffer, xWriteBufferLen,
-                 "%-16s  %5s  %8lu  %14dB       < 1%%  %11lu\n",
-                 pxTmpTaskStatus->pcTaskName,
-                 prvpcMapTaskState(pxTmpTaskStatus->eCurrentState),
-                 pxTmpTaskStatus->uxCurrentPriority,
-                 pxTmpTaskStatus->usStackHighWaterMark,
-                 pxTmpTaskStatus->ulRunTimeCounter);
+            FreeRTOS_CLIPrintf(pxSink,
+                    "%-16s  %5s  %8lu  %15s       < 1%%  %8lu.%06lu\n",
+                    pxTmpTaskStatus->pcTaskName,
+                    prvpcMapTaskState(pxTmpTaskStatus->eCurrentState),
+                    pxTmpTaskStatus->uxCurrentPriority,
+                    cStack,
+                    (uint32_t)(uRunTimeUs / 1000000), (uint32_t)(uRunTimeUs % 1000000));
         }
         else
         {
-            snprintf(pcWriteBuffer, xWriteBufferLen,
-                    "%-16s  %5s  %8lu  %14dB  %8lu%%  %11lu\n",
+            FreeRTOS_CLIPrintf(pxSink,
+                    "%-16s  %5s  %8lu  %15s  %8lu%%  %8lu.%06lu\n",
                     pxTmpTaskStatus->pcTaskName,
                     prvpcMapTaskState(pxTmpTaskStatus->eCurrentState),
                     pxTmpTaskStatus->uxCurrentPriority,
-                    pxTmpTaskStatus->usStackHighWaterMark,
-                    pxTmpTaskStatus->ulRunTimeCounter / uTotalRunTime,
-                    pxTmpTaskStatus->ulRunTimeCounter);
+                    cStack,
+                    uPercent,
+                    (uint32_t)(uRunTimeUs / 1000000), (uint32_t)(uRunTimeUs % 1000000));
         }
-        uTaskIndex++;
     }
 
-    /* Check if there is more tasks to be process */
-    if (uTaskIndex < uTotalOfTasks)
-       return pdTRUE;
-    else
+    if (pxSnapshot->uxMissed != 0)
     {
-out_cmd_task_stats :
-        if (pxTaskStatus != NULL)
-        {
-            vPortFree(pxTaskStatus);
-            pxTaskStatus = NULL;
-        }
-        return pdFALSE;
+        FreeRTOS_CLIPrintf(pxSink, "%lu tasks not shown, increase TASK_SNAPSHOT_MAX_TASKS\n",
+                           pxSnapshot->uxMissed);
     }
+
+    uCyclesPerUs = SystemCoreClock / 1000000;
+    FreeRTOS_CLIPrintf(pxSink, "\nSnapshot %lu: refresh %luus, scheduler suspended %luus max\n",
+                       pxSnapshot->uSequence,
+                       pxSnapshot->uRefreshCycles / uCyclesPerUs,
+                       pxSnapshot->uMaxLockCycles / uCyclesPerUs);
+
+    vTaskSnapshotRelease(pxSnapshot);
+    return pdPASS;
 }
 
 /**
 * @brief Command that writes to a GPIOx pin.
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandGpioWrite(char *pcWriteBuffer, size_t xWriteBufferLen,\
-                                      const char *pcCommandString)
+static BaseType_t prvCommandGpioWrite(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    BaseType_t xParamLen;
+    size_t xParamLen;
     BspPinNum_e bspPinNum;
-    const char * pcGpioPinNum;
-    const char * pcGpioPinSate;
     const char * pcGpioInstance;
     BspGpioPinState_e bspPinState;
     BspGpioInstance_e bspGpioInstance;
 
-    /* Get GPIO instance and map it from data type char to BSP integer value */
-    pcGpioInstance = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
-    bspGpioInstance = bspGpioMapInstance(*pcGpioInstance);
-    if (bspGpioInstance >= BSP_MAX_GPIO_INSTANCE)
-    {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: invalid GPIO port\n");
-        goto out_cmd_gpio_write;
-    }
-
-    /* Get pin number */
-    pcGpioPinNum = FreeRTOS_CLIGetParameter(pcCommandString, 2, &xParamLen);
-    bspPinNum = atoi(pcGpioPinNum);
-    if (bspPinNum < BSP_GPIO_PIN_0 || bspPinNum > BSP_GPIO_PIN_15)
-    {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: invalid pin number\n");
-        goto out_cmd_gpio_write;
-    }
-
-    /* Get new pin state */
-    pcGpioPinSate = FreeRTOS_CLIGetParameter(pcCommandString, 3, &xParamLen);
-    bspPinState = atoi(pcGpioPinSate);
-    if (bspPinState > BSP_GPIO_PIN_HIGH)
-    {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: invalid pin state\n");
-        goto out_cmd_gpio_write;
-    }
+    /* Parameters were checked against xGpioWriteParams by the CLI */
+    pcGpioInstance = FreeRTOS_CLIGetArg(pxArgs, 0, &xParamLen);
+    bspGpioInstance = (BspGpioInstance_e)pxArgs->ulValue[0];
+    bspPinNum = (BspPinNum_e)pxArgs->ulValue[1];
+    bspPinState = (BspGpioPinState_e)pxArgs->ulValue[2];
 
-    /* Write the new pin state to the GPIO pin and fill FreeRTOS write buffer */
+    /* Write the new pin state to the GPIO pin and report it */
     bspGpioWrite(bspGpioInstance, bspPinNum, bspPinState);
-    snprintf(pcWriteBuffer, xWriteBufferLen, "GPIO: %c, Pin: %c set to %d\n",
-             *pcGpioInstance, *pcGpioPinNum, bspPinState);
+    FreeRTOS_CLIPrintf(pxSink, "GPIO: %c, Pin: %d set to %d\n",
+                       *pcGpioInstance, bspPinNum, bspPinState);
 
-out_cmd_gpio_write:
-    return pdFALSE;
+    return pdPASS;
 }
 
 /**
 * @brief Command that reads from GPIOx Pin
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandGpioRead(char *pcWriteBuffer, size_t xWriteBufferLen\
-                                     , const char *pcCommandString)
+static BaseType_t prvCommandGpioRead(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    BaseType_t xParamLen;
-    const char * pcGpioPinNum;
+    size_t xParamLen;
     const char * pcGpioInstance;
     BspPinNum_e bspPinNum;
     BspGpioPinState_e xPinState;
     BspGpioInstance_e bspGpioInstance;
 
-    /* Get GPIO instance and map it from data type char to BSP integer value */
-    pcGpioInstance = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
-    bspGpioInstance = bspGpioMapInstance(*pcGpioInstance);
-    if (bspGpioInstance >= BSP_MAX_GPIO_INSTANCE)
-    {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: invalid GPIO port\n");
-        goto out_cmd_gpio_read;
-    }
-
-    /* Get pin number */
-    pcGpioPinNum = FreeRTOS_CLIGetParameter(pcCommandString, 2, &xParamLen);
-    bspPinNum = atoi(pcGpioPinNum);
-    if (bspPinNum < BSP_GPIO_PIN_0 || bspPinNum > BSP_GPIO_PIN_15)
-    {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: invalid pin number\n");
-        goto out_cmd_gpio_read;
-    }
+    /* Parameters were checked against xGpioReadParams by the CLI */
+    pcGpioInstance = FreeRTOS_CLIGetArg(pxArgs, 0, &xParamLen);
+    bspGpioInstance = (BspGpioInstance_e)pxArgs->ulValue[0];
+    bspPinNum = (BspPinNum_e)pxArgs->ulValue[1];
 
-    /* Read pin state and fill FreeRTOS write buffer */
+    /* Read pin state and report it */
     xPinState = bspGpioRead(bspGpioInstance, bspPinNum);
-    snprintf(pcWriteBuffer, xWriteBufferLen, "GPIO: %c Pin: %c state: %d\n",
-            *pcGpioInstance, *pcGpioPinNum, xPinState);
+    FreeRTOS_CLIPrintf(pxSink, "GPIO: %c Pin: %d state: %d\n",
+                       *pcGpioInstance, bspPinNum, xPinState);
 
-out_cmd_gpio_read:
-    return pdFALSE;
+    return pdPASS;
 }
 
 /**
 * @brief Echo command line in UNIX systems.
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandEcho( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandEcho(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
     const char *pcStrToOutput;
-    BaseType_t xParamLen;
+    size_t xParamLen;
 
-    /* Get the user input and write it back the FreeRTOS write buffer */
-    pcStrToOutput = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
-    snprintf(pcWriteBuffer, xWriteBufferLen, "%s\n", pcStrToOutput);
+    /* Get the user input and write it back */
+    pcStrToOutput = FreeRTOS_CLIGetArg(pxArgs, 0, &xParamLen);
+    FreeRTOS_CLIWrite(pxSink, pcStrToOutput, xParamLen);
+    FreeRTOS_CLIPut(pxSink, "\n");
 
-    return pdFALSE;
+    return pdPASS;
 }
 
 /**
 * @brief Command that sets a new pwm frequency.
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandPwmSetFreq(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandPwmSetFreq(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    const char * pcFreq;
-    BaseType_t xParamLen;
+    uint32_t uFreq = pxArgs->ulValue[0];
     BspError_e bspStatus;
+    PwmTiming_t xTiming;
 
-    pcFreq = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
-    bspStatus = bspPwmSetFreq(atoi(pcFreq));
+    bspStatus = bspPwmSetFreq(uFreq);
     if (bspStatus == BSP_ERROR_EINVAL)
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: Invalid parameter\n");
+        FreeRTOS_CLIPut(pxSink, "Error: Invalid parameter\n");
     else if (bspStatus == BSP_ERROR_EIO)
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: I/O error\n");
+        FreeRTOS_CLIPut(pxSink, "Error: I/O error\n");
     else
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Frequency set to %dHz\n", atoi(pcFreq));
+    {
+        /* The timer divides its clock by whole numbers, the frequency may differ */
+        bspPwmGetTiming(&xTiming);
+        FreeRTOS_CLIPrintf(pxSink, "Frequency set to %lu.%03luHz, %lu duty steps (prescaler %lu, period %lu)\n",
+                           xTiming.uFreq, xTiming.uFreqMilli, xTiming.uPeriod + 1,
+                           xTiming.uPrescaler, xTiming.uPeriod);
+    }
 
-    return pdFALSE;
+    return (bspStatus == BSP_NO_ERROR) ? pdPASS : pdFAIL;
 }
 
 /**
 * @brief Command that sets a new pwm duty cycle.
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandPwmSetDuty(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandPwmSetDuty(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
     BspError_e bspStatus;
-    BaseType_t xParamLen;
-    const char * pcChannel;
-    const char * pcDutyCycle;
-
-    pcDutyCycle = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
-    pcChannel = FreeRTOS_CLIGetParameter(pcCommandString, 2, &xParamLen);
+    uint8_t uDutyCycle = pxArgs->ulValue[0];
+    uint8_t uChannel = pxArgs->ulValue[1];
 
     /* Index starts at index 0, so 1 is subtracted from channel */
-    bspStatus = bspPwmSetDuty(atoi(pcDutyCycle), atoi(pcChannel) - 1);
+    bspStatus = bspPwmSetDuty(uDutyCycle, uChannel - 1);
     if (bspStatus == BSP_ERROR_EINVAL)
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: Invalid parameter\n");
+        FreeRTOS_CLIPut(pxSink, "Error: Invalid parameter\n");
     else if (bspStatus == BSP_ERROR_EIO)
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: I/O error\n");
+        FreeRTOS_CLIPut(pxSink, "Error: I/O error\n");
     else
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Channel %d set to %d%% duty cycle \n", atoi(pcChannel), atoi(pcDutyCycle));
+        FreeRTOS_CLIPrintf(pxSink, "Channel %d set to %d%% duty cycle \n", uChannel, uDutyCycle);
 
-    return pdFALSE;
+    return (bspStatus == BSP_NO_ERROR) ? pdPASS : pdFAIL;
 }
 
+#if (HEAP_PROFILER_EN == 1)
 /**
-* @brief Command that gets heap information
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @brief Print the allocation profile: time spent in the allocator, free block
+*        sizes and allocations by call site.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line, gives the scratch arena.
+* @retval pdPASS if the profile was printed, otherwise pdFAIL.
 */
-static BaseType_t prvCommandHeap(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvPrintHeapProfile(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
+    HeapProfile_t *pxProfile;
+    UBaseType_t uxIndex;
+    HeapSite_t *pxSite;
+
+    pxProfile = FreeRTOS_CLIArenaAlloc(pxArgs, sizeof(HeapProfile_t));
+    if (pxProfile == NULL)
+    {
+        FreeRTOS_CLIPut(pxSink, prvpcNoArenaMsg);
+        return pdFAIL;
+    }
+    vPortGetHeapProfile(pxProfile);
+
+    FreeRTOS_CLIPrintf(pxSink, "Live blocks          : %lu, failed allocations: %lu\n",
+                       pxProfile->uLiveBlocks, pxProfile->uFailedAllocs);
+    FreeRTOS_CLIPrintf(pxSink, "pvPortMalloc         : %lu calls, avg %lu max %lu cycles\n",
+                       pxProfile->xMalloc.uCalls,
+                       (pxProfile->xMalloc.uCalls != 0) ? (uint32_t)(pxProfile->xMalloc.uSum / pxProfile->xMalloc.uCalls) : 0,
+                       pxProfile->xMalloc.uMax);
+    FreeRTOS_CLIPrintf(pxSink, "vPortFree            : %lu calls, avg %lu max %lu cycles\n",
+                       pxProfile->xFree.uCalls,
+                       (pxProfile->xFree.uCalls != 0) ? (uint32_t)(pxProfile->xFree.uSum / pxProfile->xFree.uCalls) : 0,
+                       pxProfile->xFree.uMax);
+
+    FreeRTOS_CLIPut(pxSink, "\nFree block size  Blocks\n===============  ======\n");
+    for (uxIndex = 0; uxIndex < HEAP_PROFILER_BINS; uxIndex++)
+    {
+        if (uxIndex == HEAP_PROFILER_BINS - 1)
+        {
+            FreeRTOS_CLIPrintf(pxSink, "%6lu and above  %6lu\n", 16UL << uxIndex, pxProfile->uFreeBins[uxIndex]);
+        }
+        else
+        {
+            FreeRTOS_CLIPrintf(pxSink, "%6lu - %6lu  %6lu\n", 16UL << uxIndex, (32UL << uxIndex) - 1,
+                               pxProfile->uFreeBins[uxIndex]);
+        }
+    }
+
+    FreeRTOS_CLIPut(pxSink, "\nCall site   Allocs   Frees  Live bytes  Largest request\n"
+                            "==========  ======  ======  ==========  ===============\n");
+    for (uxIndex = 0; uxIndex <= HEAP_PROFILER_SITES; uxIndex++)
+    {
+        pxSite = &pxProfile->xSites[uxIndex];
+        if (pxSite->uAllocs == 0)
+        {
+            continue;
+        }
+        if (uxIndex == HEAP_PROFILER_SITES)
+        {
+            FreeRTOS_CLIPut(pxSink, "other     ");
+        }
+        else
+        {
+            FreeRTOS_CLIPrintf(pxSink, "0x%08lx", (uint32_t)pxSite->pvCaller);
+        }
+        FreeRTOS_CLIPrintf(pxSink, "  %6lu  %6lu  %10lu  %15lu\n",
+                           pxSite->uAllocs, pxSite->uFrees, pxSite->uLiveBytes, pxSite->uMaxRequest);
+    }
+
+    return pdPASS;
+}
+#endif
 
+/**
+* @brief Command that gets heap information
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandHeap(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+#if (STATIC_ALLOCATION_EN == 1)
+    FreeRTOS_CLIPrintf(pxSink, "Heap size            :   0 bytes, kernel objects are statically allocated\n");
+#else
     size_t xHeapFree;
     size_t xHeapMinMemExisted;
+    HeapStats_t xStats;
 
     xHeapFree = xPortGetFreeHeapSize();
     xHeapMinMemExisted = xPortGetMinimumEverFreeHeapSize();
-    snprintf(pcWriteBuffer, xWriteBufferLen,
-             "Heap size            : %3u bytes (%3d KiB)\nRemaining            : %3u bytes (%3d KiB)\nMinimum ever existed : %3u bytes (%3d KiB)\n",
-             configTOTAL_HEAP_SIZE, configTOTAL_HEAP_SIZE / 1024, xHeapFree, xHeapFree / 1024, xHeapMinMemExisted, xHeapMinMemExisted / 1024);
-
-    return pdFALSE;
+    /* One line per call, the formatted text must fit the CLI printf buffer */
+    FreeRTOS_CLIPrintf(pxSink, "Heap size            : %3u bytes (%3d KiB)\n",
+                       configTOTAL_HEAP_SIZE, configTOTAL_HEAP_SIZE / 1024);
+    FreeRTOS_CLIPrintf(pxSink, "Remaining            : %3u bytes (%3d KiB)\n",
+                       xHeapFree, xHeapFree / 1024);
+    FreeRTOS_CLIPrintf(pxSink, "Minimum ever existed : %3u bytes (%3d KiB)\n",
+                       xHeapMinMemExisted, xHeapMinMemExisted / 1024);
+
+    /* Fragmentation: share of the free bytes that the largest free block can
+    *  not serve in one allocation.
+    */
+    vPortGetHeapStats(&xStats);
+    FreeRTOS_CLIPrintf(pxSink, "Largest free block   : %3u bytes in %u free blocks\n",
+                       xStats.xSizeOfLargestFreeBlockInBytes, xStats.xNumberOfFreeBlocks);
+    FreeRTOS_CLIPrintf(pxSink, "Fragmentation        : %3u%%\n",
+                       (xStats.xAvailableHeapSpaceInBytes != 0) ?
+                       100 - xStats.xSizeOfLargestFreeBlockInBytes * 100 / xStats.xAvailableHeapSpaceInBytes : 0);
+
+#if (HEAP_PROFILER_EN == 1)
+    return prvPrintHeapProfile(pxSink, pxArgs);
+#endif
+#endif
+
+    return pdPASS;
 }
 
 /**
@@ -439,219 +776,1297 @@ static BaseType_t prvCommandClk(char *pcWriteBuffer, size_t xWriteBufferLen, con
 
 /**
 * @brief Command that calculate OS ticks information.
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandTicks(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandTicks(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
     uint32_t uMs;
     uint32_t uSec;
     TickType_t xTickCount = xTaskGetTickCount();
+    configRUN_TIME_COUNTER_TYPE uRunTimeUs = RUN_TIME_COUNTER_TO_US(portGET_RUN_TIME_COUNTER_VALUE());
 
     uSec = xTickCount / configTICK_RATE_HZ;
     uMs = xTickCount % configTICK_RATE_HZ;
-    snprintf(pcWriteBuffer, xWriteBufferLen,
+    FreeRTOS_CLIPrintf(pxSink,
              "Tick rate: %u Hz\nTicks: %lu\nRun time: %lu.%.3lu seconds\n",
               (unsigned)configTICK_RATE_HZ, xTickCount, uSec, uMs);
+    FreeRTOS_CLIPrintf(pxSink, "Stats clock: %s\nStats run time: %lu.%06lu seconds\n",
+                       (RUN_TIME_STATS_CLOCK_DWT == 1) ? "CPU cycles (DWT)" : "TIM5, 100us",
+                       (uint32_t)(uRunTimeUs / 1000000), (uint32_t)(uRunTimeUs % 1000000));
 
-    return pdFALSE;
+    return pdPASS;
 }
 
 
 /**
 * @brief Get the current time stored in RTC registers
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandRtcGet(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandRtcGet(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
     BspRtcTime bspRtcTime;
     BspError_e bspStatus;
 
     bspStatus = bspRtcGetTime(&bspRtcTime);
     if (bspStatus != BSP_NO_ERROR)
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: Could not get current time\n");
+    {
+        FreeRTOS_CLIPut(pxSink, "Error: Could not get current time\n");
+        return pdFAIL;
+    }
 
-    snprintf(pcWriteBuffer, xWriteBufferLen, "Time (24hr format): %u:%u:%u\n",
+    FreeRTOS_CLIPrintf(pxSink, "Time (24hr format): %u:%u:%u\n",
             bspRtcTime.uHours, bspRtcTime.uMinutes, bspRtcTime.uSeconds);
 
-    return pdFALSE;
+    return pdPASS;
 }
 
 /**
 * @brief Set a new time in RCT registers
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandRtcSet(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandRtcSet(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    const char *cHours;
-    const char *cMinutes;
-    const char *cSeconds;
-    BaseType_t xParamLen;
     BspError_e bspStatus;
     BspRtcTime bspRtcTime;
 
-    cHours = FreeRTOS_CLIGetParameter(pcCommandString, 1, &xParamLen);
-    cMinutes = FreeRTOS_CLIGetParameter(pcCommandString, 2, &xParamLen);
-    cSeconds = FreeRTOS_CLIGetParameter(pcCommandString, 3, &xParamLen);
-
-    bspRtcTime.uHours = atoi(cHours);
-    bspRtcTime.uMinutes = atoi(cMinutes);
-    bspRtcTime.uSeconds = atoi(cSeconds);
+    bspRtcTime.uHours = pxArgs->ulValue[0];
+    bspRtcTime.uMinutes = pxArgs->ulValue[1];
+    bspRtcTime.uSeconds = pxArgs->ulValue[2];
 
     bspStatus = bspRtcSetTime(&bspRtcTime);
     if (bspStatus == BSP_ERROR_EINVAL)
     {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: Invalid parameters\n");
-        goto out_cmd_rtc_set;
+        FreeRTOS_CLIPut(pxSink, "Error: Invalid parameters\n");
+        return pdFAIL;
     }
     else if (bspStatus == BSP_ERROR_EIO)
     {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Error: I/O\n");
-        goto out_cmd_rtc_set;
-    }
-    else
-    {
-        snprintf(pcWriteBuffer, xWriteBufferLen, "Time (24hr format) set to: %u:%u:%u\n",
-                bspRtcTime.uHours, bspRtcTime.uMinutes, bspRtcTime.uSeconds);
+        FreeRTOS_CLIPut(pxSink, "Error: I/O\n");
+        return pdFAIL;
     }
 
-out_cmd_rtc_set:
-    return pdFALSE;
+    FreeRTOS_CLIPrintf(pxSink, "Time (24hr format) set to: %u:%u:%u\n",
+            bspRtcTime.uHours, bspRtcTime.uMinutes, bspRtcTime.uSeconds);
+
+    return pdPASS;
 }
 
 /**
 * @brief Get current console version
-* @param *pcWriteBuffer FreeRTOS CLI write buffer.
-* @param xWriteBufferLen Length of write buffer.
-* @param *pcCommandString pointer to the command name.
-* @retval FreeRTOS status
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t prvCommandVersion(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+static BaseType_t prvCommandVersion(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    snprintf(pcWriteBuffer, xWriteBufferLen, "%d.%d\n", (uint8_t)(CONSOLE_VERSION_MAJOR), (uint8_t)(CONSOLE_VERSION_MINOR));
-    return pdFALSE;
+    FreeRTOS_CLIPrintf(pxSink, "%d.%d\n", (uint8_t)(CONSOLE_VERSION_MAJOR), (uint8_t)(CONSOLE_VERSION_MINOR));
+    return pdPASS;
 }
 
 /**
-* @brief Reads from UART RX buffer. Reads one bye at the time.
-* @param *cReadChar pointer to where data will be stored.
-* @retval FreeRTOS status
+* @brief Command that shows console UART counters.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static BaseType_t xConsoleRead(uint8_t *cReadChar, size_t xLen)
+static BaseType_t prvCommandUart(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    BaseType_t xRetVal = pdFALSE;
+    uint32_t uInterrupts = xConsoleStats.uRxInterrupts;
+    uint32_t uBytes = xConsoleStats.uRxBytes;
+    uint32_t uTransfers = xConsoleStats.uTxDmaTransfers;
+    uint32_t uQueued = xConsoleStats.uTxBytesQueued;
+
+    FreeRTOS_CLIPrintf(pxSink, "RX mode          : %s\n",
+                       (CONSOLE_RX_DMA_EN == 1) ? "DMA + idle line" : "Interrupt per byte");
+    FreeRTOS_CLIPrintf(pxSink, "RX interrupts    : %lu\n", uInterrupts);
+    FreeRTOS_CLIPrintf(pxSink, "RX bytes         : %lu\n", uBytes);
+    FreeRTOS_CLIPrintf(pxSink, "Bytes/interrupt  : %lu\n", (uInterrupts != 0) ? (uBytes / uInterrupts) : 0);
+    FreeRTOS_CLIPrintf(pxSink, "RX dropped       : %lu\n", xConsoleStats.uRxDropped);
+    FreeRTOS_CLIPrintf(pxSink, "RX errors        : %lu\n", xConsoleStats.uRxErrors);
+    FreeRTOS_CLIPrintf(pxSink, "RX start fails   : %lu\n", xConsoleStats.uRxStartFails);
+    FreeRTOS_CLIPrintf(pxSink, "TX mode          : %s\n",
+                       (CONSOLE_TX_DMA_EN == 1) ? "DMA ring buffer" : "Polling");
+    FreeRTOS_CLIPrintf(pxSink, "TX bytes queued  : %lu\n", uQueued);
+    FreeRTOS_CLIPrintf(pxSink, "TX DMA transfers : %lu\n", uTransfers);
+    FreeRTOS_CLIPrintf(pxSink, "Bytes/transfer   : %lu\n", (uTransfers != 0) ? (uQueued / uTransfers) : 0);
+    FreeRTOS_CLIPrintf(pxSink, "TX stalls (full) : %lu\n", xConsoleStats.uTxStalls);
+    FreeRTOS_CLIPrintf(pxSink, "TX errors        : %lu\n", xConsoleStats.uTxErrors);
+
+    return pdPASS;
+}
 
-    if (xQueueRxHandle == NULL || cReadChar == NULL)
+/**
+* @brief Command that selects what happens to a ';' separated batch when one
+*        of its commands fails.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandBatch(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    /* Value is the position in "continue|stop" */
+    xBatchStopOnError = (pxArgs->ulValue[0] == 1) ? pdTRUE : pdFALSE;
+    FreeRTOS_CLIPrintf(pxSink, "Batches %s at the first failing command\n",
+                       (xBatchStopOnError == pdTRUE) ? "stop" : "continue");
+
+    return pdPASS;
+}
+
+/**
+* @brief Print one page of the top command.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxTasks Room for TASK_SNAPSHOT_MAX_TASKS tasks.
+* @retval void
+*/
+static void prvPrintTop(CLI_Output_Sink_t *pxSink, CpuSamplerTask_t *pxTasks)
+{
+    CpuSamplerInfo_t xInfo;
+    UBaseType_t uxCount;
+    UBaseType_t uxIndex;
+    uint8_t uWindow;
+    uint32_t uCyclesPerUs = SystemCoreClock / 1000000;
+
+    uxCount = uxCpuSamplerRead(pxTasks, TASK_SNAPSHOT_MAX_TASKS, &xInfo);
+
+    /* Load and peak of each window, in tenths of percent */
+    FreeRTOS_CLIPut(pxSink, "Task name  ");
+    for (uWindow = 0; uWindow < CPU_SAMPLER_WINDOWS; uWindow++)
     {
-        return xRetVal;
+        FreeRTOS_CLIPrintf(pxSink, "  %6lums    peak", xInfo.uWindowMs[uWindow]);
     }
+    FreeRTOS_CLIPut(pxSink, "\n");
 
-    /* Block until the there is input from the user */
-    return xQueueReceive(xQueueRxHandle, cReadChar, portMAX_DELAY);
+    for (uxIndex = 0; uxIndex < uxCount; uxIndex++)
+    {
+        FreeRTOS_CLIPrintf(pxSink, "%-11s", pxTasks[uxIndex].cName);
+        for (uWindow = 0; uWindow < CPU_SAMPLER_WINDOWS; uWindow++)
+        {
+            FreeRTOS_CLIPrintf(pxSink, "  %5u.%u%%  %4u.%u%%",
+                               pxTasks[uxIndex].usLoad[uWindow] / 10, pxTasks[uxIndex].usLoad[uWindow] % 10,
+                               pxTasks[uxIndex].usPeak[uWindow] / 10, pxTasks[uxIndex].usPeak[uWindow] % 10);
+        }
+        FreeRTOS_CLIPut(pxSink, "\n");
+    }
+
+    FreeRTOS_CLIPut(pxSink, "\nIdle       ");
+    for (uWindow = 0; uWindow < CPU_SAMPLER_WINDOWS; uWindow++)
+    {
+        FreeRTOS_CLIPrintf(pxSink, "  %5u.%u%%         ", xInfo.usIdle[uWindow] / 10, xInfo.usIdle[uWindow] % 10);
+    }
+    FreeRTOS_CLIPrintf(pxSink, "\nSampler: %lu samples, %lu skipped, %luus per sample (max %luus)\n",
+                       xInfo.uSamples, xInfo.uSkipped,
+                       xInfo.uLastCycles / uCyclesPerUs, xInfo.uMaxCycles / uCyclesPerUs);
 }
 
 /**
-* @brief Write to UART TX
-* @param *buff buffer to be written.
-* @retval HAL status
+* @brief Command that shows the CPU load of each task over the sampler
+*        windows. On the console it refreshes in place until a key is pressed.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-static HAL_StatusTypeDef vConsoleWrite(const char *buff)
+static BaseType_t prvCommandTop(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    HAL_StatusTypeDef status;
-    size_t len = strlen(buff);
+    CpuSamplerTask_t *pxTasks;
+    uint8_t uKey;
 
-    if (pxUartDevHandle == NULL || *buff == '\0' || len < 1)
+    pxTasks = FreeRTOS_CLIArenaAlloc(pxArgs, TASK_SNAPSHOT_MAX_TASKS * sizeof(CpuSamplerTask_t));
+    if (pxTasks == NULL)
     {
-        return HAL_ERROR;
+        FreeRTOS_CLIPut(pxSink, prvpcNoArenaMsg);
+        return pdFAIL;
     }
 
-    status = HAL_UART_Transmit(pxUartDevHandle, (uint8_t *)buff, strlen(buff), portMAX_DELAY);
-    if (status != HAL_OK)
+    /* Other sessions (binary mode, other tasks) get a single page */
+    if (FreeRTOS_CLIIsInteractive(pxArgs) != pdTRUE)
     {
-    	return HAL_ERROR;
+        prvPrintTop(pxSink, pxTasks);
+        return pdPASS;
     }
-    return status;
+
+    /* The LF of a CRLF line ending, or anything typed ahead, is not a key */
+    while (xConsoleRead(&uKey, sizeof(uKey), pdMS_TO_TICKS(TOP_DRAIN_MS)) == pdTRUE)
+    {
+    }
+
+    do
+    {
+        /* Clear the screen and go home, as the form feed key does */
+        FreeRTOS_CLIPut(pxSink, "\x1b[2J\x1b[0;0H");
+        prvPrintTop(pxSink, pxTasks);
+        FreeRTOS_CLIPut(pxSink, "\nPress any key to exit\n");
+        FreeRTOS_CLIFlush(pxSink);
+    } while (xConsoleRead(&uKey, sizeof(uKey), pdMS_TO_TICKS(TOP_REFRESH_MS)) != pdTRUE);
+
+    return pdPASS;
 }
 
+#if (IRQ_PROFILER_EN == 1)
 /**
-* @brief Enables UART RX reception.
-* @param void
+* @brief Print one interrupt statistic and its non empty histogram bins.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pcName Interrupt name.
+* @param *pcEvent Statistic name.
+* @param *pxStat Statistic to be printed.
 * @retval void
 */
-void vConsoleEnableRxInterrupt(void)
+static void prvPrintIrqStat(CLI_Output_Sink_t *pxSink, const char *pcName, const char *pcEvent,
+                            const IrqProfileStat_t *pxStat)
 {
-    if (pxUartDevHandle == NULL)
+    uint8_t uBin;
+
+    if (pxStat->uCount == 0)
     {
+        FreeRTOS_CLIPrintf(pxSink, "%-7s %-9s %9s\n", pcName, pcEvent, "-");
         return;
     }
-    /* UART Rx IT is enabled by reading a character */
-    HAL_UART_Receive_IT(pxUartDevHandle,(uint8_t*)&cRxData, 1);
+
+    FreeRTOS_CLIPrintf(pxSink, "%-7s %-9s %9lu %9lu %9lu %9lu\n", pcName, pcEvent,
+                       pxStat->uCount, pxStat->uMin, pxStat->uMax,
+                       (uint32_t)(pxStat->uSum / pxStat->uCount));
+
+    /* Bin 0 counts zeros, bin n counts 2^(n-1) to 2^n - 1 cycles */
+    FreeRTOS_CLIPut(pxSink, "       ");
+    for (uBin = 0; uBin < IRQ_PROFILER_BINS; uBin++)
+    {
+        if (pxStat->uBins[uBin] == 0)
+        {
+            continue;
+        }
+        if (uBin == 0)
+        {
+            FreeRTOS_CLIPrintf(pxSink, " 0:%lu", pxStat->uBins[uBin]);
+        }
+        else if (uBin == IRQ_PROFILER_BINS - 1)
+        {
+            FreeRTOS_CLIPrintf(pxSink, " %lu+:%lu", 1UL << (uBin - 1), pxStat->uBins[uBin]);
+        }
+        else
+        {
+            FreeRTOS_CLIPrintf(pxSink, " %lu-%lu:%lu", 1UL << (uBin - 1), (1UL << uBin) - 1,
+                               pxStat->uBins[uBin]);
+        }
+    }
+    FreeRTOS_CLIPut(pxSink, "\n");
 }
 
 /**
-* @brief Task to handle user commands via serial communication.
-* @param *pvParams Data passed at task creation.
-* @retval void
+* @brief Command that shows or clears the interrupt profiles.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
 */
-void vTaskConsole(void *pvParams)
+static BaseType_t prvCommandIrq(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
 {
-    char cReadCh = '\0';
-    uint8_t uInputIndex = 0;
-    BaseType_t xMoreDataToProcess;
-    char pcInputString[MAX_IN_STR_LEN];
-    char pcPrevInputString[MAX_IN_STR_LEN];
-    char pcOutputString[MAX_OUT_STR_LEN];
+    IrqProfile_t *pxProfile;
+    uint8_t uId;
 
-    memset(pcInputString, 0x00, MAX_IN_STR_LEN);
-    memset(pcPrevInputString, 0x00, MAX_IN_STR_LEN);
-    memset(pcOutputString, 0x00, MAX_OUT_STR_LEN);
+    /* Value is the position in "show|reset" */
+    if (pxArgs->ulValue[0] == 1)
+    {
+        vIrqProfilerReset();
+        FreeRTOS_CLIPut(pxSink, "Interrupt profiles cleared\n");
+        return pdPASS;
+    }
 
-    /* Create a queue to store characters from RX ISR */
-    xQueueRxHandle = xQueueCreate(MAX_RX_QUEUE_LEN, sizeof(char));
-    if (xQueueRxHandle == NULL)
+    pxProfile = FreeRTOS_CLIArenaAlloc(pxArgs, sizeof(IrqProfile_t));
+    if (pxProfile == NULL)
     {
-        goto out_task_console;
+        FreeRTOS_CLIPut(pxSink, prvpcNoArenaMsg);
+        return pdFAIL;
     }
 
-    vConsoleWrite(pcWelcomeMsg);
-    vConsoleEnableRxInterrupt();
-    vConsoleWrite(prvpcPrompt);
+    FreeRTOS_CLIPrintf(pxSink, "IRQ     Event         Count       Min       Max       Avg  (CPU cycles, %lu per us)\n",
+                       SystemCoreClock / 1000000);
+    for (uId = 0; uId < IRQ_PROFILE_COUNT; uId++)
+    {
+        /* Copied one interrupt at a time, interrupts are masked while copying */
+        vIrqProfilerRead((IrqProfileId_e)uId, pxProfile);
+        prvPrintIrqStat(pxSink, pcIrqProfilerName((IrqProfileId_e)uId), "latency", &pxProfile->xLatency);
+        prvPrintIrqStat(pxSink, pcIrqProfilerName((IrqProfileId_e)uId), "duration", &pxProfile->xDuration);
+    }
 
-    while(1)
+    return pdPASS;
+}
+#endif
+
+#if (TRACE_RECORDER_EN == 1)
+/**
+* @brief Command that starts, stops and streams the kernel event trace.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandTrace(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    BaseType_t xReturn;
+
+    /* Value is the position in "start|stop|dump" */
+    switch (pxArgs->ulValue[0])
     {
-        /* Block until there is a new character in RX buffer */
-        xConsoleRead((uint8_t*)(&cReadCh), sizeof(cReadCh));
+        case 0:
+            vTraceStart();
+            FreeRTOS_CLIPrintf(pxSink, "Trace started, %u events kept\n", (unsigned)TRACE_BUFFER_EVENTS);
+            return pdPASS;
+        case 1:
+            vTraceStop();
+            FreeRTOS_CLIPrintf(pxSink, "Trace stopped, %lu events\n", uTraceGetEventCount());
+            return pdPASS;
+        default:
+            break;
+    }
 
-        switch (cReadCh)
-        {
+    /* The binary stream starts after this line and ends with a line feed */
+    FreeRTOS_CLIPrintf(pxSink, "Trace dump, %lu events\n", uTraceGetEventCount());
+    FreeRTOS_CLIFlush(pxSink);
+    xReturn = xTraceStream(pxSink);
+    FreeRTOS_CLIPut(pxSink, "\n");
+
+    return xReturn;
+}
+#endif
+
+#if (STACK_PROFILER_EN == 1)
+/**
+* @brief Command that shows the peak stack use of each task and of the main
+*        stack, with the recommended sizes.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandStack(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    StackProfile_t *pxProfiles;
+    UBaseType_t uxCount;
+    UBaseType_t uxIndex;
+    uint32_t uRecommended;
+    uint32_t uSize;
+    uint32_t uPeak;
+    uint32_t uSaving = 0;
+
+    pxProfiles = FreeRTOS_CLIArenaAlloc(pxArgs, STACK_PROFILER_MAX_TASKS * sizeof(StackProfile_t));
+    if (pxProfiles == NULL)
+    {
+        FreeRTOS_CLIPut(pxSink, prvpcNoArenaMsg);
+        return pdFAIL;
+    }
+    uxCount = uxStackProfilerRead(pxProfiles, STACK_PROFILER_MAX_TASKS);
+
+    FreeRTOS_CLIPut(pxSink, "Task          Size   Peak   Use  Recommended  Peak during\n"
+                            "==========  ======  =====  ====  ===========  ===========\n");
+    for (uxIndex = 0; uxIndex < uxCount; uxIndex++)
+    {
+        uRecommended = uStackProfilerRecommend(pxProfiles[uxIndex].uPeak);
+        FreeRTOS_CLIPrintf(pxSink, "%-10s  %6lu  %5lu  %3lu%%  %11lu  %s%s\n",
+                           pxProfiles[uxIndex].cName,
+                           pxProfiles[uxIndex].uSize,
+                           pxProfiles[uxIndex].uPeak,
+                           pxProfiles[uxIndex].uPeak * 100 / pxProfiles[uxIndex].uSize,
+                           uRecommended,
+                           (pxProfiles[uxIndex].cPeakLabel[0] != '\0') ? pxProfiles[uxIndex].cPeakLabel : "-",
+                           (pxProfiles[uxIndex].xDeleted == pdTRUE) ? " (deleted)" : "");
+        /* Deleted tasks no longer hold their stack */
+        if (pxProfiles[uxIndex].xDeleted == pdFALSE && uRecommended < pxProfiles[uxIndex].uSize)
+        {
+            uSaving += pxProfiles[uxIndex].uSize - uRecommended;
+        }
+    }
+
+    vStackProfilerMainStack(&uSize, &uPeak);
+    uRecommended = uStackProfilerRecommend(uPeak);
+    FreeRTOS_CLIPrintf(pxSink, "%-10s  %6lu  %5lu  %3lu%%  %11lu  %s\n", "main/ISR", uSize, uPeak,
+                       uPeak * 100 / uSize, uRecommended,
+                       (uPeak >= uSize) ? "full, may have overflowed" : "-");
+
+    FreeRTOS_CLIPrintf(pxSink, "\nSizes in words. Recommended: peak + %u%%, at least %u words.\n"
+                               "Task stacks could give back %lu bytes.\n",
+                       (unsigned)STACK_PROFILER_MARGIN_PCT, (unsigned)STACK_PROFILER_MIN_MARGIN,
+                       uSaving * sizeof(StackType_t));
+
+    return pdPASS;
+}
+#endif
+
+#if (QUEUE_STATS_EN == 1)
+/**
+* @brief Map a queue type to its name.
+* @param ucQueueType One of the queueQUEUE_TYPE_ values.
+* @retval Name of the type.
+*/
+static const char *prvpcMapQueueType(uint8_t ucQueueType)
+{
+    switch (ucQueueType)
+    {
+        case             queueQUEUE_TYPE_MUTEX: return "mutex";
+        case   queueQUEUE_TYPE_RECURSIVE_MUTEX: return "rmutex";
+        case  queueQUEUE_TYPE_BINARY_SEMAPHORE: return "binary";
+        case queueQUEUE_TYPE_COUNTING_SEMAPHORE: return "count";
+        default: return "queue";
+    }
+}
+
+/**
+* @brief Command that shows or clears the contention statistics of the
+*        queues, semaphores and mutexes in the queue registry.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandQueues(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    QueueRegistryStats_t *pxStats;
+    QueueRegistryStats_t *pxEntry;
+    UBaseType_t uxCount;
+    UBaseType_t uxIndex;
+    BaseType_t xIsMutex;
+    uint64_t uMaxUs;
+
+    /* Value is the position in "show|reset" */
+    if (pxArgs->ulValue[0] == 1)
+    {
+        vQueueResetRegistryStats();
+        FreeRTOS_CLIPut(pxSink, "Queue statistics cleared\n");
+        return pdPASS;
+    }
+
+    pxStats = FreeRTOS_CLIArenaAlloc(pxArgs, configQUEUE_REGISTRY_SIZE * sizeof(QueueRegistryStats_t));
+    if (pxStats == NULL)
+    {
+        FreeRTOS_CLIPut(pxSink, prvpcNoArenaMsg);
+        return pdFAIL;
+    }
+    uxCount = uxQueueGetRegistryStats(pxStats, configQUEUE_REGISTRY_SIZE);
+
+    FreeRTOS_CLIPut(pxSink, "Name        Type     Items   Peak  Send blk  Recv blk  Send fail  Recv tmo  Inherit  Blocked ms  Max blk us\n"
+                            "==========  ======  =======  ====  ========  ========  =========  ========  =======  ==========  ==========\n");
+    for (uxIndex = 0; uxIndex < uxCount; uxIndex++)
+    {
+        pxEntry = &pxStats[uxIndex];
+        xIsMutex = (pxEntry->ucQueueType == queueQUEUE_TYPE_MUTEX ||
+                    pxEntry->ucQueueType == queueQUEUE_TYPE_RECURSIVE_MUTEX) ? pdTRUE : pdFALSE;
+        uMaxUs = RUN_TIME_COUNTER_TO_US((uint64_t)pxEntry->xStats.ulMaxBlockedTime);
+
+        FreeRTOS_CLIPrintf(pxSink, "%-10.10s  %-6s  ", pxEntry->pcQueueName, prvpcMapQueueType(pxEntry->ucQueueType));
+        /* A mutex holds one item while it is free, its fill level means nothing */
+        if (xIsMutex == pdTRUE)
+        {
+            FreeRTOS_CLIPrintf(pxSink, "%7s  %4s", "-", "-");
+        }
+        else
+        {
+            FreeRTOS_CLIPrintf(pxSink, "%3lu/%-3lu  %4lu", (uint32_t)pxEntry->uxMessagesWaiting,
+                               (uint32_t)pxEntry->uxLength, (uint32_t)pxEntry->xStats.uxPeakMessagesWaiting);
+        }
+        FreeRTOS_CLIPrintf(pxSink, "  %8lu  %8lu  %9lu  %8lu  %7lu  %10lu  %10lu\n",
+                           pxEntry->xStats.ulSendBlocks, pxEntry->xStats.ulReceiveBlocks,
+                           pxEntry->xStats.ulSendFails, pxEntry->xStats.ulReceiveTimeouts,
+                           pxEntry->xStats.ulInheritances,
+                           (uint32_t)(RUN_TIME_COUNTER_TO_US((uint64_t)pxEntry->xStats.ulBlockedTime) / 1000),
+                           (uMaxUs > UINT32_MAX) ? UINT32_MAX : (uint32_t)uMaxUs);
+    }
+
+    return pdPASS;
+}
+#endif
+
+#if (CLI_PERF_EN == 1)
+/**
+* @brief Print the minimum, average and maximum of a command phase in us.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pcPhase Phase name.
+* @param *pxStat Phase timings, in run time counter ticks.
+* @param uCount Number of executions of the command.
+* @retval void
+*/
+static void prvPrintPerfStat(CLI_Output_Sink_t *pxSink, const char *pcPhase, const CLI_Perf_Stat_t *pxStat,
+                             uint32_t uCount)
+{
+    /* Tenths of us, the DWT clock resolves well below 1us */
+    uint32_t uMin = (uint32_t)RUN_TIME_COUNTER_TO_US((uint64_t)pxStat->ulMin * 10);
+    uint32_t uAvg = (uint32_t)RUN_TIME_COUNTER_TO_US(pxStat->ullSum * 10 / uCount);
+    uint32_t uMax = (uint32_t)RUN_TIME_COUNTER_TO_US((uint64_t)pxStat->ulMax * 10);
+
+    FreeRTOS_CLIPrintf(pxSink, "%-7s  %8lu.%lu  %8lu.%lu  %8lu.%lu\n", pcPhase,
+                       uMin / 10, uMin % 10, uAvg / 10, uAvg % 10, uMax / 10, uMax % 10);
+}
+
+/**
+* @brief Command that shows or clears the timings of each command.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandPerf(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    static const char *pcPhaseNames[eCLIPhaseCount] = { "lookup", "parse", "handler", "output" };
+    CLI_Command_Perf_t *pxPerf;
+    const char *pcCommand;
+    UBaseType_t uxIndex;
+    uint8_t uPhase;
+    uint8_t uBin;
+
+    /* Value is the position in "show|reset" */
+    if (pxArgs->ulValue[0] == 1)
+    {
+        FreeRTOS_CLIResetCommandPerf();
+        FreeRTOS_CLIPut(pxSink, "Command timings cleared\n");
+        return pdPASS;
+    }
+
+    pxPerf = FreeRTOS_CLIArenaAlloc(pxArgs, sizeof(CLI_Command_Perf_t));
+    if (pxPerf == NULL)
+    {
+        FreeRTOS_CLIPut(pxSink, prvpcNoArenaMsg);
+        return pdFAIL;
+    }
+
+    FreeRTOS_CLIPut(pxSink, "Command     Count  Phase        Min us      Avg us      Max us\n"
+                            "==========  =====  =======  ==========  ==========  ==========\n");
+    for (uxIndex = 0; FreeRTOS_CLIGetCommandPerf(uxIndex, &pcCommand, pxPerf) == pdPASS; uxIndex++)
+    {
+        if (pxPerf->ulCount == 0)
+        {
+            continue;
+        }
+
+        FreeRTOS_CLIPrintf(pxSink, "%-10.10s  %5lu  ", pcCommand, pxPerf->ulCount);
+        for (uPhase = 0; uPhase < eCLIPhaseCount; uPhase++)
+        {
+            if (uPhase != 0)
+            {
+                FreeRTOS_CLIPut(pxSink, "                   ");
+            }
+            prvPrintPerfStat(pxSink, pcPhaseNames[uPhase], &pxPerf->xPhase[uPhase], pxPerf->ulCount);
+        }
+        FreeRTOS_CLIPut(pxSink, "                   ");
+        prvPrintPerfStat(pxSink, "total", &pxPerf->xTotal, pxPerf->ulCount);
+
+        /* Bin 0 counts totals below 1us, bin n counts 2^(n-1) to 2^n - 1 us */
+        FreeRTOS_CLIPut(pxSink, "                   us:");
+        for (uBin = 0; uBin < CLI_PERF_BINS; uBin++)
+        {
+            if (pxPerf->ulBins[uBin] == 0)
+            {
+                continue;
+            }
+            if (uBin == 0)
+            {
+                FreeRTOS_CLIPrintf(pxSink, " 0:%lu", pxPerf->ulBins[uBin]);
+            }
+            else if (uBin == CLI_PERF_BINS - 1)
+            {
+                FreeRTOS_CLIPrintf(pxSink, " %lu+:%lu", 1UL << (uBin - 1), pxPerf->ulBins[uBin]);
+            }
+            else
+            {
+                FreeRTOS_CLIPrintf(pxSink, " %lu-%lu:%lu", 1UL << (uBin - 1), (1UL << uBin) - 1,
+                                   pxPerf->ulBins[uBin]);
+            }
+        }
+        FreeRTOS_CLIPut(pxSink, "\n");
+    }
+
+    return pdPASS;
+}
+#endif
+
+/**
+* @brief Command that shows the peak scratch memory used by each command.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandArena(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    const char *pcCommand;
+    size_t xPeak;
+    size_t xMaxPeak = 0;
+    UBaseType_t uxIndex;
+
+    FreeRTOS_CLIPut(pxSink, "Command     Peak bytes\n");
+    for (uxIndex = 0; FreeRTOS_CLIGetArenaPeak(uxIndex, &pcCommand, &xPeak) == pdPASS; uxIndex++)
+    {
+        if (xPeak == 0)
+        {
+            continue;
+        }
+
+        FreeRTOS_CLIPrintf(pxSink, "%-10.10s  %10lu\n", pcCommand, (uint32_t)xPeak);
+        if (xPeak > xMaxPeak)
+        {
+            xMaxPeak = xPeak;
+        }
+    }
+    FreeRTOS_CLIPrintf(pxSink, "Arena size  %10lu bytes, %lu bytes never used\n",
+                       (uint32_t)configCOMMAND_INT_ARENA_SIZE,
+                       (uint32_t)(configCOMMAND_INT_ARENA_SIZE - xMaxPeak));
+
+    return pdPASS;
+}
+
+/**
+* @brief Print one region of the RAM map.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pcName Region name, indented under the region that holds it.
+* @param uStart First address of the region.
+* @param uSize Region size in bytes.
+* @param lUsed Bytes in use, the peak for stacks, -1 when not known.
+* @retval void
+*/
+static void prvPrintMemRegion(CLI_Output_Sink_t *pxSink, const char *pcName, uint32_t uStart, uint32_t uSize,
+                              int32_t lUsed)
+{
+    FreeRTOS_CLIPrintf(pxSink, "%-20s  0x%08lx  0x%08lx  %6lu", pcName, uStart, uStart + uSize, uSize);
+    if (lUsed < 0)
+    {
+        FreeRTOS_CLIPut(pxSink, "       -\n");
+    }
+    else
+    {
+        FreeRTOS_CLIPrintf(pxSink, "  %6lu\n", (uint32_t)lUsed);
+    }
+}
+
+/**
+* @brief Command that prints the RAM map from the linker script symbols, the
+*        heap bounds and the stack of every task.
+* @param *pxSink FreeRTOS CLI output sink.
+* @param *pxArgs Tokenised command line and parsed parameters.
+* @retval pdPASS if the command succeeded, otherwise pdFAIL.
+*/
+static BaseType_t prvCommandMem(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    const TaskSnapshot_t *pxSnapshot;
+    const TaskStatus_t *pxTask;
+    UBaseType_t uxIndex;
+    char cName[12 + configMAX_TASK_NAME_LEN];
+    uint32_t uStackStart;
+    uint32_t uStackSize;
+    uint32_t uMainStackStart = (uint32_t)&_estack - (uint32_t)&_Min_Stack_Size;
+    int32_t lMainStackUsed = -1;
+#if (STACK_PROFILER_EN == 1)
+    uint32_t uSize;
+    uint32_t uPeak;
+
+    vStackProfilerMainStack(&uSize, &uPeak);
+    lMainStackUsed = (int32_t)(uPeak * sizeof(uint32_t));
+#endif
+
+    FreeRTOS_CLIPut(pxSink, "Region                Start       End           Size    Used\n");
+    prvPrintMemRegion(pxSink, ".data", (uint32_t)&_sdata, (uint32_t)&_edata - (uint32_t)&_sdata, -1);
+    prvPrintMemRegion(pxSink, ".bss", (uint32_t)&_sbss, (uint32_t)&_ebss - (uint32_t)&_sbss, -1);
+#if (STATIC_ALLOCATION_EN == 0)
+    prvPrintMemRegion(pxSink, "  kernel heap", (uint32_t)ucHeap, configTOTAL_HEAP_SIZE,
+                      (int32_t)(configTOTAL_HEAP_SIZE - xPortGetFreeHeapSize()));
+#endif
+
+    /* Stacks come from the heap or, with static allocation, from .bss */
+    (void)xTaskSnapshotRefresh(pdTRUE);
+    pxSnapshot = pxTaskSnapshotAcquire();
+    for (uxIndex = 0; uxIndex < pxSnapshot->uxCount; uxIndex++)
+    {
+        pxTask = &pxSnapshot->xTasks[uxIndex];
+        uStackStart = (uint32_t)pxTask->pxStackBase;
+        uStackSize = (uint32_t)(pxTask->pxEndOfStack - pxTask->pxStackBase + 1) * sizeof(StackType_t);
+#if (STATIC_ALLOCATION_EN == 0)
+        if (uStackStart - (uint32_t)ucHeap < configTOTAL_HEAP_SIZE)
+        {
+            snprintf(cName, sizeof(cName), "    stack %s", pxTask->pcTaskName);
+        }
+        else
+#endif
+        {
+            snprintf(cName, sizeof(cName), "  stack %s", pxTask->pcTaskName);
+        }
+        /* A snapshot of the sampler has no high water marks, the use is not shown */
+        prvPrintMemRegion(pxSink, cName, uStackStart, uStackSize,
+                          (pxSnapshot->xFreeStackSpace == pdTRUE) ?
+                          (int32_t)(uStackSize - pxTask->usStackHighWaterMark * sizeof(StackType_t)) : -1);
+    }
+    if (pxSnapshot->uxMissed != 0)
+    {
+        FreeRTOS_CLIPrintf(pxSink, "%lu tasks not shown, increase TASK_SNAPSHOT_MAX_TASKS\n",
+                           pxSnapshot->uxMissed);
+    }
+    vTaskSnapshotRelease(pxSnapshot);
+
+    prvPrintMemRegion(pxSink, "  CLI buffers", (uint32_t)FreeRTOS_CLIGetIOBuffers(), sizeof(CLI_IO_Buffers_t), -1);
+    prvPrintMemRegion(pxSink, "sbrk heap", (uint32_t)&_end, uMainStackStart - (uint32_t)&_end, -1);
+    prvPrintMemRegion(pxSink, "main stack", uMainStackStart, (uint32_t)&_Min_Stack_Size, lMainStackUsed);
+    prvPrintMemRegion(pxSink, "RAM", (uint32_t)&_sdata, (uint32_t)&_estack - (uint32_t)&_sdata, -1);
+
+    return pdPASS;
+}
+
+#if (CONSOLE_RX_DMA_EN == 1)
+/**
+* @brief Reads from the RX DMA circular buffer. Reads one byte at the time.
+* @param *cReadChar pointer to where data will be stored.
+* @param xTicksToWait Maximum time to wait for a byte.
+* @retval FreeRTOS status
+*/
+static BaseType_t xConsoleRead(uint8_t *cReadChar, size_t xLen, TickType_t xTicksToWait)
+{
+    TickType_t xWait;
+
+    if (cReadChar == NULL)
+    {
+        return pdFALSE;
+    }
+
+    /* Block until there are unread bytes. The positions alone cannot tell an
+    *  empty buffer from one with RX_DMA_BUF_LEN unread bytes.
+    */
+    while (xConsoleStats.uRxBytes == uRxBytesConsumed)
+    {
+        /* A UART error aborted reception, everything it received has been read */
+        if (xRxRestartPending == pdTRUE)
+        {
+            uRxBytesConsumed = xConsoleStats.uRxBytes;
+            (void)xConsoleEnableRxInterrupt();
+        }
+
+        /* Nothing notifies a failed restart, it is tried again periodically */
+        xWait = xTicksToWait;
+        if (xRxRestartPending == pdTRUE && xWait > pdMS_TO_TICKS(RX_RESTART_RETRY_MS))
+        {
+            xWait = pdMS_TO_TICKS(RX_RESTART_RETRY_MS);
+        }
+        if (ulTaskNotifyTake(pdTRUE, xWait) == 0)
+        {
+            if (xWait == xTicksToWait)
+            {
+                return pdFALSE;
+            }
+            if (xTicksToWait != portMAX_DELAY)
+            {
+                xTicksToWait -= xWait;
+            }
+        }
+    }
+
+    /* The DMA wrapped around the unread data, resynchronize to the newest byte */
+    if (xConsoleStats.uRxBytes - uRxBytesConsumed > RX_DMA_BUF_LEN)
+    {
+        xConsoleStats.uRxDropped += xConsoleStats.uRxBytes - uRxBytesConsumed;
+        uRxBytesConsumed = xConsoleStats.uRxBytes;
+        usRxDmaTail = usRxDmaHead;
+        return pdFALSE;
+    }
+
+    *cReadChar = ucRxDmaBuf[usRxDmaTail];
+    usRxDmaTail = (usRxDmaTail + 1) % RX_DMA_BUF_LEN;
+    uRxBytesConsumed++;
+
+    return pdTRUE;
+}
+#else
+/**
+* @brief Reads from UART RX buffer. Reads one bye at the time.
+* @param *cReadChar pointer to where data will be stored.
+* @param xTicksToWait Maximum time to wait for a byte.
+* @retval FreeRTOS status
+*/
+static BaseType_t xConsoleRead(uint8_t *cReadChar, size_t xLen, TickType_t xTicksToWait)
+{
+    BaseType_t xRetVal = pdFALSE;
+
+    if (xQueueRxHandle == NULL || cReadChar == NULL)
+    {
+        return xRetVal;
+    }
+
+    /* Block until the there is input from the user */
+    return xQueueReceive(xQueueRxHandle, cReadChar, xTicksToWait);
+}
+#endif
+
+#if (CONSOLE_TX_DMA_EN == 1)
+/**
+* @brief Starts a DMA transfer with all contiguous data pending in the TX ring.
+*        A span the DMA refuses with an error is dropped, no TX complete
+*        interrupt would ever release it. A span refused because the handle
+*        is busy stays queued, prvConsoleTxWait() starts it again.
+* @note Must be called from the TX complete interrupt or within a critical section.
+* @param void
+* @retval void
+*/
+static void prvConsoleTxKick(void)
+{
+    uint16_t usLen;
+    HAL_StatusTypeDef xStatus;
+
+    while (usTxDmaLen == 0 && usTxHead != usTxTail)
+    {
+        /* Everything queued since the last transfer goes in one shot, up to the wrap */
+        usLen = (usTxHead > usTxTail) ? (usTxHead - usTxTail) : (TX_RING_BUF_LEN - usTxTail);
+        usTxDmaLen = usLen;
+        xStatus = HAL_UART_Transmit_DMA(pxUartDevHandle, &ucTxRingBuf[usTxTail], usLen);
+        if (xStatus == HAL_OK)
+        {
+            xConsoleStats.uTxDmaTransfers++;
+        }
+        else if (xStatus == HAL_BUSY)
+        {
+            usTxDmaLen = 0;
+            break;
+        }
+        else
+        {
+            xConsoleStats.uTxErrors++;
+            usTxTail = (usTxTail + usLen) % TX_RING_BUF_LEN;
+            usTxDmaLen = 0;
+        }
+    }
+}
+
+/**
+* @brief Wait for the DMA to release TX ring space.
+* @note Called with xConsoleTxMutex held and xTxWaitingTask set to this task.
+* @param void
+* @retval pdTRUE if the DMA made progress, pdFALSE if it is stuck.
+*/
+static BaseType_t prvConsoleTxWait(void)
+{
+    uint16_t usTail = usTxTail;
+    BaseType_t xReturn = pdTRUE;
+
+    /* Nothing in flight, the span was refused by a busy handle and no TX
+    *  complete interrupt will come. Start it again a tick later.
+    */
+    if (usTxDmaLen == 0)
+    {
+        vTaskDelay(1);
+        taskENTER_CRITICAL();
+        xTxWaitingTask = NULL;
+        prvConsoleTxKick();
+        xReturn = (usTxDmaLen != 0 || usTxHead == usTxTail) ? pdTRUE : pdFALSE;
+        taskEXIT_CRITICAL();
+        return xReturn;
+    }
+
+    if (ulTaskNotifyTakeIndexed(TX_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(TX_WAIT_TIMEOUT_MS)) != 0 ||
+        usTxTail != usTail)
+    {
+        return pdTRUE;
+    }
+
+    /* No transfer completed for twice the time the whole ring takes, the
+    *  stuck one is aborted and dropped so later writes go out again.
+    */
+    if (usTxDmaLen != 0)
+    {
+        HAL_UART_AbortTransmit(pxUartDevHandle);
+    }
+    taskENTER_CRITICAL();
+    xTxWaitingTask = NULL;
+    if (usTxTail == usTail && usTxDmaLen != 0)
+    {
+        usTxTail = (usTxTail + usTxDmaLen) % TX_RING_BUF_LEN;
+        usTxDmaLen = 0;
+        xConsoleStats.uTxErrors++;
+        xReturn = pdFALSE;
+        prvConsoleTxKick();
+    }
+    taskEXIT_CRITICAL();
+
+    return xReturn;
+}
+
+/**
+* @brief Queue data into the TX ring buffer. Blocks only when the ring is full.
+* @note Called with xConsoleTxMutex held, so only one task moves the head.
+* @param *pcBuff buffer to be written.
+* @param xLen number of bytes to be written.
+* @retval HAL status
+*/
+static HAL_StatusTypeDef prvConsoleWriteRaw(const char *pcBuff, size_t xLen)
+{
+    size_t xFree;
+    size_t xChunk;
+    size_t xFirstPart;
+    uint16_t usHead;
+
+    if (pxUartDevHandle == NULL || pcBuff == NULL)
+    {
+        return HAL_ERROR;
+    }
+
+    while (xLen > 0)
+    {
+        taskENTER_CRITICAL();
+        xFree = (TX_RING_BUF_LEN - 1) - ((usTxHead + TX_RING_BUF_LEN - usTxTail) % TX_RING_BUF_LEN);
+        if (xFree == 0)
+        {
+            xTxWaitingTask = xTaskGetCurrentTaskHandle();
+        }
+        taskEXIT_CRITICAL();
+
+        /* Ring is full, wait for the DMA to release some space */
+        if (xFree == 0)
+        {
+            xConsoleStats.uTxStalls++;
+            if (prvConsoleTxWait() != pdTRUE)
+            {
+                return HAL_TIMEOUT;
+            }
+            continue;
+        }
+
+        /* Only this task moves the head, copy outside of the critical section */
+        xChunk = (xLen < xFree) ? xLen : xFree;
+        usHead = usTxHead;
+        xFirstPart = TX_RING_BUF_LEN - usHead;
+        if (xFirstPart > xChunk)
+        {
+            xFirstPart = xChunk;
+        }
+        memcpy(&ucTxRingBuf[usHead], pcBuff, xFirstPart);
+        memcpy(&ucTxRingBuf[0], pcBuff + xFirstPart, xChunk - xFirstPart);
+
+        taskENTER_CRITICAL();
+        usTxHead = (usHead + xChunk) % TX_RING_BUF_LEN;
+        xConsoleStats.uTxBytesQueued += xChunk;
+        prvConsoleTxKick();
+        taskEXIT_CRITICAL();
+
+        pcBuff += xChunk;
+        xLen -= xChunk;
+    }
+
+    return HAL_OK;
+}
+#else
+/**
+* @brief Write to UART TX in polling mode.
+* @param *pcBuff buffer to be written.
+* @param xLen number of bytes to be written.
+* @retval HAL status
+*/
+static HAL_StatusTypeDef prvConsoleWriteRaw(const char *pcBuff, size_t xLen)
+{
+    if (pxUartDevHandle == NULL || pcBuff == NULL)
+    {
+        return HAL_ERROR;
+    }
+
+    xConsoleStats.uTxBytesQueued += xLen;
+    return HAL_UART_Transmit(pxUartDevHandle, (uint8_t *)pcBuff, xLen, portMAX_DELAY);
+}
+#endif
+
+/**
+* @brief Write data to UART TX. Tasks writing at the same time are serialized,
+*        so every chunk reaches the UART in one piece.
+* @param *pcBuff buffer to be written.
+* @param xLen number of bytes to be written.
+* @retval HAL status
+*/
+static HAL_StatusTypeDef vConsoleWriteLen(const char *pcBuff, size_t xLen)
+{
+    HAL_StatusTypeDef halStatus;
+
+    xSemaphoreTake(xConsoleTxMutex, portMAX_DELAY);
+    halStatus = prvConsoleWriteRaw(pcBuff, xLen);
+    xSemaphoreGive(xConsoleTxMutex);
+
+    return halStatus;
+}
+
+/**
+* @brief Write a string to UART TX
+* @param *buff buffer to be written.
+* @retval HAL status
+*/
+static HAL_StatusTypeDef vConsoleWrite(const char *buff)
+{
+    size_t len;
+
+    if (buff == NULL || *buff == '\0')
+    {
+        return HAL_ERROR;
+    }
+
+    len = strlen(buff);
+    return vConsoleWriteLen(buff, len);
+}
+
+#if (CONSOLE_TX_DMA_EN == 1)
+/**
+* @brief Wait until everything queued in the TX ring has been transmitted,
+*        or until the DMA stops making progress.
+* @param void
+* @retval void
+*/
+static void vConsoleFlush(void)
+{
+    BaseType_t xPending;
+
+    /* Holding the mutex keeps xTxWaitingTask for this task only */
+    xSemaphoreTake(xConsoleTxMutex, portMAX_DELAY);
+    do
+    {
+        taskENTER_CRITICAL();
+        xPending = (usTxHead != usTxTail || usTxDmaLen != 0);
+        if (xPending)
+        {
+            xTxWaitingTask = xTaskGetCurrentTaskHandle();
+        }
+        taskEXIT_CRITICAL();
+
+        if (xPending && prvConsoleTxWait() != pdTRUE)
+        {
+            break;
+        }
+    } while (xPending);
+    xSemaphoreGive(xConsoleTxMutex);
+}
+#else
+/**
+* @brief Polling writes return once the data is sent, nothing to wait for.
+* @param void
+* @retval void
+*/
+static void vConsoleFlush(void)
+{
+}
+#endif
+
+/**
+* @brief CLI sink put function, command output goes straight to UART TX.
+* @param *pvContext Not used.
+* @param *pcData Data to be written.
+* @param xDataLength Number of bytes to be written.
+* @retval pdPASS if data was written, otherwise pdFAIL.
+*/
+static BaseType_t prvConsoleSinkPut(void *pvContext, const char *pcData, size_t xDataLength)
+{
+    (void)pvContext;
+    return (vConsoleWriteLen(pcData, xDataLength) == HAL_OK) ? pdPASS : pdFAIL;
+}
+
+/**
+* @brief CLI sink flush function.
+* @param *pvContext Not used.
+* @retval void
+*/
+static void prvConsoleSinkFlush(void *pvContext)
+{
+    (void)pvContext;
+    vConsoleFlush();
+}
+
+static CLI_Output_Sink_t xConsoleSink =
+{
+    prvConsoleSinkPut,
+    prvConsoleSinkFlush,
+    NULL
+};
+
+/**
+* @brief Get the console output sink, other tasks can use it to run their own
+*        CLI session on the console UART.
+* @param void
+* @retval Console output sink.
+*/
+CLI_Output_Sink_t *pxConsoleGetSink(void)
+{
+    return &xConsoleSink;
+}
+
+/**
+* @brief Enables UART RX reception. In DMA mode a failed start is left
+*        pending, xConsoleRead() tries again.
+* @param void
+* @retval HAL status
+*/
+HAL_StatusTypeDef xConsoleEnableRxInterrupt(void)
+{
+    HAL_StatusTypeDef xStatus;
+
+    if (pxUartDevHandle == NULL)
+    {
+        return HAL_ERROR;
+    }
+#if (CONSOLE_RX_DMA_EN == 1)
+    /* DMA fills the circular buffer, idle line and half/full transfer events
+    *  report the write position.
+    */
+    usRxDmaHead = 0;
+    usRxDmaTail = 0;
+    /* Called from the console task only. HAL locks the handle while it
+    *  starts reception, a TX complete interrupt would find it busy.
+    */
+    taskENTER_CRITICAL();
+    xStatus = HAL_UARTEx_ReceiveToIdle_DMA(pxUartDevHandle, ucRxDmaBuf, RX_DMA_BUF_LEN);
+    xRxRestartPending = (xStatus == HAL_OK) ? pdFALSE : pdTRUE;
+
+    /* Noise/framing errors would abort the DMA stream, just keep receiving */
+    __HAL_UART_DISABLE_IT(pxUartDevHandle, UART_IT_PE);
+    __HAL_UART_DISABLE_IT(pxUartDevHandle, UART_IT_ERR);
+    taskEXIT_CRITICAL();
+#else
+    /* UART Rx IT is enabled by reading a character */
+    xStatus = HAL_UART_Receive_IT(pxUartDevHandle,(uint8_t*)&cRxData, 1);
+#endif
+    if (xStatus != HAL_OK)
+    {
+        xConsoleStats.uRxStartFails++;
+    }
+
+    return xStatus;
+}
+
+/**
+* @brief Execute the ';' separated commands of a line one after the other,
+*        each command output is streamed as soon as the command finishes.
+* @param *pxSession CLI session the commands run in.
+* @param *pcLine Command line, separators are replaced by NULL characters.
+* @retval void
+*/
+static void prvExecuteBatch(CLI_Session_t *pxSession, char *pcLine)
+{
+    char *pcCommand = pcLine;
+    char *pcEnd;
+    BaseType_t xLast = pdFALSE;
+    BaseType_t xResult;
+    uint8_t uCommandNumber = 0;
+
+    while (xLast == pdFALSE)
+    {
+        pcEnd = strchr(pcCommand, BATCH_SEPARATOR);
+        if (pcEnd == NULL)
+        {
+            xLast = pdTRUE;
+        }
+        else
+        {
+            *pcEnd = '\0';
+        }
+
+        /* Skip empty commands, e.g. a trailing separator */
+        while (*pcCommand == ' ')
+        {
+            pcCommand++;
+        }
+
+        if (*pcCommand != '\0')
+        {
+            uCommandNumber++;
+            xResult = FreeRTOS_CLISessionExecute(pxSession, pcCommand);
+#if (STACK_PROFILER_EN == 1)
+            /* A new peak of the console stack is put down to this command */
+            vStackProfilerMark(pcCommand);
+#endif
+            if (xResult != pdPASS && xBatchStopOnError == pdTRUE && xLast == pdFALSE)
+            {
+                FreeRTOS_CLIPrintf(&xConsoleSink, "Batch stopped at command %d\n", uCommandNumber);
+                FreeRTOS_CLIFlush(&xConsoleSink);
+                break;
+            }
+        }
+
+        if (xLast == pdFALSE)
+        {
+            pcCommand = pcEnd + 1;
+        }
+    }
+}
+
+/**
+* @brief Task to handle user commands via serial communication.
+* @param *pvParams Data passed at task creation.
+* @retval void
+*/
+void vTaskConsole(void *pvParams)
+{
+    char cReadCh = '\0';
+    size_t xInputIndex = 0;
+    /* The line buffers are part of the CLI I/O buffers, not of this stack */
+    char *pcInputString = FreeRTOS_CLIGetIOBuffers()->cInput;
+    char *pcPrevInputString = FreeRTOS_CLIGetIOBuffers()->cHistory;
+    CLI_Session_t xSession;
+#if (CONSOLE_BINARY_EN == 1)
+    BaseType_t xBinaryMode = pdFALSE;
+#endif
+
+    memset(pcInputString, 0x00, configCOMMAND_INT_MAX_INPUT_SIZE);
+    memset(pcPrevInputString, 0x00, configCOMMAND_INT_MAX_INPUT_SIZE);
+
+    /* The console is the only user of the CLI output buffer, it is the
+    *  scratch buffer of the console session for legacy commands.
+    */
+    FreeRTOS_CLISessionInit(&xSession, &xConsoleSink, FreeRTOS_CLIGetOutputBuffer(),
+                            configCOMMAND_INT_MAX_OUTPUT_SIZE);
+    FreeRTOS_CLISessionSetArena(&xSession, FreeRTOS_CLIGetArena(), configCOMMAND_INT_ARENA_SIZE);
+    FreeRTOS_CLISessionSetInteractive(&xSession, pdTRUE);
+#if (CONSOLE_BINARY_EN == 1)
+    /* Binary mode runs in this task too, it can share the scratch buffer */
+    vConsoleBinaryInit(&xConsoleSink, FreeRTOS_CLIGetOutputBuffer(),
+                       configCOMMAND_INT_MAX_OUTPUT_SIZE);
+#endif
+
+#if (CONSOLE_RX_DMA_EN == 0)
+    /* Create a queue to store characters from RX ISR */
+#if (STATIC_ALLOCATION_EN == 1)
+    xQueueRxHandle = xQueueCreateStatic(MAX_RX_QUEUE_LEN, sizeof(char), ucQueueRxStorage, &xQueueRxBuffer);
+#else
+    xQueueRxHandle = xQueueCreate(MAX_RX_QUEUE_LEN, sizeof(char));
+#endif
+    if (xQueueRxHandle == NULL)
+    {
+        goto out_task_console;
+    }
+    vQueueAddToRegistry(xQueueRxHandle, "ConsoleRx");
+#endif
+
+    vConsoleWrite(pcWelcomeMsg);
+    (void)xConsoleEnableRxInterrupt();
+    vConsoleWrite(prvpcPrompt);
+
+    while(1)
+    {
+        /* Block until there is a new character in RX buffer */
+        if (xConsoleRead((uint8_t*)(&cReadCh), sizeof(cReadCh), portMAX_DELAY) != pdTRUE)
+        {
+            continue;
+        }
+
+#if (CONSOLE_BINARY_EN == 1)
+        /* Bytes belong to frames until the host asks for text mode again */
+        if (xBinaryMode == pdTRUE)
+        {
+            if (xConsoleBinaryReceive((uint8_t)cReadCh) == pdFALSE)
+            {
+                xBinaryMode = pdFALSE;
+                vConsoleWrite("\n");
+                vConsoleWrite(prvpcPrompt);
+            }
+            continue;
+        }
+#endif
+
+        switch (cReadCh)
+        {
             case ASCII_CR:
             case ASCII_LF:
-                if (uInputIndex != 0)
+                if (xInputIndex != 0)
                 {
                     vConsoleWrite("\n\n");
-                    strncpy(pcPrevInputString, pcInputString, MAX_IN_STR_LEN);
-                    do
-                    {
-                        xMoreDataToProcess = FreeRTOS_CLIProcessCommand
-                                            (
-                                                pcInputString,    /* Command string*/
-                                                pcOutputString,   /* Output buffer */
-                                                MAX_OUT_STR_LEN   /* Output buffer size */
-                                            );
-                        vConsoleWrite(pcOutputString);
-                    } while (xMoreDataToProcess != pdFALSE);
+                    strncpy(pcPrevInputString, pcInputString, configCOMMAND_INT_MAX_INPUT_SIZE);
+                    /* Command output is streamed to UART TX as it is generated,
+                    *  a line can hold several ';' separated commands.
+                    */
+                    prvExecuteBatch(&xSession, pcInputString);
                 }
-                uInputIndex = 0;
-                memset(pcInputString, 0x00, MAX_IN_STR_LEN);
-                memset(pcOutputString, 0x00, MAX_OUT_STR_LEN);
+                xInputIndex = 0;
+                memset(pcInputString, 0x00, configCOMMAND_INT_MAX_INPUT_SIZE);
                 vConsoleWrite("\n");
                 vConsoleWrite(prvpcPrompt);
                 break;
@@ -661,44 +2076,55 @@ void vTaskConsole(void *pvParams)
                 vConsoleWrite(prvpcPrompt);
                 break;
             case ASCII_CTRL_PLUS_C:
-                uInputIndex = 0;
-                memset(pcInputString, 0x00, MAX_IN_STR_LEN);
+                xInputIndex = 0;
+                memset(pcInputString, 0x00, configCOMMAND_INT_MAX_INPUT_SIZE);
                 vConsoleWrite("\n");
                 vConsoleWrite(prvpcPrompt);
                 break;
+#if (CONSOLE_BINARY_EN == 1)
+            case ASCII_SHIFT_OUT:
+                /* Switch to binary mode, the partial command line is dropped */
+                xInputIndex = 0;
+                memset(pcInputString, 0x00, configCOMMAND_INT_MAX_INPUT_SIZE);
+                vConsoleBinaryStart();
+                xBinaryMode = pdTRUE;
+                break;
+#endif
             case ASCII_DEL:
             case ASCII_NACK:
             case ASCII_BACKSPACE:
-                if (uInputIndex > 0)
+                if (xInputIndex > 0)
                 {
-                    uInputIndex--;
-                    pcInputString[uInputIndex] = '\0';
+                    xInputIndex--;
+                    pcInputString[xInputIndex] = '\0';
                     vConsoleWrite("\b \b");
                 }
                 break;
             case ASCII_TAB:
-                while (uInputIndex)
+                while (xInputIndex)
                 {
-                    uInputIndex--;
+                    xInputIndex--;
                     vConsoleWrite("\b \b");
                 }
-                strncpy(pcInputString, pcPrevInputString, MAX_IN_STR_LEN);
-                uInputIndex = (unsigned char)strlen(pcInputString);
+                strncpy(pcInputString, pcPrevInputString, configCOMMAND_INT_MAX_INPUT_SIZE);
+                xInputIndex = strlen(pcInputString);
                 vConsoleWrite(pcInputString);
                 break;
             default:
                 /* Check if read character is between [Space] and [~] in ASCII table */
-                if (uInputIndex < (MAX_IN_STR_LEN - 1 ) && (cReadCh >= 32 && cReadCh <= 126))
+                if (xInputIndex < (configCOMMAND_INT_MAX_INPUT_SIZE - 1 ) && (cReadCh >= 32 && cReadCh <= 126))
                 {
-                    pcInputString[uInputIndex] = cReadCh;
-                    vConsoleWrite(pcInputString + uInputIndex);
-                    uInputIndex++;
+                    pcInputString[xInputIndex] = cReadCh;
+                    vConsoleWrite(pcInputString + xInputIndex);
+                    xInputIndex++;
                 }
                 break;
         }
     }
 
+#if (CONSOLE_RX_DMA_EN == 0)
 out_task_console:
+#endif
     if (xQueueRxHandle)
     {
         vQueueDelete(xQueueRxHandle);
@@ -707,7 +2133,8 @@ out_task_console:
 }
 
 /**
-* @brief Initialize the console by registering all commands and creating a task.
+* @brief Initialize the console by registering all commands (unless they are
+*        in the static command table) and creating a task.
 * @param usStackSize Task console stack size
 * @param uxPriority Task console priority
 * @param *pxUartHandle Pointer for uart handle.
@@ -715,7 +2142,9 @@ out_task_console:
 */
 BaseType_t xbspConsoleInit(uint16_t usStackSize, UBaseType_t uxPriority, UART_HandleTypeDef *pxUartHandle)
 {
-    const CLI_Command_Definition_t *pCommand;
+#if (configCOMMAND_INT_STATIC_TABLE == 0)
+    size_t xIndex;
+#endif
 
     if (pxUartHandle == NULL)
     {
@@ -723,12 +2152,37 @@ BaseType_t xbspConsoleInit(uint16_t usStackSize, UBaseType_t uxPriority, UART_Ha
     }
     pxUartDevHandle = pxUartHandle;
 
+    /* Serializes console writers, CLI sessions may run in other tasks */
+#if (STATIC_ALLOCATION_EN == 1)
+    xConsoleTxMutex = xSemaphoreCreateMutexStatic(&xConsoleTxMutexBuffer);
+#else
+    xConsoleTxMutex = xSemaphoreCreateMutex();
+#endif
+    if (xConsoleTxMutex == NULL)
+    {
+        return pdFALSE;
+    }
+    vQueueAddToRegistry(xConsoleTxMutex, "ConsoleTx");
+
+#if (configCOMMAND_INT_STATIC_TABLE == 0)
     /* Register all commands that can be accessed by the user */
-    for (pCommand = xCommands; pCommand->pcCommand != NULL; pCommand++)
+    for (xIndex = 0; xIndex < sizeof(xCommands) / sizeof(xCommands[0]); xIndex++)
     {
-        FreeRTOS_CLIRegisterCommand(pCommand);
+        FreeRTOS_CLIRegisterCommand(&xCommands[xIndex]);
+    }
+#endif
+#if (STATIC_ALLOCATION_EN == 1)
+    /* The stack is reserved with CONSOLE_STACK_SIZE words */
+    if (usStackSize > CONSOLE_STACK_SIZE)
+    {
+        return pdFALSE;
     }
-    return xTaskCreate(vTaskConsole,"CLI", usStackSize, NULL, uxPriority, NULL);
+    xTaskConsoleHandle = xTaskCreateStatic(vTaskConsole, "CLI", usStackSize, NULL, uxPriority,
+                                           xConsoleStack, &xConsoleTaskBuffer);
+    return (xTaskConsoleHandle != NULL) ? pdTRUE : pdFALSE;
+#else
+    return xTaskCreate(vTaskConsole,"CLI", usStackSize, NULL, uxPriority, &xTaskConsoleHandle);
+#endif
 }
 
 /**
@@ -740,9 +2194,109 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
     BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
 
+    xConsoleStats.uRxInterrupts++;
+    xConsoleStats.uRxBytes++;
     if (xQueueRxHandle != NULL)
     {
-        xQueueSendToBackFromISR(xQueueRxHandle, &cRxData, &pxHigherPriorityTaskWoken);
+        if (xQueueSendToBackFromISR(xQueueRxHandle, &cRxData, &pxHigherPriorityTaskWoken) != pdTRUE)
+        {
+            xConsoleStats.uRxDropped++;
+        }
+    }
+    (void)xConsoleEnableRxInterrupt();
+    portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+}
+
+#if (CONSOLE_RX_DMA_EN == 1)
+/**
+* @brief Callback for UART RX DMA, triggered on idle line, half and full transfer.
+* @param *huart Pointer to the uart handle.
+* @param usSize Position in the RX buffer up to where data has been written.
+* @retval void
+*/
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t usSize)
+{
+    uint16_t usNewHead;
+    BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+    usNewHead = (usSize >= RX_DMA_BUF_LEN) ? 0 : usSize;
+    if (usNewHead == usRxDmaHead)
+    {
+        return;
+    }
+
+    /* Hand the whole span received since the last event to the console task */
+    xConsoleStats.uRxInterrupts++;
+    xConsoleStats.uRxBytes += (usNewHead + RX_DMA_BUF_LEN - usRxDmaHead) % RX_DMA_BUF_LEN;
+    usRxDmaHead = usNewHead;
+    if (xTaskConsoleHandle != NULL)
+    {
+        vTaskNotifyGiveFromISR(xTaskConsoleHandle, &pxHigherPriorityTaskWoken);
+    }
+    portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+}
+#endif
+
+#if (CONSOLE_TX_DMA_EN == 1)
+/**
+* @brief Callback for UART TX, triggered when a DMA transfer has been sent.
+* @param *huart Pointer to the uart handle.
+* @retval void
+*/
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+
+    /* Release the transferred span and chain whatever was queued meanwhile */
+    usTxTail = (usTxTail + usTxDmaLen) % TX_RING_BUF_LEN;
+    usTxDmaLen = 0;
+    prvConsoleTxKick();
+
+    if (xTxWaitingTask != NULL)
+    {
+        vTaskNotifyGiveIndexedFromISR(xTxWaitingTask, TX_NOTIFY_INDEX, &pxHigherPriorityTaskWoken);
+        xTxWaitingTask = NULL;
+    }
+    portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+}
+#endif
+
+/**
+* @brief Callback for UART errors, reception is stopped by HAL so it is restarted.
+*        In DMA mode the console task restarts it, the buffer positions belong
+*        to the task while it reads.
+* @param *huart Pointer to the uart handle.
+* @retval void
+*/
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+#if (CONSOLE_RX_DMA_EN == 1)
+    BaseType_t pxHigherPriorityTaskWoken = pdFALSE;
+#endif
+
+    xConsoleStats.uRxErrors++;
+#if (CONSOLE_RX_DMA_EN == 0)
+    (void)xConsoleEnableRxInterrupt();
+#else
+    if (huart->RxState == HAL_UART_STATE_READY)
+    {
+        xRxRestartPending = pdTRUE;
+        if (xTaskConsoleHandle != NULL)
+        {
+            vTaskNotifyGiveFromISR(xTaskConsoleHandle, &pxHigherPriorityTaskWoken);
+        }
+    }
+#endif
+#if (CONSOLE_TX_DMA_EN == 1)
+    /* A failed TX transfer is dropped so writers never wait on it */
+    if ((huart->ErrorCode & HAL_UART_ERROR_DMA) && usTxDmaLen != 0 &&
+        huart->gState == HAL_UART_STATE_READY)
+    {
+        xConsoleStats.uTxErrors++;
+        HAL_UART_TxCpltCallback(huart);
     }
-    vConsoleEnableRxInterrupt();
+#endif
+#if (CONSOLE_RX_DMA_EN == 1)
+    portYIELD_FROM_ISR(pxHigherPriorityTaskWoken);
+#endif
 }
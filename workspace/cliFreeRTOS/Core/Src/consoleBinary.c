@@ -0,0 +1,323 @@
+/**
+ ******************************************************************************
+ * @file         consoleBinary.c
+ * @author       Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief        Binary framed protocol for the console. Requests and responses
+ *               are COBS encoded frames ended by 0x00 and protected by a
+ *               CRC-16/CCITT. Commands are executed by the CLI, so both modes
+ *               share the same command handlers.
+ *
+ *               Request : seq | flags | command id (4, LE) | parameters | crc (2, LE)
+ *               Response: seq | status | output | crc (2, LE)
+ ******************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "FreeRTOS_CLI.h"
+#include "string.h"
+#include "appConfig.h"
+#include "consoleBinary.h"
+#include "stackProfiler.h"
+
+#if (CONSOLE_BINARY_EN == 1)
+
+#define REQUEST_HEADER_LEN                  6
+#define RESPONSE_HEADER_LEN                 2
+#define CRC_LEN                             2
+#define CRC_INIT                            0xFFFF
+#define CRC_POLY                            0x1021
+
+/* COBS adds one byte every 254 bytes plus one, then the 0x00 delimiter */
+#define COBS_MAX_LEN(len)                   ((len) + ((len) / 254) + 2)
+
+typedef struct
+{
+    size_t xLen;                /* Bytes in the response, CRC excluded      */
+    BaseType_t xCapture;        /* Keep the command output                  */
+    BaseType_t xTruncated;      /* Output did not fit in the response       */
+} ResponseState_t;
+
+static uint8_t ucRxFrame[CONSOLE_BINARY_MAX_FRAME];
+static size_t xRxLen;
+static BaseType_t xRxOverflow;
+static uint8_t ucResponse[CONSOLE_BINARY_MAX_RESPONSE];
+static uint8_t ucTxFrame[COBS_MAX_LEN(CONSOLE_BINARY_MAX_RESPONSE)];
+static ResponseState_t xResponseState;
+static CLI_Output_Sink_t *pxTransportSink;
+static CLI_Session_t xBinarySession;
+
+static BaseType_t prvResponsePut(void *pvContext, const char *pcData, size_t xDataLength);
+
+static CLI_Output_Sink_t xResponseSink =
+{
+    prvResponsePut,
+    NULL,
+    &xResponseState
+};
+
+/**
+* @brief CRC-16/CCITT (poly 0x1021, init 0xFFFF) of a buffer.
+* @param *pucData Data to be checked.
+* @param xLen Number of bytes.
+* @retval CRC value.
+*/
+static uint16_t prvCrc16(const uint8_t *pucData, size_t xLen)
+{
+    uint16_t usCrc = CRC_INIT;
+    uint8_t uBit;
+
+    while (xLen--)
+    {
+        usCrc ^= (uint16_t)(*pucData++) << 8;
+        for (uBit = 0; uBit < 8; uBit++)
+        {
+            usCrc = (usCrc & 0x8000) ? (uint16_t)((usCrc << 1) ^ CRC_POLY) : (uint16_t)(usCrc << 1);
+        }
+    }
+
+    return usCrc;
+}
+
+/**
+* @brief COBS encode a buffer, the output has no 0x00 byte.
+* @param *pucIn Data to be encoded.
+* @param xLen Number of bytes to be encoded.
+* @param *pucOut Encoded data, at least COBS_MAX_LEN(xLen) - 1 bytes.
+* @retval Number of encoded bytes.
+*/
+static size_t prvCobsEncode(const uint8_t *pucIn, size_t xLen, uint8_t *pucOut)
+{
+    size_t xCodeIndex = 0;
+    size_t xWrite = 1;
+    uint8_t uCode = 1;
+
+    while (xLen--)
+    {
+        if (*pucIn != 0)
+        {
+            pucOut[xWrite++] = *pucIn;
+            uCode++;
+        }
+
+        if (*pucIn == 0 || uCode == 0xFF)
+        {
+            pucOut[xCodeIndex] = uCode;
+            xCodeIndex = xWrite++;
+            uCode = 1;
+        }
+        pucIn++;
+    }
+    pucOut[xCodeIndex] = uCode;
+
+    return xWrite;
+}
+
+/**
+* @brief COBS decode a buffer in place.
+* @param *pucData Encoded data without the 0x00 delimiter.
+* @param xLen Number of encoded bytes.
+* @retval Number of decoded bytes, 0 if the encoding is not valid.
+*/
+static size_t prvCobsDecode(uint8_t *pucData, size_t xLen)
+{
+    size_t xRead = 0;
+    size_t xWrite = 0;
+    uint8_t uCode;
+    uint8_t uCopy;
+
+    while (xRead < xLen)
+    {
+        uCode = pucData[xRead++];
+        if (uCode == 0 || (xRead + uCode - 1) > xLen)
+        {
+            return 0;
+        }
+
+        /* Decoded data is never ahead of encoded data */
+        for (uCopy = 1; uCopy < uCode; uCopy++)
+        {
+            pucData[xWrite++] = pucData[xRead++];
+        }
+
+        if (uCode != 0xFF && xRead < xLen)
+        {
+            pucData[xWrite++] = 0;
+        }
+    }
+
+    return xWrite;
+}
+
+/**
+* @brief Response sink put function, appends the command output to the
+*        response when the request asked for it.
+* @param *pvContext Response state.
+* @param *pcData Data to be written.
+* @param xDataLength Number of bytes to be written.
+* @retval pdPASS if data was written, otherwise pdFAIL.
+*/
+static BaseType_t prvResponsePut(void *pvContext, const char *pcData, size_t xDataLength)
+{
+    ResponseState_t *pxState = (ResponseState_t *)pvContext;
+    size_t xSpace;
+
+    if (pxState->xCapture == pdFALSE)
+    {
+        return pdPASS;
+    }
+
+    xSpace = CONSOLE_BINARY_MAX_RESPONSE - CRC_LEN - pxState->xLen;
+    if (xDataLength > xSpace)
+    {
+        xDataLength = xSpace;
+        pxState->xTruncated = pdTRUE;
+    }
+    memcpy(&ucResponse[pxState->xLen], pcData, xDataLength);
+    pxState->xLen += xDataLength;
+
+    return (pxState->xTruncated == pdFALSE) ? pdPASS : pdFAIL;
+}
+
+/**
+* @brief Add the CRC to the response, encode it and write it to the transport.
+* @param void
+* @retval void
+*/
+static void prvSendResponse(void)
+{
+    uint16_t usCrc;
+    size_t xLen = xResponseState.xLen;
+
+    if (xResponseState.xTruncated != pdFALSE)
+    {
+        ucResponse[1] |= CONSOLE_BINARY_STATUS_TRUNCATED;
+    }
+
+    usCrc = prvCrc16(ucResponse, xLen);
+    ucResponse[xLen++] = (uint8_t)(usCrc & 0xFF);
+    ucResponse[xLen++] = (uint8_t)(usCrc >> 8);
+
+    xLen = prvCobsEncode(ucResponse, xLen, ucTxFrame);
+    ucTxFrame[xLen++] = 0x00;
+
+    /* No flush, replies to pipelined requests are queued behind each other */
+    FreeRTOS_CLIWrite(pxTransportSink, (const char *)ucTxFrame, xLen);
+}
+
+/**
+* @brief Decode, check and execute one request.
+* @param xLen Number of encoded bytes in the RX frame.
+* @retval pdFALSE if the request takes the console back to text mode.
+*/
+static BaseType_t prvHandleFrame(size_t xLen)
+{
+    uint32_t ulCommandId;
+    uint16_t usCrc;
+    uint8_t uStatus;
+    BaseType_t xValid = pdFALSE;
+
+    xLen = (xRxOverflow == pdFALSE) ? prvCobsDecode(ucRxFrame, xLen) : 0;
+
+    xResponseState.xLen = RESPONSE_HEADER_LEN;
+    xResponseState.xCapture = pdFALSE;
+    xResponseState.xTruncated = pdFALSE;
+    ucResponse[0] = (xLen > 0) ? ucRxFrame[0] : 0;
+
+    if (xLen >= REQUEST_HEADER_LEN + CRC_LEN)
+    {
+        xLen -= CRC_LEN;
+        usCrc = (uint16_t)ucRxFrame[xLen] | ((uint16_t)ucRxFrame[xLen + 1] << 8);
+        xValid = (prvCrc16(ucRxFrame, xLen) == usCrc) ? pdTRUE : pdFALSE;
+    }
+
+    if (xValid == pdFALSE)
+    {
+        ucResponse[1] = CONSOLE_BINARY_STATUS_BAD_FRAME;
+        prvSendResponse();
+        return pdTRUE;
+    }
+
+    ulCommandId = (uint32_t)ucRxFrame[2] | ((uint32_t)ucRxFrame[3] << 8) |
+                  ((uint32_t)ucRxFrame[4] << 16) | ((uint32_t)ucRxFrame[5] << 24);
+
+    if (ulCommandId == CONSOLE_BINARY_ID_EXIT)
+    {
+        ucResponse[1] = eCLIPackedOk;
+        prvSendResponse();
+        return pdFALSE;
+    }
+
+    xResponseState.xCapture = (ucRxFrame[1] & CONSOLE_BINARY_FLAG_OUTPUT) ? pdTRUE : pdFALSE;
+    uStatus = (uint8_t)FreeRTOS_CLISessionExecutePacked(&xBinarySession, ulCommandId,
+                                                        &ucRxFrame[REQUEST_HEADER_LEN],
+                                                        xLen - REQUEST_HEADER_LEN);
+#if (STACK_PROFILER_EN == 1)
+    vStackProfilerMark("binary");
+#endif
+    ucResponse[1] = uStatus;
+    prvSendResponse();
+
+    return pdTRUE;
+}
+
+/**
+* @brief Initialize the binary protocol.
+* @param *pxTransport Sink the encoded responses are written to.
+* @param *pcScratchBuffer Scratch buffer for legacy commands, see
+*        FreeRTOS_CLISessionInit().
+* @param xScratchBufferLength Scratch buffer size.
+* @retval void
+*/
+void vConsoleBinaryInit(CLI_Output_Sink_t *pxTransport, char *pcScratchBuffer, size_t xScratchBufferLength)
+{
+    pxTransportSink = pxTransport;
+    FreeRTOS_CLISessionInit(&xBinarySession, &xResponseSink, pcScratchBuffer, xScratchBufferLength);
+    /* Same task as the console session, the arena is only in use during a command */
+    FreeRTOS_CLISessionSetArena(&xBinarySession, FreeRTOS_CLIGetArena(), configCOMMAND_INT_ARENA_SIZE);
+}
+
+/**
+* @brief Start binary mode, discarding any partial frame.
+* @param void
+* @retval void
+*/
+void vConsoleBinaryStart(void)
+{
+    xRxLen = 0;
+    xRxOverflow = pdFALSE;
+}
+
+/**
+* @brief Feed one received byte to the binary protocol. Requests are executed
+*        as soon as their delimiter arrives, so the host can send several
+*        requests before reading the responses.
+* @param ucByte Received byte.
+* @retval pdFALSE if the host asked to go back to text mode, otherwise pdTRUE.
+*/
+BaseType_t xConsoleBinaryReceive(uint8_t ucByte)
+{
+    BaseType_t xReturn = pdTRUE;
+
+    if (ucByte == 0x00)
+    {
+        /* Back to back delimiters are only used to resynchronize */
+        if (xRxLen > 0 || xRxOverflow != pdFALSE)
+        {
+            xReturn = prvHandleFrame(xRxLen);
+        }
+        xRxLen = 0;
+        xRxOverflow = pdFALSE;
+    }
+    else if (xRxLen < CONSOLE_BINARY_MAX_FRAME)
+    {
+        ucRxFrame[xRxLen++] = ucByte;
+    }
+    else
+    {
+        xRxOverflow = pdTRUE;
+    }
+
+    return xReturn;
+}
+
+#endif
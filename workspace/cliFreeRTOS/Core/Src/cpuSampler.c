@@ -0,0 +1,290 @@
+/**
+ ******************************************************************************
+ * @file         cpuSampler.c
+ * @author       Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief        Windowed CPU utilisation sampler. A low priority task takes a
+ *               task snapshot every CPU_SAMPLER_PERIOD_MS and adds the run
+ *               time each task used since the previous sample to a set of
+ *               windows, each CPU_SAMPLER_WINDOW_RATIO times longer than the
+ *               previous one. Loads are published when a window completes.
+ ******************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "string.h"
+#include "stm32f4xx.h"
+#include "appConfig.h"
+#include "taskSnapshot.h"
+#include "cpuSampler.h"
+
+typedef struct
+{
+    TaskHandle_t xHandle;
+    UBaseType_t uxTaskNumber;                   /* Unique, handles can be reused */
+    configRUN_TIME_COUNTER_TYPE uLastRunTime;   /* Run time counter at the last sample */
+    configRUN_TIME_COUNTER_TYPE uRunTime[CPU_SAMPLER_WINDOWS]; /* Run time in the windows being filled */
+    BaseType_t xSeen;                           /* Present in the last snapshot */
+    CpuSamplerTask_t xResult;
+} SamplerSlot_t;
+
+static SamplerSlot_t xSlots[TASK_SNAPSHOT_MAX_TASKS];
+static configRUN_TIME_COUNTER_TYPE uLastTotalRunTime;
+static configRUN_TIME_COUNTER_TYPE uWindowRunTime[CPU_SAMPLER_WINDOWS];
+static uint32_t uWindowSamples[CPU_SAMPLER_WINDOWS];
+static CpuSamplerInfo_t xInfo;
+static TaskHandle_t xTaskSamplerHandle;
+#if (STATIC_ALLOCATION_EN == 1)
+static StaticTask_t xSamplerTaskBuffer;
+static StackType_t xSamplerStack[CPU_SAMPLER_STACK_SIZE];
+#endif
+
+/**
+* @brief Find the slot of a task, or take a free one for a new task.
+* @param *pxTask Task status from the snapshot.
+* @param *pxNew Set to pdTRUE when the slot was free.
+* @retval Slot of the task, NULL if there is no free slot.
+*/
+static SamplerSlot_t *prvGetSlot(const TaskStatus_t *pxTask, BaseType_t *pxNew)
+{
+    SamplerSlot_t *pxFree = NULL;
+    UBaseType_t uxIndex;
+
+    for (uxIndex = 0; uxIndex < TASK_SNAPSHOT_MAX_TASKS; uxIndex++)
+    {
+        if (xSlots[uxIndex].xHandle == pxTask->xHandle &&
+            xSlots[uxIndex].uxTaskNumber == pxTask->xTaskNumber)
+        {
+            *pxNew = pdFALSE;
+            return &xSlots[uxIndex];
+        }
+        if (xSlots[uxIndex].xHandle == NULL && pxFree == NULL)
+        {
+            pxFree = &xSlots[uxIndex];
+        }
+    }
+
+    if (pxFree != NULL)
+    {
+        memset(pxFree, 0x00, sizeof(SamplerSlot_t));
+        pxFree->xHandle = pxTask->xHandle;
+        pxFree->uxTaskNumber = pxTask->xTaskNumber;
+        strncpy(pxFree->xResult.cName, pxTask->pcTaskName, configMAX_TASK_NAME_LEN - 1);
+    }
+    *pxNew = pdTRUE;
+
+    return pxFree;
+}
+
+/**
+* @brief Load of a task in a window, in tenths of percent.
+* @param uRunTime Run time of the task in the window.
+* @param uTotal Run time of the window.
+* @retval Load.
+*/
+static uint16_t prvLoad(configRUN_TIME_COUNTER_TYPE uRunTime, configRUN_TIME_COUNTER_TYPE uTotal)
+{
+    uint64_t uLoad;
+
+    if (uTotal == 0)
+    {
+        return 0;
+    }
+    uLoad = ((uint64_t)uRunTime * 1000 + uTotal / 2) / uTotal;
+
+    return (uLoad > 1000) ? 1000 : (uint16_t)uLoad;
+}
+
+/**
+* @brief Account one snapshot into the windows.
+* @param *pxSnapshot Snapshot taken for this sample.
+* @retval void
+*/
+static void prvSample(const TaskSnapshot_t *pxSnapshot)
+{
+    const TaskStatus_t *pxTask;
+    SamplerSlot_t *pxSlot;
+    UBaseType_t uxIndex;
+    BaseType_t xNew;
+    configRUN_TIME_COUNTER_TYPE uDelta;
+    configRUN_TIME_COUNTER_TYPE uTotalDelta;
+    uint8_t uWindow;
+    BaseType_t xDone;
+
+    /* Unsigned differences stay right when the counters wrap */
+    uTotalDelta = pxSnapshot->uTotalRunTime - uLastTotalRunTime;
+    uLastTotalRunTime = pxSnapshot->uTotalRunTime;
+
+    for (uxIndex = 0; uxIndex < TASK_SNAPSHOT_MAX_TASKS; uxIndex++)
+    {
+        xSlots[uxIndex].xSeen = pdFALSE;
+    }
+
+    for (uxIndex = 0; uxIndex < pxSnapshot->uxCount; uxIndex++)
+    {
+        pxTask = &pxSnapshot->xTasks[uxIndex];
+        pxSlot = prvGetSlot(pxTask, &xNew);
+        if (pxSlot == NULL)
+        {
+            continue;
+        }
+
+        /* A new task has no previous sample, its run time counts from here */
+        uDelta = (xNew == pdTRUE) ? 0 : pxTask->ulRunTimeCounter - pxSlot->uLastRunTime;
+        pxSlot->uLastRunTime = pxTask->ulRunTimeCounter;
+        pxSlot->xSeen = pdTRUE;
+        for (uWindow = 0; uWindow < CPU_SAMPLER_WINDOWS; uWindow++)
+        {
+            pxSlot->uRunTime[uWindow] += uDelta;
+        }
+    }
+
+    /* The first sample is only the reference for the next one */
+    if (xInfo.uSamples == 0)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    for (uxIndex = 0; uxIndex < TASK_SNAPSHOT_MAX_TASKS; uxIndex++)
+    {
+        /* Deleted tasks free their slot */
+        if (xSlots[uxIndex].xSeen == pdFALSE)
+        {
+            xSlots[uxIndex].xHandle = NULL;
+        }
+    }
+
+    for (uWindow = 0; uWindow < CPU_SAMPLER_WINDOWS; uWindow++)
+    {
+        uWindowRunTime[uWindow] += uTotalDelta;
+        uWindowSamples[uWindow]++;
+        xDone = (uWindowSamples[uWindow] * CPU_SAMPLER_PERIOD_MS >= xInfo.uWindowMs[uWindow]) ? pdTRUE : pdFALSE;
+        if (xDone == pdFALSE)
+        {
+            continue;
+        }
+
+        for (uxIndex = 0; uxIndex < TASK_SNAPSHOT_MAX_TASKS; uxIndex++)
+        {
+            pxSlot = &xSlots[uxIndex];
+            if (pxSlot->xHandle == NULL)
+            {
+                continue;
+            }
+            pxSlot->xResult.usLoad[uWindow] = prvLoad(pxSlot->uRunTime[uWindow], uWindowRunTime[uWindow]);
+            if (pxSlot->xResult.usLoad[uWindow] > pxSlot->xResult.usPeak[uWindow])
+            {
+                pxSlot->xResult.usPeak[uWindow] = pxSlot->xResult.usLoad[uWindow];
+            }
+            if (pxSlot->xHandle == xTaskGetIdleTaskHandle())
+            {
+                xInfo.usIdle[uWindow] = pxSlot->xResult.usLoad[uWindow];
+            }
+            pxSlot->uRunTime[uWindow] = 0;
+        }
+        uWindowRunTime[uWindow] = 0;
+        uWindowSamples[uWindow] = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+* @brief Sampler task, takes one sample every CPU_SAMPLER_PERIOD_MS.
+* @param *pvParams Data passed at task creation.
+* @retval void
+*/
+static void vTaskCpuSampler(void *pvParams)
+{
+    const TaskSnapshot_t *pxSnapshot;
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    uint32_t uStart;
+    uint32_t uCycles;
+
+    while (1)
+    {
+        vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(CPU_SAMPLER_PERIOD_MS));
+
+        uStart = DWT->CYCCNT;
+        /* The run time of a skipped sample is added to the next one. Only
+        *  run times are needed, the task stacks are not scanned.
+        */
+        if (xTaskSnapshotRefresh(pdFALSE) != pdPASS)
+        {
+            xInfo.uSkipped++;
+            continue;
+        }
+        pxSnapshot = pxTaskSnapshotAcquire();
+        prvSample(pxSnapshot);
+        vTaskSnapshotRelease(pxSnapshot);
+        uCycles = DWT->CYCCNT - uStart;
+
+        /* The sampler measures itself, this is its overhead per sample */
+        xInfo.uSamples++;
+        xInfo.uLastCycles = uCycles;
+        if (uCycles > xInfo.uMaxCycles)
+        {
+            xInfo.uMaxCycles = uCycles;
+        }
+    }
+}
+
+/**
+* @brief Create the sampler task.
+* @param usStackSize Sampler task stack size.
+* @param uxPriority Sampler task priority, should be low.
+* @retval FreeRTOS status
+*/
+BaseType_t xCpuSamplerInit(uint16_t usStackSize, UBaseType_t uxPriority)
+{
+    uint8_t uWindow;
+    uint32_t uWindowMs = CPU_SAMPLER_PERIOD_MS;
+
+    for (uWindow = 0; uWindow < CPU_SAMPLER_WINDOWS; uWindow++)
+    {
+        xInfo.uWindowMs[uWindow] = uWindowMs;
+        uWindowMs *= CPU_SAMPLER_WINDOW_RATIO;
+    }
+
+#if (STATIC_ALLOCATION_EN == 1)
+    /* The stack is reserved with CPU_SAMPLER_STACK_SIZE words */
+    if (usStackSize > CPU_SAMPLER_STACK_SIZE)
+    {
+        return pdFALSE;
+    }
+    xTaskSamplerHandle = xTaskCreateStatic(vTaskCpuSampler, "sampler", usStackSize, NULL, uxPriority,
+                                           xSamplerStack, &xSamplerTaskBuffer);
+    return (xTaskSamplerHandle != NULL) ? pdPASS : pdFAIL;
+#else
+    return xTaskCreate(vTaskCpuSampler, "sampler", usStackSize, NULL, uxPriority, &xTaskSamplerHandle);
+#endif
+}
+
+/**
+* @brief Copy the loads published by the sampler.
+* @param *pxTasks Array that receives the load of each task.
+* @param uxMaxTasks Size of pxTasks.
+* @param *pxInfo Receives the idle load and the sampler counters, can be NULL.
+* @retval Number of tasks copied to pxTasks.
+*/
+UBaseType_t uxCpuSamplerRead(CpuSamplerTask_t *pxTasks, UBaseType_t uxMaxTasks, CpuSamplerInfo_t *pxInfo)
+{
+    UBaseType_t uxIndex;
+    UBaseType_t uxCount = 0;
+
+    taskENTER_CRITICAL();
+    for (uxIndex = 0; uxIndex < TASK_SNAPSHOT_MAX_TASKS && uxCount < uxMaxTasks; uxIndex++)
+    {
+        if (xSlots[uxIndex].xHandle != NULL)
+        {
+            pxTasks[uxCount++] = xSlots[uxIndex].xResult;
+        }
+    }
+    if (pxInfo != NULL)
+    {
+        *pxInfo = xInfo;
+    }
+    taskEXIT_CRITICAL();
+
+    return uxCount;
+}
@@ -0,0 +1,216 @@
+/**
+ ******************************************************************************
+ * @file         irqProfiler.c
+ * @author       Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief        Interrupt latency and duration profiler. Profiled handlers take
+ *               the DWT cycle counter at entry and exit and record both times
+ *               into per interrupt log2 histograms. Latency is only known for
+ *               interrupts whose source timestamps the event, like the timer
+ *               counters.
+ ******************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "string.h"
+#include "stm32f4xx_hal.h"
+#include "appConfig.h"
+#include "irqProfiler.h"
+
+#if (IRQ_PROFILER_EN == 1)
+
+static IrqProfile_t xProfiles[IRQ_PROFILE_COUNT];
+static uint32_t uApb1TimRatio = 1;  /* CPU cycles per APB1 timer clock */
+static uint32_t uApb2TimRatio = 1;  /* CPU cycles per APB2 timer clock */
+
+static const char *pcProfileNames[IRQ_PROFILE_COUNT] =
+{
+    "USART1",
+    "TIM2",
+    "TIM9"
+};
+
+/**
+* @brief Add one value to a statistic, called from interrupt context.
+* @param *pxStat Statistic to be updated.
+* @param uCycles Value in CPU cycles.
+* @retval void
+*/
+static void prvStatAdd(IrqProfileStat_t *pxStat, uint32_t uCycles)
+{
+    uint32_t uBin;
+
+    /* Bin is the number of significant bits of the value */
+    uBin = 32 - __CLZ(uCycles);
+    if (uBin >= IRQ_PROFILER_BINS)
+    {
+        uBin = IRQ_PROFILER_BINS - 1;
+    }
+    pxStat->uBins[uBin]++;
+    if (pxStat->uCount == 0 || uCycles < pxStat->uMin)
+    {
+        pxStat->uMin = uCycles;
+    }
+    pxStat->uCount++;
+    pxStat->uSum += uCycles;
+    if (uCycles > pxStat->uMax)
+    {
+        pxStat->uMax = uCycles;
+    }
+}
+
+/**
+* @brief Convert timer counts into CPU cycles.
+* @param *pxTim Timer instance.
+* @param uTicks Timer counts.
+* @retval CPU cycles.
+*/
+static uint32_t prvTimTicksToCycles(const TIM_TypeDef *pxTim, uint32_t uTicks)
+{
+    uint32_t uRatio = ((uint32_t)pxTim >= APB2PERIPH_BASE) ? uApb2TimRatio : uApb1TimRatio;
+
+    return uTicks * (pxTim->PSC + 1) * uRatio;
+}
+
+/**
+* @brief Compute the timer clock ratios used to convert timer counts into
+*        CPU cycles. Called again if the bus clocks change.
+* @param void
+* @retval void
+*/
+void vIrqProfilerInit(void)
+{
+    RCC_ClkInitTypeDef xClkConfig;
+    uint32_t uFlashLatency;
+    uint32_t uHclk = HAL_RCC_GetHCLKFreq();
+    uint32_t uTimClk;
+
+    /* Timers run at twice the APB clock when the APB prescaler is not 1 */
+    HAL_RCC_GetClockConfig(&xClkConfig, &uFlashLatency);
+    uTimClk = HAL_RCC_GetPCLK1Freq();
+    uTimClk *= (xClkConfig.APB1CLKDivider == RCC_HCLK_DIV1) ? 1 : 2;
+    uApb1TimRatio = (uTimClk != 0) ? uHclk / uTimClk : 1;
+    uTimClk = HAL_RCC_GetPCLK2Freq();
+    uTimClk *= (xClkConfig.APB2CLKDivider == RCC_HCLK_DIV1) ? 1 : 2;
+    uApb2TimRatio = (uTimClk != 0) ? uHclk / uTimClk : 1;
+}
+
+/**
+* @brief Record one execution of a profiled handler, see IRQ_PROFILE_EXIT().
+*        An interrupt never preempts itself, so each profile has one writer.
+* @param eId Profiled interrupt.
+* @param uLatency Cycles from the event to the handler entry, or
+*        IRQ_PROFILE_NO_LATENCY.
+* @param uDuration Cycles taken by the handler.
+* @retval void
+*/
+void vIrqProfilerRecord(IrqProfileId_e eId, uint32_t uLatency, uint32_t uDuration)
+{
+    if (uLatency != IRQ_PROFILE_NO_LATENCY)
+    {
+        prvStatAdd(&xProfiles[eId].xLatency, uLatency);
+    }
+    prvStatAdd(&xProfiles[eId].xDuration, uDuration);
+}
+
+/**
+* @brief Latency of a timer update interrupt. An up counting timer restarts
+*        from 0 at the update event, so the counter is the time since then.
+* @param *pxTim Timer instance.
+* @retval Latency in CPU cycles, IRQ_PROFILE_NO_LATENCY if the interrupt
+*         was not raised by an update event.
+*/
+uint32_t uIrqProfilerTimUpdateLatency(const TIM_TypeDef *pxTim)
+{
+    uint32_t uCount = pxTim->CNT;
+
+    if ((pxTim->SR & pxTim->DIER & TIM_SR_UIF) == 0)
+    {
+        return IRQ_PROFILE_NO_LATENCY;
+    }
+
+    return prvTimTicksToCycles(pxTim, uCount);
+}
+
+/**
+* @brief Latency of a timer compare interrupt: the counter distance from the
+*        compare value of the first channel that raised the interrupt.
+* @param *pxTim Timer instance, counting up.
+* @retval Latency in CPU cycles, IRQ_PROFILE_NO_LATENCY if no enabled
+*         compare event is pending.
+*/
+uint32_t uIrqProfilerTimCompareLatency(const TIM_TypeDef *pxTim)
+{
+    uint32_t uCount = pxTim->CNT;
+    uint32_t uPending = pxTim->SR & pxTim->DIER;
+    uint32_t uCompare;
+
+    if (uPending & TIM_SR_CC1IF)
+    {
+        uCompare = pxTim->CCR1;
+    }
+    else if (uPending & TIM_SR_CC2IF)
+    {
+        uCompare = pxTim->CCR2;
+    }
+    else if (uPending & TIM_SR_CC3IF)
+    {
+        uCompare = pxTim->CCR3;
+    }
+    else if (uPending & TIM_SR_CC4IF)
+    {
+        uCompare = pxTim->CCR4;
+    }
+    else
+    {
+        return IRQ_PROFILE_NO_LATENCY;
+    }
+
+    /* The counter may have restarted from 0 since the compare event */
+    uCount = (uCount >= uCompare) ? uCount - uCompare : uCount + pxTim->ARR + 1 - uCompare;
+
+    return prvTimTicksToCycles(pxTim, uCount);
+}
+
+/**
+* @brief Copy the profile of one interrupt.
+* @param eId Profiled interrupt.
+* @param *pxProfile Receives the profile.
+* @retval void
+*/
+void vIrqProfilerRead(IrqProfileId_e eId, IrqProfile_t *pxProfile)
+{
+    /* Profiled interrupts are below configMAX_SYSCALL_INTERRUPT_PRIORITY */
+    taskENTER_CRITICAL();
+    *pxProfile = xProfiles[eId];
+    taskEXIT_CRITICAL();
+}
+
+/**
+* @brief Clear the profiles of all interrupts.
+* @param void
+* @retval void
+*/
+void vIrqProfilerReset(void)
+{
+    uint8_t uId;
+
+    for (uId = 0; uId < IRQ_PROFILE_COUNT; uId++)
+    {
+        taskENTER_CRITICAL();
+        memset(&xProfiles[uId], 0x00, sizeof(IrqProfile_t));
+        taskEXIT_CRITICAL();
+    }
+}
+
+/**
+* @brief Get the name of a profiled interrupt.
+* @param eId Profiled interrupt.
+* @retval Interrupt name.
+*/
+const char *pcIrqProfilerName(IrqProfileId_e eId)
+{
+    return pcProfileNames[eId];
+}
+
+#endif
@@ -13,11 +13,63 @@
 #include "task.h"
 #include "bsp.h"
 #include "console.h"
+#include "cpuSampler.h"
+#include "irqProfiler.h"
+#include "stackProfiler.h"
 #include "appConfig.h"
 
 TaskHandle_t xTaskHeartBeatHandler;
 extern UART_HandleTypeDef consoleHandle;
 
+#if (STATIC_ALLOCATION_EN == 0)
+/* Kernel heap, placed here with configAPPLICATION_ALLOCATED_HEAP so the mem
+*  command can show its bounds
+*/
+uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+#endif
+
+#if (STATIC_ALLOCATION_EN == 1)
+static StaticTask_t xHeartBeatTaskBuffer;
+static StackType_t xHeartBeatStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t xIdleTaskBuffer;
+static StackType_t xIdleStack[configMINIMAL_STACK_SIZE];
+static StaticTask_t xTimerTaskBuffer;
+static StackType_t xTimerStack[configTIMER_TASK_STACK_DEPTH];
+
+/**
+* @brief Memory of the idle task, called by the kernel when the scheduler starts.
+* @param **ppxIdleTaskTCBBuffer Task control block
+* @param **ppxIdleTaskStackBuffer Stack
+* @param *pulIdleTaskStackSize Stack size in words
+* @retval void
+*/
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+    *ppxIdleTaskTCBBuffer = &xIdleTaskBuffer;
+    *ppxIdleTaskStackBuffer = xIdleStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/**
+* @brief Memory of the timer service task, called by the kernel when the
+*        scheduler starts.
+* @param **ppxTimerTaskTCBBuffer Task control block
+* @param **ppxTimerTaskStackBuffer Stack
+* @param *pulTimerTaskStackSize Stack size in words
+* @retval void
+*/
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+    *ppxTimerTaskTCBBuffer = &xTimerTaskBuffer;
+    *ppxTimerTaskStackBuffer = xTimerStack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+
 /**
 * @brief Heart beat task indicates project alive by toggling an LED.
 * @param *pvParams data passed at task creation
@@ -42,14 +94,33 @@ int main(void)
     BaseType_t retVal;
     HAL_StatusTypeDef halStatus;
 
+#if (STACK_PROFILER_EN == 1)
+    vStackProfilerInit();
+#endif
+
     halStatus = bspInit();
     if (halStatus != HAL_OK)
         goto main_out;
 
+#if (IRQ_PROFILER_EN == 1)
+    vIrqProfilerInit();
+#endif
+
     retVal = xbspConsoleInit(CONSOLE_STACK_SIZE, CONSOLE_TASK_PRIORITY, &consoleHandle);
     if (retVal != pdTRUE)
         goto main_out;
 
+#if (STATIC_ALLOCATION_EN == 1)
+    xTaskHeartBeatHandler = xTaskCreateStatic(vTaskHeartBeat,
+                                              "task-heart-beat",
+                                              configMINIMAL_STACK_SIZE,
+                                              NULL,
+                                              HEART_BEAT_PRIORITY_TASK,
+                                              xHeartBeatStack,
+                                              &xHeartBeatTaskBuffer);
+    if (xTaskHeartBeatHandler == NULL)
+        goto main_out;
+#else
     retVal = xTaskCreate(vTaskHeartBeat,
                          "task-heart-beat",
                          configMINIMAL_STACK_SIZE,
@@ -58,6 +129,11 @@ int main(void)
                          &xTaskHeartBeatHandler);
     if (retVal != pdTRUE)
         goto main_out;
+#endif
+
+    retVal = xCpuSamplerInit(CPU_SAMPLER_STACK_SIZE, CPU_SAMPLER_PRIORITY_TASK);
+    if (retVal != pdTRUE)
+        goto main_out;
 
     /* By default, all PWM channels are started */
     bspPwmStart(PWM_CH_1);
@@ -0,0 +1,263 @@
+/**
+ ******************************************************************************
+ * @file         stackProfiler.c
+ * @author       Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief        Stack usage profiler. Task stacks are filled with a known
+ *               value by the kernel and the main stack is filled here, the
+ *               peak use is where the fill value was last overwritten. Peaks
+ *               are kept for the whole run, also for deleted tasks, and the
+ *               console labels each new peak of its task with the command
+ *               that reached it.
+ ******************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "string.h"
+#include "stm32f4xx.h"
+#include "main.h"
+#include "appConfig.h"
+#include "stackProfiler.h"
+
+#if (STACK_PROFILER_EN == 1)
+
+#define STACK_FILL_WORD                     0xA5A5A5A5UL /* tskSTACK_FILL_BYTE in every byte */
+#define STACK_MAIN_GUARD_WORDS              16  /* Not filled below the stack pointer at init */
+#define STACK_ROUND_WORDS                   8   /* Recommended sizes are a multiple of this */
+
+typedef struct
+{
+    TaskHandle_t xHandle;       /* NULL once the task is deleted */
+    StackProfile_t xProfile;
+} StackSlot_t;
+
+extern uint32_t _estack;        /* Top of the main stack, linker script    */
+extern uint32_t _Min_Stack_Size;/* Size reserved for the main stack, bytes */
+
+static StackSlot_t xSlots[STACK_PROFILER_MAX_TASKS];
+static uint32_t *puMainStackBottom;
+volatile const char *pcStackOverflowTask;
+
+/**
+* @brief Find the slot of a task.
+* @param xHandle Task handle.
+* @retval Slot of the task, NULL if the task is not profiled.
+*/
+static StackSlot_t *prvFindSlot(TaskHandle_t xHandle)
+{
+    UBaseType_t uxIndex;
+
+    for (uxIndex = 0; uxIndex < STACK_PROFILER_MAX_TASKS; uxIndex++)
+    {
+        if (xSlots[uxIndex].xHandle == xHandle)
+        {
+            return &xSlots[uxIndex];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+* @brief Update the peak of a task from its stack high water mark.
+* @param *pxSlot Slot of a task that exists.
+* @retval pdTRUE if the peak grew.
+*/
+static BaseType_t prvUpdatePeak(StackSlot_t *pxSlot)
+{
+    uint32_t uPeak = pxSlot->xProfile.uSize - uxTaskGetStackHighWaterMark(pxSlot->xHandle);
+
+    if (uPeak <= pxSlot->xProfile.uPeak)
+    {
+        return pdFALSE;
+    }
+    pxSlot->xProfile.uPeak = uPeak;
+
+    return pdTRUE;
+}
+
+/**
+* @brief Fill the unused part of the main stack, used by main() until the
+*        scheduler starts and by the interrupt handlers afterwards. Called
+*        from main() before the scheduler starts.
+* @param void
+* @retval void
+*/
+void vStackProfilerInit(void)
+{
+    uint32_t *puWord;
+    uint32_t *puLimit = (uint32_t *)__get_MSP() - STACK_MAIN_GUARD_WORDS;
+
+    puMainStackBottom = (uint32_t *)((uint32_t)&_estack - (uint32_t)&_Min_Stack_Size);
+    for (puWord = puMainStackBottom; puWord < puLimit; puWord++)
+    {
+        *puWord = STACK_FILL_WORD;
+    }
+}
+
+/**
+* @brief traceTASK_CREATE hook, called by the kernel in a critical section.
+* @param *pvTask Handle of the new task.
+* @param *pxStack Lowest address of the task stack.
+* @param *pxEndOfStack Highest usable address of the task stack.
+* @retval void
+*/
+void vStackProfilerTaskCreated(void *pvTask, const StackType_t *pxStack, const StackType_t *pxEndOfStack)
+{
+    StackSlot_t *pxSlot = NULL;
+    UBaseType_t uxIndex;
+
+    /* Prefer a free slot, then the slot of a deleted task */
+    for (uxIndex = 0; uxIndex < STACK_PROFILER_MAX_TASKS && pxSlot == NULL; uxIndex++)
+    {
+        if (xSlots[uxIndex].xProfile.uSize == 0)
+        {
+            pxSlot = &xSlots[uxIndex];
+        }
+    }
+    for (uxIndex = 0; uxIndex < STACK_PROFILER_MAX_TASKS && pxSlot == NULL; uxIndex++)
+    {
+        if (xSlots[uxIndex].xHandle == NULL)
+        {
+            pxSlot = &xSlots[uxIndex];
+        }
+    }
+    if (pxSlot == NULL)
+    {
+        return;
+    }
+
+    memset(pxSlot, 0x00, sizeof(StackSlot_t));
+    pxSlot->xHandle = (TaskHandle_t)pvTask;
+    pxSlot->xProfile.uSize = (uint32_t)(pxEndOfStack - pxStack) + 1;
+    strncpy(pxSlot->xProfile.cName, pcTaskGetName(pxSlot->xHandle), configMAX_TASK_NAME_LEN - 1);
+}
+
+/**
+* @brief traceTASK_DELETE hook, called by the kernel in a critical section.
+*        The stack is still there, its peak is kept for the report.
+* @param *pvTask Handle of the deleted task.
+* @retval void
+*/
+void vStackProfilerTaskDeleted(void *pvTask)
+{
+    StackSlot_t *pxSlot = prvFindSlot((TaskHandle_t)pvTask);
+
+    if (pxSlot != NULL)
+    {
+        (void)prvUpdatePeak(pxSlot);
+        pxSlot->xHandle = NULL;
+        pxSlot->xProfile.xDeleted = pdTRUE;
+    }
+}
+
+/**
+* @brief Check the stack of the calling task and, if its peak grew, label the
+*        new peak. The console calls it after each command.
+* @param *pcLabel Label, only the first word is kept.
+* @retval void
+*/
+void vStackProfilerMark(const char *pcLabel)
+{
+    StackSlot_t *pxSlot;
+    size_t xLen = strcspn(pcLabel, " ");
+
+    if (xLen >= STACK_PROFILER_LABEL_LEN)
+    {
+        xLen = STACK_PROFILER_LABEL_LEN - 1;
+    }
+
+    /* Tasks are only created and deleted by tasks, interrupts may run */
+    vTaskSuspendAll();
+    pxSlot = prvFindSlot(xTaskGetCurrentTaskHandle());
+    if (pxSlot != NULL && prvUpdatePeak(pxSlot) == pdTRUE)
+    {
+        memcpy(pxSlot->xProfile.cPeakLabel, pcLabel, xLen);
+        pxSlot->xProfile.cPeakLabel[xLen] = '\0';
+    }
+    (void)xTaskResumeAll();
+}
+
+/**
+* @brief Update the peaks of the existing tasks and copy all the profiles.
+*        The scheduler is suspended while one stack is scanned, so the task
+*        can not be deleted meanwhile.
+* @param *pxProfiles Array that receives the profiles.
+* @param uxMaxProfiles Size of pxProfiles.
+* @retval Number of profiles copied.
+*/
+UBaseType_t uxStackProfilerRead(StackProfile_t *pxProfiles, UBaseType_t uxMaxProfiles)
+{
+    UBaseType_t uxIndex;
+    UBaseType_t uxCount = 0;
+
+    for (uxIndex = 0; uxIndex < STACK_PROFILER_MAX_TASKS && uxCount < uxMaxProfiles; uxIndex++)
+    {
+        vTaskSuspendAll();
+        if (xSlots[uxIndex].xProfile.uSize != 0)
+        {
+            if (xSlots[uxIndex].xHandle != NULL)
+            {
+                (void)prvUpdatePeak(&xSlots[uxIndex]);
+            }
+            pxProfiles[uxCount++] = xSlots[uxIndex].xProfile;
+        }
+        (void)xTaskResumeAll();
+    }
+
+    return uxCount;
+}
+
+/**
+* @brief Get the size and the peak use of the main stack.
+* @param *puSize Receives the size, in words.
+* @param *puPeak Receives the peak use, in words. It equals the size when the
+*        whole stack was used, the stack may have overflowed.
+* @retval void
+*/
+void vStackProfilerMainStack(uint32_t *puSize, uint32_t *puPeak)
+{
+    uint32_t *puWord = puMainStackBottom;
+
+    *puSize = (uint32_t)&_Min_Stack_Size / sizeof(uint32_t);
+    while (puWord < &_estack && *puWord == STACK_FILL_WORD)
+    {
+        puWord++;
+    }
+    *puPeak = (uint32_t)(&_estack - puWord);
+}
+
+/**
+* @brief Recommended stack size for a peak use: the peak plus
+*        STACK_PROFILER_MARGIN_PCT, at least STACK_PROFILER_MIN_MARGIN words,
+*        rounded up to STACK_ROUND_WORDS.
+* @param uPeak Peak use, in words.
+* @retval Recommended size, in words.
+*/
+uint32_t uStackProfilerRecommend(uint32_t uPeak)
+{
+    uint32_t uMargin = uPeak * STACK_PROFILER_MARGIN_PCT / 100;
+
+    if (uMargin < STACK_PROFILER_MIN_MARGIN)
+    {
+        uMargin = STACK_PROFILER_MIN_MARGIN;
+    }
+
+    return (uPeak + uMargin + STACK_ROUND_WORDS - 1) / STACK_ROUND_WORDS * STACK_ROUND_WORDS;
+}
+
+/**
+* @brief FreeRTOS stack overflow hook, configCHECK_FOR_STACK_OVERFLOW is 2 in
+*        profiling mode. The task name is kept for the debugger.
+* @param xTask Task that overflowed its stack.
+* @param *pcTaskName Its name.
+* @retval void
+*/
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
+{
+    (void)xTask;
+    pcStackOverflowTask = pcTaskName;
+    Error_Handler();
+}
+
+#endif
@@ -8,9 +8,14 @@
 
 #include "stm32f4xx_it.h"
 #include "bspPwm.h"
+#include "appConfig.h"
+#include "irqProfiler.h"
+#include "traceRecorder.h"
 
 extern TIM_HandleTypeDef htim9;
 extern UART_HandleTypeDef consoleHandle;
+extern DMA_HandleTypeDef consoleDmaRxHandle;
+extern DMA_HandleTypeDef consoleDmaTxHandle;
 
 /******************************************************************************/
 /*           Cortex-M4 Processor Interruption and Exception Handlers          */
@@ -72,7 +77,9 @@ void DebugMon_Handler(void){}
 */
 void TIM1_BRK_TIM9_IRQHandler(void)
 {
-  HAL_TIM_IRQHandler(&htim9);
+    IRQ_PROFILE_ENTER(uIrqProfilerTimUpdateLatency(TIM9));
+    HAL_TIM_IRQHandler(&htim9);
+    IRQ_PROFILE_EXIT(IRQ_PROFILE_TIM9);
 }
 
 /**
@@ -80,17 +87,48 @@ void TIM1_BRK_TIM9_IRQHandler(void)
 */
 void USART1_IRQHandler(void)
 {
+    /* The UART does not timestamp its events, only the duration is known */
+    IRQ_PROFILE_ENTER(IRQ_PROFILE_NO_LATENCY);
+    TRACE_ISR_ENTER();
     HAL_UART_IRQHandler(&consoleHandle);
+    TRACE_ISR_EXIT();
+    IRQ_PROFILE_EXIT(IRQ_PROFILE_USART1);
 }
 
+#if (CONSOLE_RX_DMA_EN == 1)
+/**
+* @brief This function handles DMA2 stream 2 interrupts (console RX).
+*/
+void DMA2_Stream2_IRQHandler(void)
+{
+    TRACE_ISR_ENTER();
+    HAL_DMA_IRQHandler(&consoleDmaRxHandle);
+    TRACE_ISR_EXIT();
+}
+#endif
+
+#if (CONSOLE_TX_DMA_EN == 1)
+/**
+* @brief This function handles DMA2 stream 7 interrupts (console TX).
+*/
+void DMA2_Stream7_IRQHandler(void)
+{
+    TRACE_ISR_ENTER();
+    HAL_DMA_IRQHandler(&consoleDmaTxHandle);
+    TRACE_ISR_EXIT();
+}
+#endif
+
 /**
 * @brief This function handles TIM2 interrupts.
 */
 void TIM2_IRQHandler(void)
 {
+    IRQ_PROFILE_ENTER(uIrqProfilerTimCompareLatency(TIM2));
     TIM_HandleTypeDef* pwmTimHandler = bspPwmGetHandler();
     if (pwmTimHandler)
     {
         HAL_TIM_IRQHandler(pwmTimHandler);
     }
+    IRQ_PROFILE_EXIT(IRQ_PROFILE_TIM2);
 }
@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ * @file         taskSnapshot.c
+ * @author       Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief        Preallocated, double buffered snapshot of the state of all
+ *               tasks. A refresh fills the buffer readers are not using and
+ *               publishes it at once, so readers always see every task as of
+ *               the same refresh and nothing is allocated.
+ ******************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "string.h"
+#include "stm32f4xx.h"
+#include "appConfig.h"
+#include "taskSnapshot.h"
+
+static TaskSnapshot_t xSnapshots[2];
+static UBaseType_t uxReaders[2];
+static UBaseType_t uxPublished;
+static BaseType_t xRefreshing;
+
+/* Handles of the existing tasks, kept by the traceTASK_CREATE and
+*  traceTASK_DELETE hooks so tasks can be read one at a time.
+*/
+static TaskHandle_t xTaskRegistry[TASK_SNAPSHOT_MAX_TASKS];
+static UBaseType_t uxRegisteredTasks;
+static volatile uint32_t uRegistryChanges;
+
+/**
+* @brief Copy the name of a task into the snapshot, the task may be deleted
+*        while the snapshot is read. Called with the scheduler suspended.
+* @param *pxSnapshot Snapshot to be updated.
+* @param uxIndex Task index in the snapshot.
+* @retval void
+*/
+static void prvCopyTaskName(TaskSnapshot_t *pxSnapshot, UBaseType_t uxIndex)
+{
+    strncpy(pxSnapshot->cTaskNames[uxIndex], pxSnapshot->xTasks[uxIndex].pcTaskName,
+            configMAX_TASK_NAME_LEN - 1);
+    pxSnapshot->cTaskNames[uxIndex][configMAX_TASK_NAME_LEN - 1] = '\0';
+    pxSnapshot->xTasks[uxIndex].pcTaskName = pxSnapshot->cTaskNames[uxIndex];
+}
+
+#if (TASK_SNAPSHOT_PER_TASK_EN == 1)
+/**
+* @brief Read the registered tasks one at a time. The scheduler is only
+*        suspended while one task is read, which keeps the task alive and
+*        bounds the time other tasks wait to one task stack scan.
+* @param *pxSnapshot Snapshot to be filled.
+* @param xGetFreeStackSpace pdTRUE to scan the stacks for their high water mark.
+* @retval void
+*/
+static void prvReadTasks(TaskSnapshot_t *pxSnapshot, BaseType_t xGetFreeStackSpace)
+{
+    UBaseType_t uxIndex = 0;
+    BaseType_t xMore = pdTRUE;
+    uint32_t uStart;
+    uint32_t uCycles;
+
+    pxSnapshot->uMaxLockCycles = 0;
+
+    while (xMore == pdTRUE)
+    {
+        uStart = DWT->CYCCNT;
+        vTaskSuspendAll();
+        xMore = (uxIndex < uxRegisteredTasks) ? pdTRUE : pdFALSE;
+        if (xMore == pdTRUE)
+        {
+            vTaskGetInfo(xTaskRegistry[uxIndex], &pxSnapshot->xTasks[uxIndex], xGetFreeStackSpace, eInvalid);
+            prvCopyTaskName(pxSnapshot, uxIndex);
+            uxIndex++;
+        }
+        (void)xTaskResumeAll();
+
+        uCycles = DWT->CYCCNT - uStart;
+        if (uCycles > pxSnapshot->uMaxLockCycles)
+        {
+            pxSnapshot->uMaxLockCycles = uCycles;
+        }
+    }
+
+    pxSnapshot->uxCount = uxIndex;
+    pxSnapshot->uTotalRunTime = portGET_RUN_TIME_COUNTER_VALUE();
+    pxSnapshot->uxMissed = uxTaskGetNumberOfTasks() - uxIndex;
+    pxSnapshot->xFreeStackSpace = xGetFreeStackSpace;
+}
+#else
+/**
+* @brief Read all the tasks with uxTaskGetSystemState(), which suspends the
+*        scheduler while it walks every task list and always scans the stacks.
+* @param *pxSnapshot Snapshot to be filled.
+* @param xGetFreeStackSpace Not used, the stacks are always scanned.
+* @retval void
+*/
+static void prvReadTasks(TaskSnapshot_t *pxSnapshot, BaseType_t xGetFreeStackSpace)
+{
+    UBaseType_t uxIndex;
+    uint32_t uStart;
+
+    uStart = DWT->CYCCNT;
+    vTaskSuspendAll();
+    pxSnapshot->uxCount = uxTaskGetSystemState(pxSnapshot->xTasks, TASK_SNAPSHOT_MAX_TASKS,
+                                               &pxSnapshot->uTotalRunTime);
+    for (uxIndex = 0; uxIndex < pxSnapshot->uxCount; uxIndex++)
+    {
+        prvCopyTaskName(pxSnapshot, uxIndex);
+    }
+    /* Nothing is reported when the tasks do not fit */
+    pxSnapshot->uxMissed = (pxSnapshot->uxCount == 0) ? uxTaskGetNumberOfTasks() : 0;
+    (void)xTaskResumeAll();
+    pxSnapshot->uMaxLockCycles = DWT->CYCCNT - uStart;
+    pxSnapshot->xFreeStackSpace = pdTRUE;
+    (void)xGetFreeStackSpace;
+}
+#endif
+
+/**
+* @brief Take a new snapshot of all the tasks, without allocating memory.
+* @param xGetFreeStackSpace pdTRUE to fill the stack high water marks. Each
+*        one scans a task stack, a refresh that only needs run times passes
+*        pdFALSE.
+* @retval pdPASS if a new snapshot was published, pdFAIL if another refresh is
+*         in progress or readers still hold the buffer to be refreshed.
+*/
+BaseType_t xTaskSnapshotRefresh(BaseType_t xGetFreeStackSpace)
+{
+    TaskSnapshot_t *pxSnapshot;
+    UBaseType_t uxBuffer;
+    uint32_t uStart;
+    uint32_t uRegistryVersion;
+    uint8_t uRetries = 0;
+
+    taskENTER_CRITICAL();
+    uxBuffer = uxPublished ^ 1;
+    if (xRefreshing == pdTRUE || uxReaders[uxBuffer] != 0)
+    {
+        taskEXIT_CRITICAL();
+        return pdFAIL;
+    }
+    xRefreshing = pdTRUE;
+    taskEXIT_CRITICAL();
+
+    /* Timed with the DWT cycle counter, started by bspInit() */
+    uStart = DWT->CYCCNT;
+
+    /* Tasks deleted during the walk reorder the registry, walk it again so
+    *  no task is skipped or reported twice.
+    */
+    pxSnapshot = &xSnapshots[uxBuffer];
+    do
+    {
+        uRegistryVersion = uRegistryChanges;
+        prvReadTasks(pxSnapshot, xGetFreeStackSpace);
+    } while (uRegistryVersion != uRegistryChanges && ++uRetries < 2);
+    pxSnapshot->uRefreshCycles = DWT->CYCCNT - uStart;
+
+    /* Publish the new snapshot, new readers get it from now on */
+    taskENTER_CRITICAL();
+    pxSnapshot->uSequence = xSnapshots[uxPublished].uSequence + 1;
+    uxPublished = uxBuffer;
+    xRefreshing = pdFALSE;
+    taskEXIT_CRITICAL();
+
+    return pdPASS;
+}
+
+/**
+* @brief Get the latest snapshot. It stays unchanged until it is released.
+* @param void
+* @retval Latest snapshot, empty if no refresh has been done.
+*/
+const TaskSnapshot_t *pxTaskSnapshotAcquire(void)
+{
+    const TaskSnapshot_t *pxSnapshot;
+
+    taskENTER_CRITICAL();
+    uxReaders[uxPublished]++;
+    pxSnapshot = &xSnapshots[uxPublished];
+    taskEXIT_CRITICAL();
+
+    return pxSnapshot;
+}
+
+/**
+* @brief Release a snapshot obtained with pxTaskSnapshotAcquire().
+* @param *pxSnapshot Snapshot to be released.
+* @retval void
+*/
+void vTaskSnapshotRelease(const TaskSnapshot_t *pxSnapshot)
+{
+    taskENTER_CRITICAL();
+    uxReaders[pxSnapshot - xSnapshots]--;
+    taskEXIT_CRITICAL();
+}
+
+/**
+* @brief traceTASK_CREATE hook, called by the kernel in a critical section.
+* @param *pvTask Handle of the new task.
+* @retval void
+*/
+void vTaskSnapshotTaskCreated(void *pvTask)
+{
+    if (uxRegisteredTasks < TASK_SNAPSHOT_MAX_TASKS)
+    {
+        xTaskRegistry[uxRegisteredTasks++] = (TaskHandle_t)pvTask;
+    }
+    uRegistryChanges++;
+}
+
+/**
+* @brief traceTASK_DELETE hook, called by the kernel in a critical section.
+* @param *pvTask Handle of the deleted task.
+* @retval void
+*/
+void vTaskSnapshotTaskDeleted(void *pvTask)
+{
+    UBaseType_t uxIndex;
+
+    for (uxIndex = 0; uxIndex < uxRegisteredTasks; uxIndex++)
+    {
+        if (xTaskRegistry[uxIndex] == (TaskHandle_t)pvTask)
+        {
+            /* Keep the registry packed, the last task takes the free slot */
+            xTaskRegistry[uxIndex] = xTaskRegistry[--uxRegisteredTasks];
+            break;
+        }
+    }
+    uRegistryChanges++;
+}
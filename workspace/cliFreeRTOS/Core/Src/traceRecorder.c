@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ * @file         traceRecorder.c
+ * @author       Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief        Kernel event trace recorder. The FreeRTOS trace hooks and the
+ *               interrupt handlers write 8 byte timestamped events into a RAM
+ *               ring, the oldest events are overwritten. The trace command
+ *               streams the ring in binary, tools/traceDecoder converts it to
+ *               a Chrome trace JSON file.
+ *
+ *               Stream: header | task table | events, little endian
+ *               Header: "FRTR" | version | event size | tasks | name length |
+ *                       CPU Hz (4) | events (4) | events lost (4)
+ *               Task  : task number (2) | name (name length)
+ ******************************************************************************
+ */
+
+#include "FreeRTOS.h"
+#include "FreeRTOS_CLI.h"
+#include "task.h"
+#include "queue.h"
+#include "string.h"
+#include "stm32f4xx.h"
+#include "appConfig.h"
+#include "taskSnapshot.h"
+#include "traceRecorder.h"
+
+#if (TRACE_RECORDER_EN == 1)
+
+#if ((TRACE_BUFFER_EVENTS & (TRACE_BUFFER_EVENTS - 1)) != 0)
+#error "TRACE_BUFFER_EVENTS must be a power of two"
+#endif
+
+#define TRACE_STREAM_VERSION                2 /* 2: queues by queue number */
+#define TRACE_HEADER_LEN                    20
+#define TRACE_TASK_RECORD_LEN               (2 + configMAX_TASK_NAME_LEN)
+
+static TraceEvent_t xTraceEvents[TRACE_BUFFER_EVENTS];
+static uint32_t uTraceWrites;       /* Events written since the trace started */
+static volatile BaseType_t xTraceRunning;
+static UBaseType_t uxTraceQueues;     /* Queue numbers given so far */
+
+/**
+* @brief Write a 32 bit value, least significant byte first.
+* @param *pucOut Output buffer.
+* @param uValue Value to be written.
+* @retval void
+*/
+static void prvPutU32(uint8_t *pucOut, uint32_t uValue)
+{
+    pucOut[0] = (uint8_t)uValue;
+    pucOut[1] = (uint8_t)(uValue >> 8);
+    pucOut[2] = (uint8_t)(uValue >> 16);
+    pucOut[3] = (uint8_t)(uValue >> 24);
+}
+
+/**
+* @brief Record one event. Called by the kernel trace hooks, from tasks with
+*        interrupts masked and from interrupt handlers.
+* @param uType Event type, see TraceEventType_e.
+* @param uAux Event data, depends on the type.
+* @param usObject Task, queue or exception the event refers to.
+* @retval void
+*/
+void vTraceRecord(uint8_t uType, uint8_t uAux, uint16_t usObject)
+{
+    TraceEvent_t *pxEvent;
+    UBaseType_t uxSavedMask;
+
+    if (xTraceRunning == pdFALSE)
+    {
+        return;
+    }
+
+    /* Interrupts that nest would otherwise take the same slot */
+    uxSavedMask = portSET_INTERRUPT_MASK_FROM_ISR();
+    pxEvent = &xTraceEvents[uTraceWrites & (TRACE_BUFFER_EVENTS - 1)];
+    uTraceWrites++;
+    pxEvent->uTimestamp = DWT->CYCCNT;
+    pxEvent->uType = uType;
+    pxEvent->uAux = uAux;
+    pxEvent->usObject = usObject;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(uxSavedMask);
+}
+
+/**
+* @brief traceQUEUE_CREATE hook, numbers the queues, semaphores and mutexes in
+*        creation order. Queue events are recorded with this number.
+* @param *pvQueue Handle of the new queue.
+* @retval void
+*/
+void vTraceQueueCreated(void *pvQueue)
+{
+    taskENTER_CRITICAL();
+    vQueueSetQueueNumber((QueueHandle_t)pvQueue, ++uxTraceQueues);
+    taskEXIT_CRITICAL();
+}
+
+/**
+* @brief Clear the ring and start recording.
+* @param void
+* @retval void
+*/
+void vTraceStart(void)
+{
+    taskENTER_CRITICAL();
+    uTraceWrites = 0;
+    xTraceRunning = pdTRUE;
+    taskEXIT_CRITICAL();
+}
+
+/**
+* @brief Stop recording, the ring keeps the last events.
+* @param void
+* @retval void
+*/
+void vTraceStop(void)
+{
+    xTraceRunning = pdFALSE;
+}
+
+/**
+* @brief Check whether events are being recorded.
+* @param void
+* @retval pdTRUE if the recorder is running.
+*/
+BaseType_t xTraceIsRunning(void)
+{
+    return xTraceRunning;
+}
+
+/**
+* @brief Get the number of events in the ring.
+* @param void
+* @retval Events that a stream would contain.
+*/
+uint32_t uTraceGetEventCount(void)
+{
+    return (uTraceWrites < TRACE_BUFFER_EVENTS) ? uTraceWrites : TRACE_BUFFER_EVENTS;
+}
+
+/**
+* @brief Stop recording and write the header, the task names and the events,
+*        oldest first, to a sink.
+* @param *pxSink FreeRTOS CLI output sink.
+* @retval pdPASS if the whole stream was written, otherwise pdFAIL.
+*/
+BaseType_t xTraceStream(CLI_Output_Sink_t *pxSink)
+{
+    const TaskSnapshot_t *pxSnapshot;
+    uint8_t ucRecord[TRACE_HEADER_LEN];
+    uint32_t uCount;
+    uint32_t uFirst;
+    UBaseType_t uxIndex;
+    BaseType_t xReturn;
+
+    vTraceStop();
+    uCount = uTraceGetEventCount();
+    uFirst = (uTraceWrites - uCount) & (TRACE_BUFFER_EVENTS - 1);
+
+    /* Task numbers are turned into names on the host, tasks deleted since
+    *  the events were recorded are shown by number.
+    */
+    (void)xTaskSnapshotRefresh(pdFALSE);
+    pxSnapshot = pxTaskSnapshotAcquire();
+
+    memcpy(ucRecord, "FRTR", 4);
+    ucRecord[4] = TRACE_STREAM_VERSION;
+    ucRecord[5] = sizeof(TraceEvent_t);
+    ucRecord[6] = (uint8_t)pxSnapshot->uxCount;
+    ucRecord[7] = configMAX_TASK_NAME_LEN;
+    prvPutU32(&ucRecord[8], SystemCoreClock);
+    prvPutU32(&ucRecord[12], uCount);
+    prvPutU32(&ucRecord[16], uTraceWrites - uCount);
+    xReturn = FreeRTOS_CLIWrite(pxSink, (const char *)ucRecord, TRACE_HEADER_LEN);
+
+    for (uxIndex = 0; uxIndex < pxSnapshot->uxCount && xReturn == pdPASS; uxIndex++)
+    {
+        memset(ucRecord, 0x00, TRACE_TASK_RECORD_LEN);
+        ucRecord[0] = (uint8_t)pxSnapshot->xTasks[uxIndex].xTaskNumber;
+        ucRecord[1] = (uint8_t)(pxSnapshot->xTasks[uxIndex].xTaskNumber >> 8);
+        strncpy((char *)&ucRecord[2], pxSnapshot->xTasks[uxIndex].pcTaskName, configMAX_TASK_NAME_LEN);
+        xReturn = FreeRTOS_CLIWrite(pxSink, (const char *)ucRecord, TRACE_TASK_RECORD_LEN);
+    }
+    vTaskSnapshotRelease(pxSnapshot);
+
+    /* Cortex-M is little endian, events are written as they are stored */
+    if (xReturn == pdPASS && uFirst + uCount > TRACE_BUFFER_EVENTS)
+    {
+        xReturn = FreeRTOS_CLIWrite(pxSink, (const char *)&xTraceEvents[uFirst],
+                                    (TRACE_BUFFER_EVENTS - uFirst) * sizeof(TraceEvent_t));
+        uCount -= TRACE_BUFFER_EVENTS - uFirst;
+        uFirst = 0;
+    }
+    if (xReturn == pdPASS)
+    {
+        xReturn = FreeRTOS_CLIWrite(pxSink, (const char *)&xTraceEvents[uFirst],
+                                    uCount * sizeof(TraceEvent_t));
+    }
+    FreeRTOS_CLIFlush(pxSink);
+
+    return xReturn;
+}
+
+#endif
@@ -15,5 +15,7 @@
 #include "bspRtc.h"
 
 BspError_e bspInit(void);
+void bspCycleCounterInit(void);
+uint64_t bspGetCycleCount64(void);
 
 #endif
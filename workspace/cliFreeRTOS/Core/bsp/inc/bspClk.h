@@ -15,5 +15,6 @@
 #include "stm32f4xx_hal.h"
 
 void bspGetClockIinfo(char *pcWriteBuffer, size_t xWriteBufferLen);
+uint32_t bspGetApb1TimerClock(void);
 
 #endif
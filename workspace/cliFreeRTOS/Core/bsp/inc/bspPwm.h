@@ -22,9 +22,20 @@ typedef enum
     MAX_PWM_CH,
 } pwmChannels_e;
 
+/* Prescaler and period of the PWM timer for a frequency */
+typedef struct
+{
+    uint32_t uPrescaler;        /* PSC, the timer clock is divided by uPrescaler + 1   */
+    uint32_t uPeriod;           /* ARR, a PWM period is uPeriod + 1 counts (duty steps) */
+    uint32_t uFreq;             /* Achieved frequency, integer part in Hz              */
+    uint32_t uFreqMilli;        /* Achieved frequency, thousandths of Hz               */
+} PwmTiming_t;
+
 BspError_e bspPwmInit(void);
 TIM_HandleTypeDef* bspPwmGetHandler(void);
+BspError_e bspPwmSolveTiming(uint32_t uTimerClock, uint32_t uFreq, uint32_t uMaxPeriod, PwmTiming_t *pxTiming);
 BspError_e bspPwmSetFreq(uint32_t uNewFreq);
+void bspPwmGetTiming(PwmTiming_t *pxTiming);
 void bspPwmStart(pwmChannels_e eChannelIndex);
 BspError_e bspPwmSetDuty(uint8_t uNewDuty, pwmChannels_e xChannel);
 
@@ -11,7 +11,11 @@
 #include "appConfig.h"
 
 UART_HandleTypeDef consoleHandle;
+DMA_HandleTypeDef consoleDmaRxHandle;
+DMA_HandleTypeDef consoleDmaTxHandle;
+#if (RUN_TIME_STATS_CLOCK_DWT == 0)
 TIM_HandleTypeDef xTimStatsHandler;
+#endif
 
 /**
 * @brief Initialize system clocks, PLL and Clock dividers.
@@ -69,6 +73,52 @@ static BspError_e bspHearBeatInit(void)
     return BSP_NO_ERROR;
 }
 
+/**
+* @brief Start the Cortex-M4 DWT cycle counter, used for FreeRTOS task
+*        statistics and to time code.
+* @param void
+* @retval void
+*/
+void bspCycleCounterInit(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0)
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+/**
+* @brief Get the DWT cycle counter extended to 64 bits. The 32 bit counter
+*        wraps every 2^32 cycles (about 53s at 80MHz), it must be read at least
+*        once in that time. FreeRTOS reads it at every context switch.
+* @param void
+* @retval CPU cycles since the cycle counter was started.
+*/
+uint64_t bspGetCycleCount64(void)
+{
+    static uint32_t uHigh;
+    static uint32_t uLastLow;
+    uint32_t uPrimask = __get_PRIMASK();
+    uint32_t uLow;
+    uint64_t uCount;
+
+    /* Called from tasks and from the context switch, keep the two words in step */
+    __disable_irq();
+    uLow = DWT->CYCCNT;
+    if (uLow < uLastLow)
+    {
+        uHigh++;
+    }
+    uLastLow = uLow;
+    uCount = ((uint64_t)uHigh << 32) | uLow;
+    __set_PRIMASK(uPrimask);
+
+    return uCount;
+}
+
+#if (RUN_TIME_STATS_CLOCK_DWT == 0)
 /**
 * @brief Configure timer used for FreeRTOS task statistics
 * @param void
@@ -99,6 +149,7 @@ uint32_t bspGetTimStatsCount(void)
 {
     return __HAL_TIM_GET_COUNTER(&xTimStatsHandler);
 }
+#endif
 
 /**
 * @brief Initialize UART frame.
@@ -140,6 +191,8 @@ BspError_e bspInit(void)
     if (bspError != BSP_NO_ERROR)
         goto out_bsp_init;
 
+    bspCycleCounterInit();
+
     bspError = bspConsoleInit();
     if (bspError != BSP_NO_ERROR)
         goto out_bsp_init;
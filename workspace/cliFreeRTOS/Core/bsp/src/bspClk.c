@@ -8,6 +8,20 @@
 
 #include "bspClk.h"
 
+/**
+* @brief Gets the clock of the APB1 timers. They run at twice PCLK1 when
+*        the APB1 prescaler divides HCLK.
+* @param void
+* @retval APB1 timer clock in Hz.
+*/
+uint32_t bspGetApb1TimerClock(void)
+{
+    uint32_t uPCLK1 = HAL_RCC_GetPCLK1Freq();
+    uint32_t APB1CLKDivider = (uint32_t)(RCC->CFGR & RCC_CFGR_PPRE1);
+
+    return (APB1CLKDivider > RCC_CFGR_PPRE1_DIV1) ? (uPCLK1 * 2) : uPCLK1;
+}
+
 /**
 * @brief Gets system clock, PCLKx and CLK dividers.
 * @param *pcWriteBuffer pointer to buffer where clock information
@@ -20,7 +34,6 @@ void bspGetClockIinfo(char *pcWriteBuffer, size_t xWriteBufferLen)
     uint32_t uPCLK1;
     uint32_t uPCLK2;
     uint32_t uSysClock;
-    uint32_t APB1CLKDivider;
     uint32_t APB2CLKDivider;
     uint32_t APB1TimerClocks;
     uint32_t APB2TimerClocks;
@@ -32,9 +45,8 @@ void bspGetClockIinfo(char *pcWriteBuffer, size_t xWriteBufferLen)
     uPCLK1 = HAL_RCC_GetPCLK1Freq();
     uPCLK2 = HAL_RCC_GetPCLK2Freq();
     /* Calculate APB1 and APB2*/
-    APB1CLKDivider = (uint32_t)(RCC->CFGR & RCC_CFGR_PPRE1);
     APB2CLKDivider = (uint32_t)(RCC->CFGR & RCC_CFGR_PPRE2);
-    APB1TimerClocks = (APB1CLKDivider > RCC_CFGR_PPRE1_DIV1) ? (uPCLK1 * 2) : uPCLK1;
+    APB1TimerClocks = bspGetApb1TimerClock();
     APB2TimerClocks = (APB2CLKDivider > RCC_CFGR_PPRE1_DIV1) ? (uPCLK2 * 2) : uPCLK2;
 
     snprintf(pcWriteBuffer, xWriteBufferLen,
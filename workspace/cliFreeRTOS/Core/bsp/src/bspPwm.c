@@ -8,12 +8,14 @@
  */
 
 #include "bspPwm.h"
+#include "bspClk.h"
 #include "stm32f4xx_hal.h"
 #include "stdint.h"
 #include "appConfig.h"
 
 #define PWM_MAX_CHANNELS                4
-#define PWM_DEFAULT_FREQ                1000 /* 1kHz when clk is 1Mhz */
+#define PWM_DEFAULT_FREQ                1000 /* Hz */
+#define PWM_MAX_PRESCALER               0xFFFF
 
 typedef struct
 {
@@ -28,22 +30,26 @@ typedef struct
     Pwm_TIM_OC_InitTypeDef uChannelXConfig[PWM_MAX_CHANNELS];
 }PwmConfigStruct;
 
+static PwmTiming_t xPwmTiming;
+
 PwmConfigStruct pwmConfigStruct =
 {
     {
         PWM_TIM_INSTANCE,                               /* Timer instance */
         {   /* TIM_Base_InitTypeDef */
-            40,                                         /* Prescaler */
+            0,                                          /* Prescaler, set by bspPwmInit() */
             TIM_COUNTERMODE_UP,                         /* Counter mode */
-            PWM_DEFAULT_FREQ - 1,                                   /* Period */
-            TIM_CLOCKDIVISION_DIV1                      /* Clock division */
+            0,                                          /* Period, set by bspPwmInit() */
+            TIM_CLOCKDIVISION_DIV1,                     /* Clock division */
+            0,                                          /* Repetition counter, not in TIM2 */
+            TIM_AUTORELOAD_PRELOAD_ENABLE               /* ARR is applied at the update event */
         }
     },
     {
         {   /* Channel 1 */
             {
                 TIM_OCMODE_PWM1,                         /* Specifies the TIM mode */
-                ( (PWM_DEFAULT_FREQ - 1) * 50 ) / 100,   /* Pulse value */
+                0,                                       /* Pulse value, set by bspPwmInit() */
                 TIM_OCNPOLARITY_HIGH,                    /* Output polarity */
             },
             TIM_CHANNEL_1,                               /* Channel number */
@@ -52,7 +58,7 @@ PwmConfigStruct pwmConfigStruct =
         {   /* Channel 2 */
             {
                 TIM_OCMODE_PWM1,                        /* Specifies the TIM mode */
-                ( (PWM_DEFAULT_FREQ - 1) * 50 ) / 100,  /* Pulse value */
+                0,                                      /* Pulse value, set by bspPwmInit() */
                 TIM_OCNPOLARITY_HIGH,                   /* Output polarity */
             },
             TIM_CHANNEL_2,                              /* Channel number */
@@ -61,7 +67,7 @@ PwmConfigStruct pwmConfigStruct =
         {   /* Channel 3 */
             {
                 TIM_OCMODE_PWM1,                        /* Specifies the TIM mode */
-                ( (PWM_DEFAULT_FREQ - 1) * 50 ) / 100,  /* Pulse value */
+                0,                                      /* Pulse value, set by bspPwmInit() */
                 TIM_OCNPOLARITY_HIGH,                   /* Output polarity */
             },
             TIM_CHANNEL_3,                              /* Channel number */
@@ -70,7 +76,7 @@ PwmConfigStruct pwmConfigStruct =
         {   /* Channel 4 */
             {
                 TIM_OCMODE_PWM1,                        /* Specifies the TIM mode */
-                ( (PWM_DEFAULT_FREQ - 1) * 50 ) / 100,  /* Pulse value */
+                0,                                      /* Pulse value, set by bspPwmInit() */
                 TIM_OCNPOLARITY_HIGH,                   /* Output polarity */
             },
             TIM_CHANNEL_4,                              /* Channel number */
@@ -90,6 +96,64 @@ TIM_HandleTypeDef* bspPwmGetHandler(void)
     return &pwmConfigStruct.xTimHandle;
 }
 
+/**
+* @brief Compare value of a duty cycle, 100% keeps the output high.
+* @param uPeriod ARR value
+* @param uDuty Duty cycle in percent
+* @retval CCR value
+*/
+static uint32_t prvPwmPulse(uint32_t uPeriod, uint8_t uDuty)
+{
+    return (uint32_t)(((uint64_t)uPeriod + 1) * uDuty / 100);
+}
+
+/**
+* @brief Finds the prescaler and period of a frequency with integer math
+*        only. The smallest prescaler that fits the period in ARR gives the
+*        most duty steps, the period is then rounded to the nearest count.
+* @param uTimerClock Timer input clock in Hz
+* @param uFreq Wanted frequency in Hz, at least 2 timer counts per period
+* @param uMaxPeriod Largest ARR value of the timer
+* @param *pxTiming Receives the prescaler, the period and the achieved frequency
+* @retval BSP status
+*/
+BspError_e bspPwmSolveTiming(uint32_t uTimerClock, uint32_t uFreq, uint32_t uMaxPeriod, PwmTiming_t *pxTiming)
+{
+    uint64_t uCounts;
+    uint64_t uDivider;
+    uint64_t uTicks;
+
+    if (uFreq < 1 || uFreq > uTimerClock / 2)
+        return BSP_ERROR_EINVAL;
+
+    /* Timer counts of one period, rounded to the nearest */
+    uCounts = ((uint64_t)uTimerClock + uFreq / 2) / uFreq;
+    uDivider = (uCounts - 1) / ((uint64_t)uMaxPeriod + 1) + 1;
+    if (uDivider - 1 > PWM_MAX_PRESCALER)
+        return BSP_ERROR_EINVAL;
+
+    uTicks = ((uint64_t)uTimerClock + uDivider * uFreq / 2) / (uDivider * uFreq);
+    if (uTicks - 1 > uMaxPeriod)
+        uTicks = (uint64_t)uMaxPeriod + 1;
+
+    pxTiming->uPrescaler = (uint32_t)(uDivider - 1);
+    pxTiming->uPeriod = (uint32_t)(uTicks - 1);
+    pxTiming->uFreq = (uint32_t)(uTimerClock / (uDivider * uTicks));
+    pxTiming->uFreqMilli = (uint32_t)((uTimerClock % (uDivider * uTicks)) * 1000 / (uDivider * uTicks));
+
+    return BSP_NO_ERROR;
+}
+
+/**
+* @brief Gets the prescaler, the period and the achieved frequency in use.
+* @param *pxTiming Receives the timing
+* @retval void
+*/
+void bspPwmGetTiming(PwmTiming_t *pxTiming)
+{
+    *pxTiming = xPwmTiming;
+}
+
 /**
 * @brief Starts a PWM cannel.
 * @param eChannelIdex BSP channel number
@@ -99,16 +163,17 @@ void bspPwmStart(pwmChannels_e eChannelIndex)
 {
     switch (eChannelIndex)
     {
-        case  PWM_CH_1: HAL_TIM_OC_Start_IT(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_1); break;
-        case  PWM_CH_2: HAL_TIM_OC_Start_IT(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_2); break;
-        case  PWM_CH_3: HAL_TIM_OC_Start_IT(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_3); break;
-        case  PWM_CH_4: HAL_TIM_OC_Start_IT(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_4); break;
+        case  PWM_CH_1: HAL_TIM_PWM_Start(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_1); break;
+        case  PWM_CH_2: HAL_TIM_PWM_Start(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_2); break;
+        case  PWM_CH_3: HAL_TIM_PWM_Start(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_3); break;
+        case  PWM_CH_4: HAL_TIM_PWM_Start(&pwmConfigStruct.xTimHandle, TIM_CHANNEL_4); break;
         default: break;
     }
 }
 
 /**
-* @brief Sets a new frequency
+* @brief Sets a new frequency, applied by the timer at the end of the running
+*        period without stopping the channels.
 * @param uNewFreq Frequency to be set
 * @retval BSP status
 * @note 1 decimal value = 1Hz
@@ -116,40 +181,33 @@ void bspPwmStart(pwmChannels_e eChannelIndex)
 BspError_e bspPwmSetFreq(uint32_t uNewFreq)
 {
     int i;
-    float period;
-    HAL_StatusTypeDef halStatus;
+    PwmTiming_t xTiming;
+    BspError_e bspError;
+    TIM_HandleTypeDef *pxTimHandle = &pwmConfigStruct.xTimHandle;
 
-    if (uNewFreq < 1)
-        return BSP_ERROR_EINVAL;
-
-    /* Period is scaled by 1000000 because count unit is 1us */
-    period = (1 / (float)uNewFreq) * 1000000;
-    pwmConfigStruct.xTimHandle.Init.Period = period;
+    bspError = bspPwmSolveTiming(bspGetApb1TimerClock(), uNewFreq, PWM_TIM_MAX_PERIOD, &xTiming);
+    if (bspError != BSP_NO_ERROR)
+        return bspError;
 
     /*
-    * In order to change the frequency on run time, the sequence of steps are the following:
-    * Stop PWM channels, configure pulse value, initialize TIM unit and start PWM channels again.
+    * PSC, ARR and CCRx are preloaded (ARPE and OCxPE), the values written here
+    * wait in the preload registers and the next update event moves all of them
+    * to the active registers at the end of the running period. UDIS holds the
+    * update event while they are written so no period mixes old and new values.
+    * The channels keep running and the counter is not reset.
     */
-
-    /* Stop all channels and configure pulse value */
+    pxTimHandle->Instance->CR1 |= TIM_CR1_UDIS;
+    __HAL_TIM_SET_PRESCALER(pxTimHandle, xTiming.uPrescaler);
+    pxTimHandle->Init.Prescaler = xTiming.uPrescaler;
+    __HAL_TIM_SET_AUTORELOAD(pxTimHandle, xTiming.uPeriod);
     for( i = 0; i < PWM_MAX_CHANNELS; i++)
     {
-       HAL_TIM_OC_Stop_IT(&pwmConfigStruct.xTimHandle, pwmConfigStruct.uChannelXConfig[i].channel);
-       pwmConfigStruct.uChannelXConfig[i].xOcInit.Pulse = (period * pwmConfigStruct.uChannelXConfig[i].uDuty) / 100;
-       HAL_TIM_PWM_ConfigChannel(&pwmConfigStruct.xTimHandle, &pwmConfigStruct.uChannelXConfig[i].xOcInit, pwmConfigStruct.uChannelXConfig[i].channel);
+       pwmConfigStruct.uChannelXConfig[i].xOcInit.Pulse = prvPwmPulse(xTiming.uPeriod, pwmConfigStruct.uChannelXConfig[i].uDuty);
+       __HAL_TIM_SET_COMPARE(pxTimHandle, pwmConfigStruct.uChannelXConfig[i].channel,
+                             pwmConfigStruct.uChannelXConfig[i].xOcInit.Pulse);
     }
-
-    /* Initialize TIM unit with new pulse value */
-    halStatus = HAL_TIM_OC_Init(&pwmConfigStruct.xTimHandle);
-    if (halStatus != HAL_OK)
-        return BSP_ERROR_EIO;
-
-    /* Start all PWM channels, it is always called after TIM OC initialization */
-    for( i = 0; i < PWM_MAX_CHANNELS; i++)
-       HAL_TIM_OC_Start_IT(&pwmConfigStruct.xTimHandle, pwmConfigStruct.uChannelXConfig[i].channel);
-
-   /* Clear interrupt to not jump to the interrupt handler */
-    __HAL_TIM_CLEAR_IT(&pwmConfigStruct.xTimHandle, TIM_IT_UPDATE);
+    pxTimHandle->Instance->CR1 &= ~TIM_CR1_UDIS;
+    xPwmTiming = xTiming;
 
     return BSP_NO_ERROR;
 }
@@ -193,7 +251,7 @@ BspError_e bspPwmSetDuty(uint8_t uNewDuty, pwmChannels_e xChannel)
     /* Get auto reload value/pulse value, calculate its percentage and
     *  set new CCR value for comparision.
     */
-    newAutoReloadReg =  (__HAL_TIM_GET_AUTORELOAD(&pwmConfigStruct.xTimHandle) * uNewDuty) / 100;
+    newAutoReloadReg = prvPwmPulse(__HAL_TIM_GET_AUTORELOAD(&pwmConfigStruct.xTimHandle), uNewDuty);
     __HAL_TIM_SET_COMPARE(&pwmConfigStruct.xTimHandle, uChannel, newAutoReloadReg);
 
     return BSP_NO_ERROR;
@@ -208,6 +266,17 @@ BspError_e bspPwmInit(void)
 {
     int i;
     HAL_StatusTypeDef halStatus;
+    BspError_e bspError;
+
+    /* Default frequency from the timer clock set by the clock init */
+    bspError = bspPwmSolveTiming(bspGetApb1TimerClock(), PWM_DEFAULT_FREQ, PWM_TIM_MAX_PERIOD, &xPwmTiming);
+    if (bspError != BSP_NO_ERROR)
+        return bspError;
+    pwmConfigStruct.xTimHandle.Init.Prescaler = xPwmTiming.uPrescaler;
+    pwmConfigStruct.xTimHandle.Init.Period = xPwmTiming.uPeriod;
+    for( i = 0; i < PWM_MAX_CHANNELS; i++)
+        pwmConfigStruct.uChannelXConfig[i].xOcInit.Pulse = prvPwmPulse(xPwmTiming.uPeriod,
+                                                                       pwmConfigStruct.uChannelXConfig[i].uDuty);
 
     /* Configure Timer base unit */
     halStatus = HAL_TIM_OC_Init(&pwmConfigStruct.xTimHandle);
@@ -0,0 +1,56 @@
+/**
+ ******************************************************************************
+ * @file    FreeRTOSConfig.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Kernel configuration of the host benchmarks: the simulator one
+ *          with the heap implementation or the command table chosen by the
+ *          build target.
+ ******************************************************************************
+ */
+
+#ifndef BENCH_FREERTOS_CONFIG_H
+#define BENCH_FREERTOS_CONFIG_H
+
+#include "../inc/FreeRTOSConfig.h"
+
+#if defined(BENCH_HEAP_TLSF)
+/* Set by the build target, heapBench4 or heapBenchTlsf */
+#undef HEAP_TLSF_EN
+#define HEAP_TLSF_EN BENCH_HEAP_TLSF
+#endif
+
+#if defined(BENCH_CLI_COMMANDS)
+/* cliBench registers all of its commands at run time, the index stays at
+*  most half full as in the firmware.
+*/
+#undef configCOMMAND_INT_STATIC_TABLE
+#define configCOMMAND_INT_STATIC_TABLE 0
+#undef configCOMMAND_INT_MAX_COMMANDS
+#define configCOMMAND_INT_MAX_COMMANDS (BENCH_CLI_COMMANDS + 1)
+#undef configCOMMAND_INT_HASH_SIZE
+#define configCOMMAND_INT_HASH_SIZE 1024
+#undef CLI_PERF_EN
+#define CLI_PERF_EN 0
+#endif
+
+/* The heap is benchmarked whatever the memory of the firmware kernel objects */
+#if (STATIC_ALLOCATION_EN == 1)
+#undef configSUPPORT_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION 0
+#undef configSUPPORT_DYNAMIC_ALLOCATION
+#define configSUPPORT_DYNAMIC_ALLOCATION 1
+#undef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE ((size_t)(75 * 524))
+#endif
+#undef STATIC_ALLOCATION_EN
+#define STATIC_ALLOCATION_EN 0
+
+/* The heap array is the one of the heap implementation */
+#undef configAPPLICATION_ALLOCATED_HEAP
+#define configAPPLICATION_ALLOCATED_HEAP 0
+
+/* The benchmark times the calls itself */
+#undef HEAP_PROFILER_EN
+#define HEAP_PROFILER_EN 0
+
+#endif /* BENCH_FREERTOS_CONFIG_H */
@@ -0,0 +1,232 @@
+/**
+ ******************************************************************************
+ * @file    cliBench.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host benchmark of the command lookup of FreeRTOS_CLI.c as the
+ *          command table grows from 12 to BENCH_CLI_COMMANDS commands.
+ *
+ *          Each step executes the registered commands in a random order
+ *          with FreeRTOS_CLISessionExecute(): hash of the name, probe of
+ *          the index, one compare and an empty command. The same names are
+ *          also searched with a linear strlen() and strncmp() walk, the
+ *          lookup of the original interpreter. Every step keeps its fastest
+ *          run, which drops the time the host steals.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_CLI.h"
+
+#define BENCH_LOOKUPS                       100000 /* Commands executed per run */
+#define BENCH_RUNS                          5
+#define BENCH_SEED                          0x2545F491UL
+#define BENCH_NAME_LEN                      12
+
+static const uint32_t uSteps[] = { 12, 50, 100, 200, BENCH_CLI_COMMANDS };
+
+static CLI_Command_Definition_t *pxCommands;  /* Filled at run time, the members are const */
+static char cNames[BENCH_CLI_COMMANDS][BENCH_NAME_LEN];
+static uint16_t usOrder[BENCH_LOOKUPS];
+static volatile uint32_t uExecuted;
+
+/* The benchmark runs without the scheduler, the kernel calls of the CLI do nothing */
+void vTaskSuspendAll(void) { }
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+void vPortEnterCritical(void) { }
+void vPortExitCritical(void) { }
+
+void vSimAssertCalled(const char *pcFile, int iLine)
+{
+    fprintf(stderr, "Assert failed: %s:%d\n", pcFile, iLine);
+    abort();
+}
+
+/**
+ * @brief Read the host time stamp counter, or the monotonic clock in ns
+ *        on hosts without one.
+ * @param void
+ * @retval Time stamp
+ */
+static inline uint64_t prvNow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec xNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &xNow);
+    return (uint64_t)xNow.tv_sec * 1000000000U + xNow.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Next value of a xorshift generator, the same sequence every run.
+ * @param *puState Generator state
+ * @retval Pseudo random value
+ */
+static uint32_t prvRandom(uint32_t *puState)
+{
+    uint32_t uX = *puState;
+
+    uX ^= uX << 13;
+    uX ^= uX >> 17;
+    uX ^= uX << 5;
+    *puState = uX;
+
+    return uX;
+}
+
+/**
+ * @brief Command registered many times, it only counts its calls.
+ */
+static BaseType_t prvBenchCommand(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    uExecuted++;
+    return pdPASS;
+}
+
+/**
+ * @brief Sink of the session, the commands have no output.
+ */
+static BaseType_t prvBenchSinkPut(void *pvContext, const char *pcData, size_t xDataLength)
+{
+    return pdPASS;
+}
+
+/**
+ * @brief Lookup of the original interpreter: every registered command is
+ *        compared until one matches the first word of the command line.
+ * @param *pcCommandInput Command line
+ * @param uCount Registered commands
+ * @retval Command found, or NULL.
+ */
+static const CLI_Command_Definition_t *prvLinearFind(const char *pcCommandInput, uint32_t uCount)
+{
+    const char *pcCommand;
+    size_t xLength;
+    uint32_t i;
+
+    for (i = 0; i < uCount; i++)
+    {
+        pcCommand = pxCommands[i].pcCommand;
+        xLength = strlen(pcCommand);
+        if (strncmp(pcCommandInput, pcCommand, xLength) == 0 &&
+            (pcCommandInput[xLength] == ' ' || pcCommandInput[xLength] == 0x00))
+        {
+            return &pxCommands[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Fastest run of the lookups of one step.
+ * @param *pxSession Session the commands are executed in, NULL for the
+ *        linear lookup
+ * @param uCount Registered commands
+ * @retval Time per lookup, in tenths of a time stamp tick
+ */
+static uint32_t prvTimeStep(CLI_Session_t *pxSession, uint32_t uCount)
+{
+    const CLI_Command_Definition_t *volatile pxFound;
+    uint64_t uBest = UINT64_MAX;
+    uint64_t uStart;
+    uint64_t uTime;
+    uint32_t uLookup;
+    int iRun;
+
+    for (iRun = 0; iRun < BENCH_RUNS; iRun++)
+    {
+        uStart = prvNow();
+        for (uLookup = 0; uLookup < BENCH_LOOKUPS; uLookup++)
+        {
+            if (pxSession != NULL)
+            {
+                FreeRTOS_CLISessionExecute(pxSession, cNames[usOrder[uLookup]]);
+            }
+            else
+            {
+                pxFound = prvLinearFind(cNames[usOrder[uLookup]], uCount);
+            }
+        }
+        uTime = prvNow() - uStart;
+        uBest = (uTime < uBest) ? uTime : uBest;
+    }
+    (void)pxFound;
+
+    return (uint32_t)(uBest * 10 / BENCH_LOOKUPS);
+}
+
+int main(void)
+{
+    CLI_Output_Sink_t xSink = { prvBenchSinkPut, NULL, NULL };
+    CLI_Session_t xSession;
+    uint32_t uState = BENCH_SEED;
+    uint32_t uRegistered = 0;
+    uint32_t uHashTime;
+    uint32_t uLinearTime;
+    uint32_t uLookup;
+    size_t i;
+
+    pxCommands = malloc(BENCH_CLI_COMMANDS * sizeof(CLI_Command_Definition_t));
+    if (pxCommands == NULL)
+    {
+        return 1;
+    }
+    FreeRTOS_CLISessionInit(&xSession, &xSink, NULL, 0);
+
+#if defined(__x86_64__) || defined(__i386__)
+    printf("Host time stamp counter ticks per command, fastest of %u runs of %u commands\n",
+           BENCH_RUNS, BENCH_LOOKUPS);
+#else
+    printf("Host nanoseconds per command, fastest of %u runs of %u commands\n", BENCH_RUNS, BENCH_LOOKUPS);
+#endif
+    printf("Commands   Execute (hash)   Linear lookup\n");
+    for (i = 0; i < sizeof(uSteps) / sizeof(uSteps[0]); i++)
+    {
+        /* Names share their first characters, as command families do */
+        while (uRegistered < uSteps[i])
+        {
+            CLI_Command_Definition_t xDefinition = { cNames[uRegistered], "", NULL, 0, prvBenchCommand, NULL };
+
+            snprintf(cNames[uRegistered], BENCH_NAME_LEN, "cmd-%u", (unsigned)uRegistered);
+            memcpy(&pxCommands[uRegistered], &xDefinition, sizeof(xDefinition));
+            if (FreeRTOS_CLIRegisterCommand(&pxCommands[uRegistered]) != pdPASS)
+            {
+                printf("Registering command %u failed\n", (unsigned)uRegistered);
+                return 1;
+            }
+            uRegistered++;
+        }
+
+        for (uLookup = 0; uLookup < BENCH_LOOKUPS; uLookup++)
+        {
+            usOrder[uLookup] = (uint16_t)(prvRandom(&uState) % uRegistered);
+        }
+
+        uExecuted = 0;
+        uHashTime = prvTimeStep(&xSession, uRegistered);
+        if (uExecuted != (uint32_t)BENCH_RUNS * BENCH_LOOKUPS)
+        {
+            printf("%u of %u commands executed\n", uExecuted, BENCH_RUNS * BENCH_LOOKUPS);
+            return 1;
+        }
+        uLinearTime = prvTimeStep(NULL, uRegistered);
+
+        printf("%8u %14u.%u %13u.%u\n", (unsigned)uRegistered, uHashTime / 10, uHashTime % 10,
+               uLinearTime / 10, uLinearTime % 10);
+    }
+
+    return 0;
+}
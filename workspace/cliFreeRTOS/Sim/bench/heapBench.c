@@ -0,0 +1,270 @@
+/**
+ ******************************************************************************
+ * @file    heapBench.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host benchmark of the heap implementations on a fragmenting
+ *          workload. The same program is built against heap_4.c and
+ *          heap_tlsf.c, see the heapBench4 and heapBenchTlsf targets.
+ *
+ *          Slots are allocated and freed at random with mixed sizes, so the
+ *          free space ends up split in many blocks. The sequence repeats
+ *          from the same heap state in every run and each operation keeps
+ *          its fastest run, which drops the time the host steals.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define BENCH_SLOTS                         256
+#define BENCH_OPERATIONS                    200000
+#define BENCH_RUNS                          5
+#define BENCH_SEED                          0x2545F491UL
+#define BENCH_STATS_PERIOD                  16 /* Operations between samples of the free block count */
+
+typedef struct
+{
+    uint32_t uCalls;
+    uint32_t uTime[BENCH_OPERATIONS];   /* Fastest run of each operation, 0 = not this function */
+} BenchTiming_t;
+
+static void *pvSlots[BENCH_SLOTS];
+static BenchTiming_t xMallocTiming;
+static BenchTiming_t xFreeTiming;
+static uint32_t uSorted[BENCH_OPERATIONS];
+static uint32_t uFailedAllocs;
+static uint32_t uFreeBlocksMax;
+static uint64_t uFreeBlocksSum;
+static uint32_t uFreeBlocksSamples;
+
+/* The benchmark runs without the scheduler, the kernel calls of the heap do nothing */
+void vTaskSuspendAll(void) { }
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+void vPortEnterCritical(void) { }
+void vPortExitCritical(void) { }
+
+void vSimAssertCalled(const char *pcFile, int iLine)
+{
+    fprintf(stderr, "Assert failed: %s:%d\n", pcFile, iLine);
+    abort();
+}
+
+/**
+ * @brief Read the host time stamp counter, or the monotonic clock in ns
+ *        on hosts without one.
+ * @param void
+ * @retval Time stamp
+ */
+static inline uint64_t prvNow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec xNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &xNow);
+    return (uint64_t)xNow.tv_sec * 1000000000U + xNow.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Next value of a xorshift generator, the same sequence every run.
+ * @param *puState Generator state
+ * @retval Pseudo random value
+ */
+static uint32_t prvRandom(uint32_t *puState)
+{
+    uint32_t uX = *puState;
+
+    uX ^= uX << 13;
+    uX ^= uX >> 17;
+    uX ^= uX << 5;
+    *puState = uX;
+
+    return uX;
+}
+
+/**
+ * @brief Size of the next allocation: mostly small kernel objects and
+ *        buffers, with a few large ones that need contiguous space.
+ * @param *puState Generator state
+ * @retval Size in bytes
+ */
+static size_t prvRandomSize(uint32_t *puState)
+{
+    uint32_t uKind = prvRandom(puState) % 100;
+
+    if (uKind < 70)
+    {
+        return 8 + prvRandom(puState) % 88;
+    }
+    else if (uKind < 95)
+    {
+        return 96 + prvRandom(puState) % 672;
+    }
+
+    return 768 + prvRandom(puState) % 2304;
+}
+
+/**
+ * @brief Keep the fastest time of an operation.
+ * @param *pxTiming Timing of the function called
+ * @param uOperation Index of the operation in the sequence
+ * @param uTime Time of this run
+ * @param iFirstRun Non zero in the first run
+ * @retval void
+ */
+static void prvTimingAdd(BenchTiming_t *pxTiming, uint32_t uOperation, uint32_t uTime, int iFirstRun)
+{
+    /* 0 marks the operations of the other function */
+    uTime = (uTime == 0) ? 1 : uTime;
+
+    if (iFirstRun)
+    {
+        pxTiming->uCalls++;
+        pxTiming->uTime[uOperation] = uTime;
+    }
+    else if (uTime < pxTiming->uTime[uOperation])
+    {
+        pxTiming->uTime[uOperation] = uTime;
+    }
+}
+
+/**
+ * @brief Run the workload once and free the remaining slots, which leaves
+ *        the heap as it was before the run.
+ * @param iFirstRun Non zero in the first run, which also samples the
+ *        free block count
+ * @retval void
+ */
+static void prvRun(int iFirstRun)
+{
+    HeapStats_t xStats;
+    uint32_t uState = BENCH_SEED;
+    uint32_t uOperation;
+    uint32_t uSlot;
+    size_t xSize;
+    uint64_t uStart;
+    uint64_t uTime;
+
+    for (uOperation = 0; uOperation < BENCH_OPERATIONS; uOperation++)
+    {
+        uSlot = prvRandom(&uState) % BENCH_SLOTS;
+
+        if (pvSlots[uSlot] != NULL)
+        {
+            uStart = prvNow();
+            vPortFree(pvSlots[uSlot]);
+            uTime = prvNow() - uStart;
+            pvSlots[uSlot] = NULL;
+            prvTimingAdd(&xFreeTiming, uOperation, (uint32_t)uTime, iFirstRun);
+        }
+        else
+        {
+            xSize = prvRandomSize(&uState);
+            uStart = prvNow();
+            pvSlots[uSlot] = pvPortMalloc(xSize);
+            uTime = prvNow() - uStart;
+            prvTimingAdd(&xMallocTiming, uOperation, (uint32_t)uTime, iFirstRun);
+
+            if (iFirstRun && pvSlots[uSlot] == NULL)
+            {
+                uFailedAllocs++;
+            }
+        }
+
+        if (iFirstRun && (uOperation % BENCH_STATS_PERIOD) == 0)
+        {
+            vPortGetHeapStats(&xStats);
+            uFreeBlocksSum += xStats.xNumberOfFreeBlocks;
+            uFreeBlocksSamples++;
+
+            if (xStats.xNumberOfFreeBlocks > uFreeBlocksMax)
+            {
+                uFreeBlocksMax = xStats.xNumberOfFreeBlocks;
+            }
+        }
+    }
+
+    for (uSlot = 0; uSlot < BENCH_SLOTS; uSlot++)
+    {
+        vPortFree(pvSlots[uSlot]);
+        pvSlots[uSlot] = NULL;
+    }
+}
+
+static int prvCompare(const void *pvA, const void *pvB)
+{
+    uint32_t uA = *(const uint32_t *)pvA;
+    uint32_t uB = *(const uint32_t *)pvB;
+
+    return (uA > uB) - (uA < uB);
+}
+
+/**
+ * @brief Print the calls, average, percentiles and maximum of a function.
+ * @param *pcName Function name
+ * @param *pxTiming Timing of the function
+ * @retval void
+ */
+static void prvPrintTiming(const char *pcName, const BenchTiming_t *pxTiming)
+{
+    uint32_t uOperation;
+    uint32_t uCount = 0;
+    uint64_t uSum = 0;
+
+    for (uOperation = 0; uOperation < BENCH_OPERATIONS; uOperation++)
+    {
+        if (pxTiming->uTime[uOperation] != 0)
+        {
+            uSorted[uCount++] = pxTiming->uTime[uOperation];
+            uSum += pxTiming->uTime[uOperation];
+        }
+    }
+
+    if (uCount == 0)
+    {
+        return;
+    }
+
+    qsort(uSorted, uCount, sizeof(uSorted[0]), prvCompare);
+    printf("%-13s %8u %7lu %7u %7u %7u\n", pcName, pxTiming->uCalls,
+           (unsigned long)(uSum / uCount), uSorted[(uint64_t)uCount * 99 / 100],
+           uSorted[(uint64_t)uCount * 999 / 1000], uSorted[uCount - 1]);
+}
+
+int main(void)
+{
+    int iRun;
+
+    for (iRun = 0; iRun < BENCH_RUNS; iRun++)
+    {
+        prvRun(iRun == 0);
+    }
+
+    printf("%s, %u byte heap, %u slots, %u operations, fastest of %u runs\n",
+           (HEAP_TLSF_EN == 1) ? "heap_tlsf.c" : "heap_4.c", (unsigned)configTOTAL_HEAP_SIZE,
+           BENCH_SLOTS, BENCH_OPERATIONS, BENCH_RUNS);
+#if defined(__x86_64__) || defined(__i386__)
+    printf("Host time stamp counter ticks per call\n");
+#else
+    printf("Host nanoseconds per call\n");
+#endif
+    printf("                 Calls     Avg     p99   p99.9     Max\n");
+    prvPrintTiming("pvPortMalloc", &xMallocTiming);
+    prvPrintTiming("vPortFree", &xFreeTiming);
+    printf("Failed allocations   : %u\n", uFailedAllocs);
+    printf("Free blocks          : %lu average, %u maximum\n",
+           (unsigned long)(uFreeBlocksSum / uFreeBlocksSamples), uFreeBlocksMax);
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+/**
+ ******************************************************************************
+ * @file    FreeRTOSConfig.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Kernel configuration of the host simulator: the firmware one with
+ *          the few changes the host needs.
+ ******************************************************************************
+ */
+
+#ifndef SIM_FREERTOS_CONFIG_H
+#define SIM_FREERTOS_CONFIG_H
+
+#include "../../Core/Inc/FreeRTOSConfig.h"
+
+/* Tasks run on host thread stacks, the stack profiler reads the target ones */
+#if (STACK_PROFILER_EN == 1)
+#error "STACK_PROFILER_EN is not supported by the simulator"
+#endif
+
+/* cliSimPerf times the commands for the perf command, see CMakeLists.txt */
+#if defined(SIM_CLI_PERF_EN)
+#undef CLI_PERF_EN
+#define CLI_PERF_EN SIM_CLI_PERF_EN
+#endif
+
+/* Failed asserts stop the simulator with the file and line */
+extern void vSimAssertCalled(const char *pcFile, int iLine);
+#undef configASSERT
+#define configASSERT(x) if ((x) == 0) vSimAssertCalled(__FILE__, __LINE__)
+
+/* Pointers and UBaseType_t are 64 bits on the host, the command
+*  temporaries are larger than on the target
+*/
+#undef configCOMMAND_INT_ARENA_SIZE
+#define configCOMMAND_INT_ARENA_SIZE 1024
+
+/* The idle task sleeps until the next tick instead of spinning on a host CPU */
+#undef configUSE_IDLE_HOOK
+#define configUSE_IDLE_HOOK 1
+
+#endif /* SIM_FREERTOS_CONFIG_H */
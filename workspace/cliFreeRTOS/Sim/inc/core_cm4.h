@@ -0,0 +1,136 @@
+/**
+ ******************************************************************************
+ * @file    core_cm4.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host simulator replacement of the CMSIS Cortex-M4 core header,
+ *          found before Drivers/CMSIS/Include. Provides the qualifiers, the
+ *          intrinsics used by the firmware and the DWT and CoreDebug blocks.
+ *          Interrupt masking maps to the simulator port, the DWT cycle
+ *          counter follows the host monotonic clock at SystemCoreClock.
+ ******************************************************************************
+ */
+
+#ifndef __CORE_CM4_H_GENERIC
+#define __CORE_CM4_H_GENERIC
+
+#include <stdint.h>
+
+#define __CORTEX_M                  (4U)
+
+#define __I                         volatile const
+#define __O                         volatile
+#define __IO                        volatile
+#define __IM                        volatile const
+#define __OM                        volatile
+#define __IOM                       volatile
+
+#define __ASM                       __asm
+#define __INLINE                    inline
+#define __STATIC_INLINE             static inline
+#define __STATIC_FORCEINLINE        __attribute__((always_inline)) static inline
+#define __NO_RETURN                 __attribute__((__noreturn__))
+#define __USED                      __attribute__((used))
+#define __WEAK                      __attribute__((weak))
+#define __PACKED                    __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)                __attribute__((aligned(x)))
+#define __RESTRICT                  __restrict
+
+/* Data Watchpoint and Trace, only the cycle counter is modelled */
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t CYCCNT;
+    __IOM uint32_t CPICNT;
+    __IOM uint32_t EXCCNT;
+    __IOM uint32_t SLEEPCNT;
+    __IOM uint32_t LSUCNT;
+    __IOM uint32_t FOLDCNT;
+    __IM  uint32_t PCSR;
+} DWT_Type;
+
+#define DWT_CTRL_CYCCNTENA_Pos      0U
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << DWT_CTRL_CYCCNTENA_Pos)
+
+typedef struct
+{
+    __IOM uint32_t DHCSR;
+    __OM  uint32_t DCRSR;
+    __IOM uint32_t DCRDR;
+    __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Pos  24U
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << CoreDebug_DEMCR_TRCENA_Pos)
+
+/* Exception number seen by __get_IPSR() in the simulated interrupts */
+#define SIM_IRQ_EXCEPTION_NUMBER    15U     /* SysTick */
+
+DWT_Type *pxSimDwt(void);
+extern CoreDebug_Type xSimCoreDebug;
+
+#define DWT                         (pxSimDwt())
+#define CoreDebug                   (&xSimCoreDebug)
+
+/* Simulator port, see Sim/port/port.c */
+extern void vPortDisableInterrupts(void);
+extern void vPortEnableInterrupts(void);
+extern long xPortInterruptsMasked(void);
+extern long xPortIsInsideInterrupt(void);
+
+__STATIC_FORCEINLINE void __disable_irq(void)
+{
+    vPortDisableInterrupts();
+}
+
+__STATIC_FORCEINLINE void __enable_irq(void)
+{
+    vPortEnableInterrupts();
+}
+
+__STATIC_FORCEINLINE uint32_t __get_PRIMASK(void)
+{
+    return (xPortInterruptsMasked() != 0) ? 1U : 0U;
+}
+
+__STATIC_FORCEINLINE void __set_PRIMASK(uint32_t priMask)
+{
+    if ((priMask & 1U) != 0U)
+    {
+        vPortDisableInterrupts();
+    }
+    else
+    {
+        vPortEnableInterrupts();
+    }
+}
+
+__STATIC_FORCEINLINE uint32_t __get_IPSR(void)
+{
+    return (xPortIsInsideInterrupt() != 0) ? SIM_IRQ_EXCEPTION_NUMBER : 0U;
+}
+
+__STATIC_FORCEINLINE uint8_t __CLZ(uint32_t value)
+{
+    return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_FORCEINLINE void __NOP(void)
+{
+}
+
+__STATIC_FORCEINLINE void __DSB(void)
+{
+    __sync_synchronize();
+}
+
+__STATIC_FORCEINLINE void __ISB(void)
+{
+    __sync_synchronize();
+}
+
+__STATIC_FORCEINLINE void __DMB(void)
+{
+    __sync_synchronize();
+}
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ ******************************************************************************
+ * @file    sim.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host simulator internals: the host console behind USART1, the
+ *          simulated peripheral interrupts and the host clock.
+ ******************************************************************************
+ */
+
+#ifndef __SIM__H
+#define __SIM__H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Taken at every tick by the port, with interrupts masked */
+void vSimPeripheralInterrupts(void);
+
+/* Host console, stdin/stdout or a pseudo terminal */
+size_t xSimConsoleRead(uint8_t *pucBuf, size_t xLen);
+void vSimConsoleWrite(const uint8_t *pucBuf, size_t xLen);
+int iSimConsoleFinished(void);
+extern uint32_t uSimLineRate;   /* Console bits/s, 0 = UART baud rate */
+
+/* Nanoseconds since the simulator started, from the host monotonic clock */
+uint64_t uSimNanoseconds(void);
+
+void vSimAssertCalled(const char *pcFile, int iLine);
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ ******************************************************************************
+ * @file    stm32f4xx_hal_tim.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host simulator wrapper of the HAL TIM header: timer counters are
+ *          read from the host clock, see simHal.c.
+ ******************************************************************************
+ */
+
+#ifndef SIM_STM32F4xx_HAL_TIM_H
+#define SIM_STM32F4xx_HAL_TIM_H
+
+#include_next "stm32f4xx_hal_tim.h"
+
+uint32_t uSimTimGetCounter(TIM_TypeDef *pxTim);
+
+#undef __HAL_TIM_GET_COUNTER
+#define __HAL_TIM_GET_COUNTER(__HANDLE__) uSimTimGetCounter((__HANDLE__)->Instance)
+
+#endif /* SIM_STM32F4xx_HAL_TIM_H */
@@ -0,0 +1,387 @@
+/**
+ ******************************************************************************
+ * @file    port.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   FreeRTOS port for the host simulator.
+ *
+ *          Each task has a POSIX thread, the thread data sits at the top of
+ *          the task stack. A context switch wakes the thread of the new task
+ *          and puts the thread of the old task to sleep, so only one task
+ *          thread runs at any time and the kernel sees a single CPU.
+ *
+ *          The tick is SIGALRM from an interval timer. SIGALRM is blocked in
+ *          every thread but the running task, blocking it is how interrupts
+ *          are masked, and the signal handler plays the tick interrupt and the
+ *          simulated peripheral interrupts. Task code must not take host locks
+ *          (stdio, malloc) as it may be switched out inside them.
+ ******************************************************************************
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sim.h"
+
+#define portTICK_SIGNAL    SIGALRM
+
+typedef struct THREAD
+{
+    pthread_t xPthread;
+    pthread_mutex_t xMutex;
+    pthread_cond_t xCond;
+    BaseType_t xRunRequested;   /* Set to wake the thread, cleared when it runs */
+    BaseType_t xDying;          /* The task was deleted, the thread ends when it wakes */
+    TaskFunction_t pxCode;
+    void * pvParams;
+} Thread_t;
+
+/* The thread data is just above the top of the stack given to the task. */
+#define prvGetThreadFromTask( xTask )    ( ( Thread_t * ) ( *( StackType_t ** ) ( xTask ) + 1 ) )
+
+static sigset_t xTickSignal;
+static sem_t xSchedulerEnd;
+static volatile UBaseType_t uxCriticalNesting;
+static volatile BaseType_t xYieldPending;   /* Yield requested while interrupts were masked */
+static volatile BaseType_t xInsideInterrupt;
+
+/* Mirror of the SIGALRM bit in the signal mask of each thread, it saves a
+ * system call to the functions that only read the interrupt mask. */
+static __thread BaseType_t xInterruptsMasked;
+
+/*-----------------------------------------------------------*/
+
+static void prvWaitToRun( Thread_t * pxThread )
+{
+    BaseType_t xDying;
+
+    pthread_mutex_lock( &pxThread->xMutex );
+
+    while( pxThread->xRunRequested == pdFALSE )
+    {
+        pthread_cond_wait( &pxThread->xCond, &pxThread->xMutex );
+    }
+
+    pxThread->xRunRequested = pdFALSE;
+    xDying = pxThread->xDying;
+    pthread_mutex_unlock( &pxThread->xMutex );
+
+    if( xDying != pdFALSE )
+    {
+        pthread_exit( NULL );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvRequestRun( Thread_t * pxThread )
+{
+    pthread_mutex_lock( &pxThread->xMutex );
+    pxThread->xRunRequested = pdTRUE;
+    pthread_cond_signal( &pxThread->xCond );
+    pthread_mutex_unlock( &pxThread->xMutex );
+}
+/*-----------------------------------------------------------*/
+
+/* Called with interrupts masked. Returns once the calling task runs again. */
+static void prvSwitchThread( void )
+{
+    Thread_t * pxOld = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+    Thread_t * pxNew;
+    BaseType_t xDying;
+
+    vTaskSwitchContext();
+    pxNew = prvGetThreadFromTask( xTaskGetCurrentTaskHandle() );
+
+    if( pxNew != pxOld )
+    {
+        /* Once the new task runs, the stack of a dying task may be freed */
+        xDying = pxOld->xDying;
+        prvRequestRun( pxNew );
+
+        if( xDying != pdFALSE )
+        {
+            pthread_exit( NULL );
+        }
+
+        prvWaitToRun( pxOld );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void * prvTaskThread( void * pvParams )
+{
+    Thread_t * pxThread = ( Thread_t * ) pvParams;
+
+    /* Created with every signal blocked, SIGALRM is unblocked once the task
+     * has been switched in. */
+    xInterruptsMasked = pdTRUE;
+    prvWaitToRun( pxThread );
+    vPortEnableInterrupts();
+
+    pxThread->pxCode( pxThread->pvParams );
+
+    /* Tasks must not return, delete it like the other ports would trap it */
+    vTaskDelete( NULL );
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTickHandler( int iSignal )
+{
+    ( void ) iSignal;
+
+    /* The kernel blocked SIGALRM for the handler, the thread may be switched
+     * out here and resumed by a later tick or yield. */
+    xInterruptsMasked = pdTRUE;
+    xInsideInterrupt = pdTRUE;
+
+    vSimPeripheralInterrupts();
+
+    if( xTaskIncrementTick() != pdFALSE )
+    {
+        xYieldPending = pdTRUE;
+    }
+
+    xInsideInterrupt = pdFALSE;
+
+    if( xYieldPending != pdFALSE )
+    {
+        xYieldPending = pdFALSE;
+        prvSwitchThread();
+    }
+
+    xInterruptsMasked = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+StackType_t * pxPortInitialiseStack( StackType_t * pxTopOfStack,
+                                     TaskFunction_t pxCode,
+                                     void * pvParameters )
+{
+    Thread_t * pxThread;
+    pthread_attr_t xAttr;
+    sigset_t xAllSignals;
+    sigset_t xSavedSignals;
+    int iError;
+
+    /* pxTopOfStack is the last usable word, the thread data goes below it
+     * with the alignment of the host pointers. */
+    pxThread = ( Thread_t * ) ( ( ( uintptr_t ) ( pxTopOfStack + 1 ) - sizeof( Thread_t ) ) &
+                                ~( ( uintptr_t ) sizeof( void * ) - 1 ) );
+    pxTopOfStack = ( StackType_t * ) pxThread - 1;
+
+    memset( pxThread, 0x00, sizeof( Thread_t ) );
+    pxThread->pxCode = pxCode;
+    pxThread->pvParams = pvParameters;
+    pthread_mutex_init( &pxThread->xMutex, NULL );
+    pthread_cond_init( &pxThread->xCond, NULL );
+
+    /* The new thread inherits the signal mask, it must not take ticks while it
+     * waits to run. The tick is masked too, pthread_create() takes host locks. */
+    sigfillset( &xAllSignals );
+    pthread_sigmask( SIG_SETMASK, &xAllSignals, &xSavedSignals );
+    pthread_attr_init( &xAttr );
+    pthread_attr_setdetachstate( &xAttr, PTHREAD_CREATE_JOINABLE );
+    iError = pthread_create( &pxThread->xPthread, &xAttr, prvTaskThread, pxThread );
+    pthread_attr_destroy( &xAttr );
+    pthread_sigmask( SIG_SETMASK, &xSavedSignals, NULL );
+    configASSERT( iError == 0 );
+
+    return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortStartScheduler( void )
+{
+    struct sigaction xAction;
+    struct itimerval xTimer;
+    sigset_t xAllSignals;
+
+    /* Only task threads take ticks */
+    sigfillset( &xAllSignals );
+    pthread_sigmask( SIG_SETMASK, &xAllSignals, NULL );
+    sem_init( &xSchedulerEnd, 0, 0 );
+
+    memset( &xAction, 0x00, sizeof( xAction ) );
+    xAction.sa_handler = prvTickHandler;
+    xAction.sa_flags = SA_RESTART;
+    sigfillset( &xAction.sa_mask );
+    sigaction( portTICK_SIGNAL, &xAction, NULL );
+
+    xTimer.it_interval.tv_sec = 0;
+    xTimer.it_interval.tv_usec = 1000000UL / configTICK_RATE_HZ;
+    xTimer.it_value = xTimer.it_interval;
+    setitimer( ITIMER_REAL, &xTimer, NULL );
+
+    uxCriticalNesting = 0;
+    prvRequestRun( prvGetThreadFromTask( xTaskGetCurrentTaskHandle() ) );
+
+    /* main() does not expect the scheduler to return */
+    while( sem_wait( &xSchedulerEnd ) != 0 )
+    {
+    }
+
+    exit( EXIT_SUCCESS );
+
+    return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortEndScheduler( void )
+{
+    struct itimerval xTimer;
+
+    memset( &xTimer, 0x00, sizeof( xTimer ) );
+    setitimer( ITIMER_REAL, &xTimer, NULL );
+    sem_post( &xSchedulerEnd );
+}
+/*-----------------------------------------------------------*/
+
+void vPortYield( void )
+{
+    /* Pended until interrupts are unmasked, like PendSV */
+    if( ( xInsideInterrupt != pdFALSE ) || ( xInterruptsMasked != pdFALSE ) )
+    {
+        xYieldPending = pdTRUE;
+        return;
+    }
+
+    vPortDisableInterrupts();
+    prvSwitchThread();
+    vPortEnableInterrupts();
+}
+/*-----------------------------------------------------------*/
+
+void vPortYieldFromISR( void )
+{
+    vPortYield();
+}
+/*-----------------------------------------------------------*/
+
+void vPortDisableInterrupts( void )
+{
+    if( xInterruptsMasked == pdFALSE )
+    {
+        pthread_sigmask( SIG_BLOCK, &xTickSignal, NULL );
+        xInterruptsMasked = pdTRUE;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnableInterrupts( void )
+{
+    if( xInterruptsMasked != pdFALSE )
+    {
+        /* A yield pended by a task runs before pending ticks are taken */
+        if( ( xYieldPending != pdFALSE ) && ( uxCriticalNesting == 0 ) && ( xInsideInterrupt == pdFALSE ) )
+        {
+            xYieldPending = pdFALSE;
+            prvSwitchThread();
+        }
+
+        xInterruptsMasked = pdFALSE;
+        pthread_sigmask( SIG_UNBLOCK, &xTickSignal, NULL );
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortEnterCritical( void )
+{
+    vPortDisableInterrupts();
+    uxCriticalNesting++;
+}
+/*-----------------------------------------------------------*/
+
+void vPortExitCritical( void )
+{
+    configASSERT( uxCriticalNesting != 0 );
+    uxCriticalNesting--;
+
+    if( uxCriticalNesting == 0 )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPortSetInterruptMask( void )
+{
+    UBaseType_t uxWasMasked = ( UBaseType_t ) xInterruptsMasked;
+
+    vPortDisableInterrupts();
+
+    return uxWasMasked;
+}
+/*-----------------------------------------------------------*/
+
+void vPortClearInterruptMask( UBaseType_t uxMask )
+{
+    if( uxMask == 0 )
+    {
+        vPortEnableInterrupts();
+    }
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortInterruptsMasked( void )
+{
+    return xInterruptsMasked;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPortIsInsideInterrupt( void )
+{
+    return xInsideInterrupt;
+}
+/*-----------------------------------------------------------*/
+
+void vPortThreadDying( void * pvTaskToDelete,
+                       volatile BaseType_t * pxPendYield )
+{
+    ( void ) pxPendYield;
+
+    /* The task deletes itself, its thread ends at the next switch */
+    prvGetThreadFromTask( pvTaskToDelete )->xDying = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCancelThread( void * pxTaskToDelete )
+{
+    Thread_t * pxThread = prvGetThreadFromTask( pxTaskToDelete );
+    UBaseType_t uxMask;
+
+    /* A task deleted by another task is asleep, wake it up so it ends. The
+     * thread data goes away with the stack, wait for the thread first. */
+    uxMask = uxPortSetInterruptMask();
+
+    if( pxThread->xDying == pdFALSE )
+    {
+        pthread_mutex_lock( &pxThread->xMutex );
+        pxThread->xDying = pdTRUE;
+        pxThread->xRunRequested = pdTRUE;
+        pthread_cond_signal( &pxThread->xCond );
+        pthread_mutex_unlock( &pxThread->xMutex );
+    }
+
+    pthread_join( pxThread->xPthread, NULL );
+    pthread_cond_destroy( &pxThread->xCond );
+    pthread_mutex_destroy( &pxThread->xMutex );
+    vPortClearInterruptMask( uxMask );
+}
+/*-----------------------------------------------------------*/
+
+/* Runs before main(), so the tick signal set is ready for the first critical
+ * section. */
+static void __attribute__( ( constructor ) ) prvPortInit( void )
+{
+    sigemptyset( &xTickSignal );
+    sigaddset( &xTickSignal, portTICK_SIGNAL );
+}
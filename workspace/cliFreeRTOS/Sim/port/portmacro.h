@@ -0,0 +1,107 @@
+/**
+ ******************************************************************************
+ * @file    portmacro.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   FreeRTOS port for the host simulator. Each task runs in its own
+ *          POSIX thread and only one of them runs at a time, the tick is
+ *          SIGALRM and masking interrupts blocks SIGALRM.
+ ******************************************************************************
+ */
+
+#ifndef PORTMACRO_H
+    #define PORTMACRO_H
+
+    #ifdef __cplusplus
+        extern "C" {
+    #endif
+
+/* Type definitions, the same as the Cortex-M4 port so kernel objects and
+ * stacks take a similar amount of heap. Stacks only hold the thread data of
+ * the task, tasks run on the stack of their thread. */
+    #define portCHAR          char
+    #define portFLOAT         float
+    #define portDOUBLE        double
+    #define portLONG          long
+    #define portSHORT         short
+    #define portSTACK_TYPE    uint32_t
+    #define portBASE_TYPE     long
+
+    typedef portSTACK_TYPE   StackType_t;
+    typedef long             BaseType_t;
+    typedef unsigned long    UBaseType_t;
+
+    #if ( configUSE_16_BIT_TICKS == 1 )
+        typedef uint16_t     TickType_t;
+        #define portMAX_DELAY              ( TickType_t ) 0xffff
+    #else
+        typedef uint32_t     TickType_t;
+        #define portMAX_DELAY              ( TickType_t ) 0xffffffffUL
+        #define portTICK_TYPE_IS_ATOMIC    1
+    #endif
+/*-----------------------------------------------------------*/
+
+/* Architecture specifics. */
+    #define portSTACK_GROWTH      ( -1 )
+    #define portTICK_PERIOD_MS    ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+    #define portBYTE_ALIGNMENT    8
+    #define portPOINTER_SIZE_TYPE    uintptr_t
+    #define portDONT_DISCARD      __attribute__( ( used ) )
+    #define portNOP()
+    #define portMEMORY_BARRIER()    __sync_synchronize()
+/*-----------------------------------------------------------*/
+
+/* Scheduler utilities. A yield requested with interrupts masked or from the
+ * tick handler is pended, like PendSV on the target. */
+    extern void vPortYield( void );
+    extern void vPortYieldFromISR( void );
+
+    #define portYIELD()                                 vPortYield()
+    #define portEND_SWITCHING_ISR( xSwitchRequired )    do { if( xSwitchRequired != pdFALSE ) vPortYieldFromISR(); } while( 0 )
+    #define portYIELD_FROM_ISR( x )                     portEND_SWITCHING_ISR( x )
+/*-----------------------------------------------------------*/
+
+/* Critical section management. */
+    extern void vPortEnterCritical( void );
+    extern void vPortExitCritical( void );
+    extern void vPortDisableInterrupts( void );
+    extern void vPortEnableInterrupts( void );
+    extern UBaseType_t uxPortSetInterruptMask( void );
+    extern void vPortClearInterruptMask( UBaseType_t uxMask );
+    extern BaseType_t xPortInterruptsMasked( void );
+    extern BaseType_t xPortIsInsideInterrupt( void );
+
+    #define portSET_INTERRUPT_MASK_FROM_ISR()         uxPortSetInterruptMask()
+    #define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )    vPortClearInterruptMask( x )
+    #define portDISABLE_INTERRUPTS()                  vPortDisableInterrupts()
+    #define portENABLE_INTERRUPTS()                   vPortEnableInterrupts()
+    #define portENTER_CRITICAL()                      vPortEnterCritical()
+    #define portEXIT_CRITICAL()                       vPortExitCritical()
+/*-----------------------------------------------------------*/
+
+/* Task threads are ended when their task is deleted. */
+    extern void vPortThreadDying( void * pvTaskToDelete, volatile BaseType_t * pxPendYield );
+    extern void vPortCancelThread( void * pxTaskToDelete );
+
+    #define portPRE_TASK_DELETE_HOOK( pvTaskToDelete, pxPendYield )    vPortThreadDying( ( pvTaskToDelete ), ( pxPendYield ) )
+    #define portCLEAN_UP_TCB( pxTCB )                                  vPortCancelThread( pxTCB )
+/*-----------------------------------------------------------*/
+
+    #define portTASK_FUNCTION_PROTO( vFunction, pvParameters )    void vFunction( void * pvParameters )
+    #define portTASK_FUNCTION( vFunction, pvParameters )          void vFunction( void * pvParameters )
+/*-----------------------------------------------------------*/
+
+/* Only the generic task selection is implemented. */
+    #ifndef configUSE_PORT_OPTIMISED_TASK_SELECTION
+        #define configUSE_PORT_OPTIMISED_TASK_SELECTION    0
+    #endif
+
+    #if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+        #error "The simulator port uses the generic task selection"
+    #endif
+/*-----------------------------------------------------------*/
+
+    #ifdef __cplusplus
+        }
+    #endif
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,587 @@
+/**
+ ******************************************************************************
+ * @file    simHal.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   HAL functions used by the firmware, modelled on the peripheral
+ *          registers mapped in host memory at their STM32F401 addresses.
+ *          RCC computes the clock tree, GPIO outputs read back on the input
+ *          register, timers count from the host clock, the RTC runs from the
+ *          time last set and USART1 moves bytes to the host console at its
+ *          baud rate. Transfer and reception events are raised from the tick,
+ *          the only simulated interrupt.
+ ******************************************************************************
+ */
+
+#include "stm32f4xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "sim.h"
+
+#define SIM_UART_BITS_PER_BYTE              10  /* Start, 8 data and stop bits */
+
+__IO uint32_t uwTick;
+uint32_t uwTickPrio = TICK_INT_PRIORITY;
+HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+
+uint32_t SystemCoreClock = HSI_VALUE;
+const uint8_t AHBPrescTable[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
+const uint8_t APBPrescTable[8]  = {0, 0, 0, 0, 1, 2, 3, 4};
+
+CoreDebug_Type xSimCoreDebug;
+static DWT_Type xSimDwt;
+
+static UART_HandleTypeDef *pxSimUart;   /* The console, the only UART in use */
+static uint32_t uUartBitCredit;         /* Bits the line could carry since the last byte */
+static uint64_t uRtcSetTime;            /* Host time when the RTC was last set */
+static TIM_HandleTypeDef xSimTimebase = { .Instance = TIM9 };
+
+/**
+* @brief Cycle counter from the host clock, scaled to SystemCoreClock.
+* @param void
+* @retval DWT registers.
+*/
+DWT_Type *pxSimDwt(void)
+{
+    if ((xSimDwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) != 0)
+    {
+        xSimDwt.CYCCNT = (uint32_t)((unsigned __int128)uSimNanoseconds() * SystemCoreClock / 1000000000U);
+    }
+
+    return &xSimDwt;
+}
+
+/**
+* @brief Clock of a timer: the APB clock, twice it when the APB prescaler is
+*        not 1.
+* @param *pxTim Timer instance.
+* @retval Timer clock in Hz.
+*/
+static uint32_t prvTimClock(const TIM_TypeDef *pxTim)
+{
+    uint32_t uPclk;
+    uint32_t uPrescaled;
+
+    if ((uintptr_t)pxTim >= APB2PERIPH_BASE)
+    {
+        uPclk = HAL_RCC_GetPCLK2Freq();
+        uPrescaled = (RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1;
+    }
+    else
+    {
+        uPclk = HAL_RCC_GetPCLK1Freq();
+        uPrescaled = (RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1;
+    }
+
+    return uPrescaled ? uPclk * 2 : uPclk;
+}
+
+/**
+* @brief Counter of an up counting timer, it counts from the host clock since
+*        the simulator started. See __HAL_TIM_GET_COUNTER.
+* @param *pxTim Timer instance.
+* @retval Counter value.
+*/
+uint32_t uSimTimGetCounter(TIM_TypeDef *pxTim)
+{
+    unsigned __int128 uCounts;
+
+    if ((pxTim->CR1 & TIM_CR1_CEN) == 0)
+    {
+        return pxTim->CNT;
+    }
+
+    uCounts = (unsigned __int128)uSimNanoseconds() * prvTimClock(pxTim) / 1000000000U / (pxTim->PSC + 1);
+    pxTim->CNT = (uint32_t)(uCounts % ((uint64_t)pxTim->ARR + 1));
+
+    return pxTim->CNT;
+}
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+    uwTick += uwTickFreq;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return uwTick;
+}
+
+/**
+* @brief Core clock from the RCC registers, as in system_stm32f4xx.c.
+* @param void
+* @retval void
+*/
+void SystemCoreClockUpdate(void)
+{
+    uint32_t uSysClock;
+    uint32_t uPllInput;
+    uint32_t uPllM = RCC->PLLCFGR & RCC_PLLCFGR_PLLM;
+    uint32_t uPllN = (RCC->PLLCFGR & RCC_PLLCFGR_PLLN) >> RCC_PLLCFGR_PLLN_Pos;
+    uint32_t uPllP = ((((RCC->PLLCFGR & RCC_PLLCFGR_PLLP) >> RCC_PLLCFGR_PLLP_Pos) + 1) * 2);
+
+    switch (RCC->CFGR & RCC_CFGR_SWS)
+    {
+        case RCC_CFGR_SWS_HSE:
+            uSysClock = HSE_VALUE;
+            break;
+        case RCC_CFGR_SWS_PLL:
+            uPllInput = (RCC->PLLCFGR & RCC_PLLCFGR_PLLSRC) ? HSE_VALUE : HSI_VALUE;
+            uSysClock = (uPllM != 0) ? (uPllInput / uPllM) * uPllN / uPllP : HSI_VALUE;
+            break;
+        default:
+            uSysClock = HSI_VALUE;
+            break;
+    }
+
+    SystemCoreClock = uSysClock >> AHBPrescTable[(RCC->CFGR & RCC_CFGR_HPRE) >> RCC_CFGR_HPRE_Pos];
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+    if (RCC_OscInitStruct->HSIState == RCC_HSI_ON)
+    {
+        RCC->CR |= RCC_CR_HSION | RCC_CR_HSIRDY;
+    }
+    if (RCC_OscInitStruct->PLL.PLLState == RCC_PLL_ON)
+    {
+        RCC->PLLCFGR = RCC_OscInitStruct->PLL.PLLSource |
+                       RCC_OscInitStruct->PLL.PLLM |
+                       (RCC_OscInitStruct->PLL.PLLN << RCC_PLLCFGR_PLLN_Pos) |
+                       (((RCC_OscInitStruct->PLL.PLLP >> 1U) - 1U) << RCC_PLLCFGR_PLLP_Pos) |
+                       (RCC_OscInitStruct->PLL.PLLQ << RCC_PLLCFGR_PLLQ_Pos);
+        RCC->CR |= RCC_CR_PLLON | RCC_CR_PLLRDY;
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+    MODIFY_REG(FLASH->ACR, FLASH_ACR_LATENCY, FLatency);
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_SW | RCC_CFGR_SWS | RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2,
+               RCC_ClkInitStruct->SYSCLKSource |
+               (RCC_ClkInitStruct->SYSCLKSource << RCC_CFGR_SWS_Pos) |
+               RCC_ClkInitStruct->AHBCLKDivider |
+               RCC_ClkInitStruct->APB1CLKDivider |
+               (RCC_ClkInitStruct->APB2CLKDivider << 3U));
+    SystemCoreClockUpdate();
+
+    return HAL_OK;
+}
+
+void HAL_RCC_GetClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t *pFLatency)
+{
+    RCC_ClkInitStruct->ClockType = RCC_CLOCKTYPE_SYSCLK | RCC_CLOCKTYPE_HCLK |
+                                   RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+    RCC_ClkInitStruct->SYSCLKSource = RCC->CFGR & RCC_CFGR_SW;
+    RCC_ClkInitStruct->AHBCLKDivider = RCC->CFGR & RCC_CFGR_HPRE;
+    RCC_ClkInitStruct->APB1CLKDivider = RCC->CFGR & RCC_CFGR_PPRE1;
+    RCC_ClkInitStruct->APB2CLKDivider = (RCC->CFGR & RCC_CFGR_PPRE2) >> 3U;
+    *pFLatency = FLASH->ACR & FLASH_ACR_LATENCY;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+    return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    uint32_t uPin;
+
+    for (uPin = 0; uPin < 16; uPin++)
+    {
+        if (GPIO_Init->Pin & (1U << uPin))
+        {
+            MODIFY_REG(GPIOx->MODER, 3U << (uPin * 2), (GPIO_Init->Mode & GPIO_MODE) << (uPin * 2));
+            MODIFY_REG(GPIOx->PUPDR, 3U << (uPin * 2), GPIO_Init->Pull << (uPin * 2));
+        }
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if (PinState != GPIO_PIN_RESET)
+    {
+        GPIOx->ODR |= GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+    GPIOx->IDR = GPIOx->ODR;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    GPIOx->ODR ^= GPIO_Pin;
+    GPIOx->IDR = GPIOx->ODR;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+/**
+* @brief Time base registers shared by the timer init functions.
+* @param *htim TIM handle.
+* @retval void
+*/
+static void prvTimBaseConfig(TIM_HandleTypeDef *htim)
+{
+    MODIFY_REG(htim->Instance->CR1, TIM_CR1_DIR | TIM_CR1_CMS | TIM_CR1_CKD | TIM_CR1_ARPE,
+               htim->Init.CounterMode | htim->Init.ClockDivision | htim->Init.AutoReloadPreload);
+    htim->Instance->ARR = htim->Init.Period;
+    htim->Instance->PSC = htim->Init.Prescaler;
+    htim->State = HAL_TIM_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+    prvTimBaseConfig(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_Init(TIM_HandleTypeDef *htim)
+{
+    prvTimBaseConfig(htim);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel)
+{
+    __IO uint32_t *puCcmr = (Channel < TIM_CHANNEL_3) ? &htim->Instance->CCMR1 : &htim->Instance->CCMR2;
+    uint32_t uShift = (Channel & TIM_CHANNEL_2) ? 8U : 0U;
+
+    MODIFY_REG(*puCcmr, (TIM_CCMR1_OC1M | TIM_CCMR1_OC1PE) << uShift, (sConfig->OCMode | TIM_CCMR1_OC1PE) << uShift);
+    MODIFY_REG(htim->Instance->CCER, TIM_CCER_CC1P << Channel, sConfig->OCPolarity << Channel);
+    __HAL_TIM_SET_COMPARE(htim, Channel, sConfig->Pulse);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    htim->Instance->CCER |= TIM_CCER_CC1E << Channel;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+
+    return HAL_OK;
+}
+
+/**
+* @brief Convert a binary value into BCD, as the RTC registers hold it.
+* @param uValue Value below 100.
+* @retval BCD value.
+*/
+static uint32_t prvToBcd(uint32_t uValue)
+{
+    return ((uValue / 10U) << 4U) | (uValue % 10U);
+}
+
+static uint32_t prvFromBcd(uint32_t uValue)
+{
+    return (uValue >> 4U) * 10U + (uValue & 0x0FU);
+}
+
+HAL_StatusTypeDef HAL_RTC_Init(RTC_HandleTypeDef *hrtc)
+{
+    MODIFY_REG(hrtc->Instance->CR, RTC_CR_FMT, hrtc->Init.HourFormat);
+    hrtc->Instance->PRER = (hrtc->Init.AsynchPrediv << RTC_PRER_PREDIV_A_Pos) | hrtc->Init.SynchPrediv;
+    if (hrtc->Instance->DR == 0)
+    {
+        hrtc->Instance->DR = 0x00002101U;   /* Reset value, Monday 1 January 2000 */
+    }
+    hrtc->State = HAL_RTC_STATE_READY;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format)
+{
+    uint32_t uHours = sTime->Hours;
+    uint32_t uMinutes = sTime->Minutes;
+    uint32_t uSeconds = sTime->Seconds;
+
+    if (Format == RTC_FORMAT_BIN)
+    {
+        uHours = prvToBcd(uHours % 100U);
+        uMinutes = prvToBcd(uMinutes % 100U);
+        uSeconds = prvToBcd(uSeconds % 100U);
+    }
+    hrtc->Instance->TR = ((uHours << RTC_TR_HU_Pos) & (RTC_TR_HT | RTC_TR_HU)) |
+                         ((uMinutes << RTC_TR_MNU_Pos) & (RTC_TR_MNT | RTC_TR_MNU)) |
+                         ((uSeconds << RTC_TR_SU_Pos) & (RTC_TR_ST | RTC_TR_SU));
+    uRtcSetTime = uSimNanoseconds();
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format)
+{
+    uint32_t uTr = hrtc->Instance->TR;
+    uint32_t uSeconds;
+
+    /* Seconds of the day that were set, plus the time elapsed since then */
+    uSeconds = prvFromBcd((uTr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos) * 3600U +
+               prvFromBcd((uTr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos) * 60U +
+               prvFromBcd((uTr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos);
+    uSeconds = (uint32_t)((uSeconds + (uSimNanoseconds() - uRtcSetTime) / 1000000000U) % 86400U);
+
+    sTime->Hours = uSeconds / 3600U;
+    sTime->Minutes = (uSeconds / 60U) % 60U;
+    sTime->Seconds = uSeconds % 60U;
+    sTime->SubSeconds = 0;
+    sTime->TimeFormat = RTC_HOURFORMAT12_AM;
+    if (Format == RTC_FORMAT_BCD)
+    {
+        sTime->Hours = prvToBcd(sTime->Hours);
+        sTime->Minutes = prvToBcd(sTime->Minutes);
+        sTime->Seconds = prvToBcd(sTime->Seconds);
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format)
+{
+    uint32_t uDr = hrtc->Instance->DR;
+
+    sDate->Year = (uDr & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos;
+    sDate->Month = (uDr & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos;
+    sDate->Date = (uDr & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos;
+    sDate->WeekDay = (uDr & RTC_DR_WDU) >> RTC_DR_WDU_Pos;
+    if (Format == RTC_FORMAT_BIN)
+    {
+        sDate->Year = prvFromBcd(sDate->Year);
+        sDate->Month = prvFromBcd(sDate->Month);
+        sDate->Date = prvFromBcd(sDate->Date);
+    }
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+    huart->Instance->BRR = HAL_RCC_GetPCLK2Freq() / huart->Init.BaudRate;
+    huart->Instance->CR1 = USART_CR1_UE | huart->Init.Mode | huart->Init.WordLength | huart->Init.Parity;
+    huart->ErrorCode = HAL_UART_ERROR_NONE;
+    huart->gState = HAL_UART_STATE_READY;
+    huart->RxState = HAL_UART_STATE_READY;
+    pxSimUart = huart;
+
+    return HAL_OK;
+}
+
+/**
+* @brief Blocking transmission, the bytes go to the host console at once.
+*/
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    vSimConsoleWrite(pData, Size);
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (huart->gState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    huart->pTxBuffPtr = pData;
+    huart->TxXferSize = Size;
+    huart->TxXferCount = Size;
+    huart->gState = HAL_UART_STATE_BUSY_TX;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+    huart->TxXferCount = 0;
+    huart->gState = HAL_UART_STATE_READY;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = Size;
+    huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    return HAL_OK;
+}
+
+/**
+* @brief Circular DMA reception with idle line events, RxXferCount holds the
+*        DMA position in the buffer.
+*/
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart->RxState != HAL_UART_STATE_READY)
+    {
+        return HAL_BUSY;
+    }
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->RxXferCount = 0;
+    huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+    huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+    return HAL_OK;
+}
+
+/**
+* @brief Move the bytes the line carried during the last tick: send pending
+*        DMA data and receive host input, raising the HAL callbacks.
+* @param void
+* @retval void
+*/
+static void prvUartInterrupt(UART_HandleTypeDef *huart)
+{
+    uint32_t uBudget;
+    uint32_t uLen;
+    uint8_t ucByte;
+
+    uUartBitCredit += ((uSimLineRate != 0) ? uSimLineRate : huart->Init.BaudRate) / configTICK_RATE_HZ;
+    uBudget = uUartBitCredit / SIM_UART_BITS_PER_BYTE;
+
+    /* Transmission: chained transfers continue within the same budget */
+    while (huart->gState == HAL_UART_STATE_BUSY_TX && uBudget > 0)
+    {
+        uLen = (huart->TxXferCount < uBudget) ? huart->TxXferCount : uBudget;
+        vSimConsoleWrite(huart->pTxBuffPtr + (huart->TxXferSize - huart->TxXferCount), uLen);
+        huart->TxXferCount -= uLen;
+        uBudget -= uLen;
+        if (huart->TxXferCount == 0)
+        {
+            huart->gState = HAL_UART_STATE_READY;
+            HAL_UART_TxCpltCallback(huart);
+        }
+    }
+
+    /* Reception, a line that went quiet raises the idle event */
+    uBudget = uUartBitCredit / SIM_UART_BITS_PER_BYTE;
+    uUartBitCredit %= SIM_UART_BITS_PER_BYTE;
+    if (huart->RxState != HAL_UART_STATE_BUSY_RX)
+    {
+        return;
+    }
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+        uLen = 0;
+        while (uBudget > 0 && xSimConsoleRead(&ucByte, 1) == 1)
+        {
+            huart->pRxBuffPtr[huart->RxXferCount++] = ucByte;
+            uBudget--;
+            uLen++;
+            if (huart->RxXferCount == huart->RxXferSize)
+            {
+                /* Transfer complete, the circular DMA starts over */
+                HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+                huart->RxXferCount = 0;
+                uLen = 0;
+            }
+        }
+        if (uLen > 0)
+        {
+            HAL_UARTEx_RxEventCallback(huart, huart->RxXferCount);
+        }
+    }
+    else
+    {
+        while (uBudget > 0 && huart->RxState == HAL_UART_STATE_BUSY_RX &&
+               xSimConsoleRead(&ucByte, 1) == 1)
+        {
+            *huart->pRxBuffPtr++ = ucByte;
+            uBudget--;
+            if (--huart->RxXferCount == 0)
+            {
+                huart->RxState = HAL_UART_STATE_READY;
+                HAL_UART_RxCpltCallback(huart);
+            }
+        }
+    }
+}
+
+/**
+* @brief Simulated interrupts, taken at every tick: USART1 with its DMA
+*        streams and the TIM9 HAL time base. Ends the simulation once the
+*        host input is over and the console went quiet.
+* @param void
+* @retval void
+*/
+void vSimPeripheralInterrupts(void)
+{
+    if (pxSimUart != NULL)
+    {
+        prvUartInterrupt(pxSimUart);
+    }
+    HAL_TIM_PeriodElapsedCallback(&xSimTimebase);
+
+    if (iSimConsoleFinished() && (pxSimUart == NULL || pxSimUart->gState == HAL_UART_STATE_READY))
+    {
+        vTaskEndScheduler();
+    }
+}
+
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
+
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    (void)huart;
+    (void)Size;
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    (void)huart;
+}
@@ -0,0 +1,396 @@
+/**
+ ******************************************************************************
+ * @file    simMain.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host simulator entry point. Maps the STM32F401 peripheral
+ *          registers in host memory, connects USART1 to the host console
+ *          (stdin/stdout or a pseudo terminal) and runs main() of the
+ *          firmware.
+ ******************************************************************************
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+/* The device header is not included, termios.h defines names used by it */
+#define SIM_PERIPH_BASE                     0x40000000UL /* PERIPH_BASE */
+#define SIM_PERIPH_SIZE                     0x00030000UL /* APB1, APB2 and AHB1 up to the DMA controllers */
+#define SIM_RX_RING_LEN                     4096         /* Power of two */
+#define SIM_EXIT_QUIET_MS                   1000         /* Console silence before exiting once the input is over */
+#define SIM_FORMAT_MAX_LEN                  512
+
+extern int iFirmwareMain(void);     /* main() of Core/Src/main.c, renamed by the build */
+int __real_vsnprintf(char *pcBuf, size_t xLen, const char *pcFormat, va_list xArgs);
+
+uint32_t uSimLineRate;
+
+static struct timespec xStartTime;
+static int iConsoleIn = STDIN_FILENO;
+static int iConsoleOut = STDOUT_FILENO;
+static struct termios xSavedTermios;
+static int iTermiosSaved;
+
+/* Host input, written by the reader thread and read by the UART model */
+static uint8_t ucRxRing[SIM_RX_RING_LEN];
+static uint32_t uRxHead;
+static uint32_t uRxTail;
+static int iInputOver;
+static uint64_t uLastOutput;
+
+uint64_t uSimNanoseconds(void)
+{
+    struct timespec xNow;
+
+    clock_gettime(CLOCK_MONOTONIC, &xNow);
+
+    return (uint64_t)(xNow.tv_sec - xStartTime.tv_sec) * 1000000000U + xNow.tv_nsec - xStartTime.tv_nsec;
+}
+
+/**
+* @brief Take bytes received from the host.
+* @param *pucBuf Buffer that receives the bytes.
+* @param xLen Size of pucBuf.
+* @retval Number of bytes taken.
+*/
+size_t xSimConsoleRead(uint8_t *pucBuf, size_t xLen)
+{
+    uint32_t uHead = __atomic_load_n(&uRxHead, __ATOMIC_ACQUIRE);
+    size_t xCount = 0;
+
+    while (xCount < xLen && uRxTail != uHead)
+    {
+        pucBuf[xCount++] = ucRxRing[uRxTail % SIM_RX_RING_LEN];
+        uRxTail++;
+    }
+    __atomic_store_n(&uRxTail, uRxTail, __ATOMIC_RELEASE);
+
+    return xCount;
+}
+
+/**
+* @brief Send bytes to the host. Only write(2) is used, tasks may be switched
+*        out at any point and must not hold stdio locks.
+* @param *pucBuf Bytes to be sent.
+* @param xLen Number of bytes.
+* @retval void
+*/
+void vSimConsoleWrite(const uint8_t *pucBuf, size_t xLen)
+{
+    ssize_t xWritten;
+
+    while (xLen > 0)
+    {
+        xWritten = write(iConsoleOut, pucBuf, xLen);
+        if (xWritten < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        pucBuf += xWritten;
+        xLen -= (size_t)xWritten;
+    }
+    uLastOutput = uSimNanoseconds();
+}
+
+/**
+* @brief Check whether the simulation is over: the host input ended, all of
+*        it went to the UART and the console has been quiet for a while.
+* @param void
+* @retval 1 if the simulator can exit.
+*/
+int iSimConsoleFinished(void)
+{
+    return __atomic_load_n(&iInputOver, __ATOMIC_ACQUIRE) &&
+           __atomic_load_n(&uRxHead, __ATOMIC_ACQUIRE) == uRxTail &&
+           uSimNanoseconds() - uLastOutput > SIM_EXIT_QUIET_MS * 1000000ULL;
+}
+
+/**
+* @brief Reader thread, moves the host input into the RX ring. It never takes
+*        ticks, SIGALRM is blocked before it is created.
+* @param *pvParams Not used.
+* @retval NULL
+*/
+static void *prvConsoleReader(void *pvParams)
+{
+    uint8_t ucByte;
+    ssize_t xRead;
+    const struct timespec xWait = { 0, 1000000 };
+
+    (void)pvParams;
+    while (1)
+    {
+        xRead = read(iConsoleIn, &ucByte, 1);
+        if (xRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (xRead <= 0)
+        {
+            break;
+        }
+
+        /* The UART takes the bytes at the line rate, wait for room */
+        while (uRxHead - __atomic_load_n(&uRxTail, __ATOMIC_ACQUIRE) >= SIM_RX_RING_LEN)
+        {
+            nanosleep(&xWait, NULL);
+        }
+        ucRxRing[uRxHead % SIM_RX_RING_LEN] = ucByte;
+        __atomic_store_n(&uRxHead, uRxHead + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&iInputOver, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void prvRestoreTerminal(void)
+{
+    if (iTermiosSaved)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &xSavedTermios);
+    }
+}
+
+static void prvExitSignal(int iSignal)
+{
+    prvRestoreTerminal();
+    _exit(128 + iSignal);
+}
+
+/**
+* @brief Pass keys to the firmware as a serial terminal would: no line
+*        editing, no echo and carriage return on enter. Ctrl+C still quits.
+* @param void
+* @retval void
+*/
+static void prvRawTerminal(void)
+{
+    struct termios xRaw;
+
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &xSavedTermios) != 0)
+    {
+        return;
+    }
+    iTermiosSaved = 1;
+    atexit(prvRestoreTerminal);
+
+    xRaw = xSavedTermios;
+    xRaw.c_iflag &= ~(ICRNL | INLCR | IXON);
+    xRaw.c_lflag &= ~(ICANON | ECHO | IEXTEN);
+    xRaw.c_cc[VMIN] = 1;
+    xRaw.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &xRaw);
+}
+
+/**
+* @brief Use a pseudo terminal as the console, for terminal programs and
+*        scripts that expect a serial port.
+* @param void
+* @retval 0 on success, -1 on error.
+*/
+static int prvOpenPty(void)
+{
+    struct termios xRaw;
+    int iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    int iSlave;
+
+    if (iMaster < 0 || grantpt(iMaster) != 0 || unlockpt(iMaster) != 0)
+    {
+        return -1;
+    }
+
+    /* Kept open so reads do not fail while no program has the port open */
+    iSlave = open(ptsname(iMaster), O_RDWR | O_NOCTTY);
+    if (iSlave < 0 || tcgetattr(iSlave, &xRaw) != 0)
+    {
+        return -1;
+    }
+    cfmakeraw(&xRaw);
+    tcsetattr(iSlave, TCSANOW, &xRaw);
+
+    iConsoleIn = iMaster;
+    iConsoleOut = iMaster;
+    fprintf(stderr, "cliSim: console on %s\n", ptsname(iMaster));
+
+    return 0;
+}
+
+/**
+* @brief Map the peripheral registers at their addresses, so the device
+*        header, the HAL macros and address comparisons work unchanged.
+* @param void
+* @retval 0 on success, -1 if the address range is taken.
+*/
+static int prvMapPeripherals(void)
+{
+    void *pvBase = mmap((void *)SIM_PERIPH_BASE, SIM_PERIPH_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    return (pvBase == (void *)SIM_PERIPH_BASE) ? 0 : -1;
+}
+
+static void prvUsage(const char *pcName)
+{
+    fprintf(stderr,
+            "Usage: %s [--pty] [--baud <bits/s>]\n"
+            "  --pty           Console on a pseudo terminal instead of stdin/stdout\n"
+            "  --baud <bits/s> Console line rate, default is the UART baud rate\n"
+            "With stdin/stdout the simulator exits once the input is over and the\n"
+            "console has been quiet for %d ms. Ctrl+C quits.\n",
+            pcName, SIM_EXIT_QUIET_MS);
+}
+
+int main(int argc, char *argv[])
+{
+    struct sigaction xAction;
+    sigset_t xTickSignal;
+    pthread_t xReader;
+    int iArg;
+    int iPty = 0;
+
+    for (iArg = 1; iArg < argc; iArg++)
+    {
+        if (strcmp(argv[iArg], "--pty") == 0)
+        {
+            iPty = 1;
+        }
+        else if (strcmp(argv[iArg], "--baud") == 0 && iArg + 1 < argc)
+        {
+            uSimLineRate = (uint32_t)strtoul(argv[++iArg], NULL, 10);
+        }
+        else
+        {
+            prvUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &xStartTime);
+    if (prvMapPeripherals() != 0)
+    {
+        fprintf(stderr, "cliSim: can not map the peripherals at 0x%08lx\n", SIM_PERIPH_BASE);
+        return EXIT_FAILURE;
+    }
+    if (iPty && prvOpenPty() != 0)
+    {
+        fprintf(stderr, "cliSim: can not open a pseudo terminal\n");
+        return EXIT_FAILURE;
+    }
+    if (!iPty)
+    {
+        prvRawTerminal();
+    }
+
+    memset(&xAction, 0x00, sizeof(xAction));
+    xAction.sa_handler = prvExitSignal;
+    sigaction(SIGINT, &xAction, NULL);
+    sigaction(SIGTERM, &xAction, NULL);
+    sigaction(SIGHUP, &xAction, NULL);
+
+    /* Only task threads take ticks */
+    sigemptyset(&xTickSignal);
+    sigaddset(&xTickSignal, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &xTickSignal, NULL);
+    pthread_create(&xReader, NULL, prvConsoleReader, NULL);
+
+    return iFirmwareMain();
+}
+
+/**
+* @brief FreeRTOS idle hook: sleep until the next tick.
+* @param void
+* @retval void
+*/
+void vApplicationIdleHook(void)
+{
+    pause();
+}
+
+void vSimAssertCalled(const char *pcFile, int iLine)
+{
+    prvRestoreTerminal();
+    fprintf(stderr, "cliSim: assertion failed at %s:%d\n", pcFile, iLine);
+    abort();
+}
+
+/**
+* @brief Adapt a format string to the host: long is 32 bits on the target and
+*        the firmware prints 32 bit values with %lu, %ld and %lx. Dropping the
+*        l reads the 32 bits, also when the value was passed as a host long.
+* @param *pcFormat Format string of the firmware.
+* @param *pcOut Buffer for the adapted format.
+* @param xOutLen Size of pcOut.
+* @retval Format string to be used.
+*/
+static const char *prvTargetFormat(const char *pcFormat, char *pcOut, size_t xOutLen)
+{
+    const char *pcIn = pcFormat;
+    size_t xLen = 0;
+
+    while (*pcIn != '\0')
+    {
+        if (xLen + 2 >= xOutLen)
+        {
+            return pcFormat;
+        }
+        pcOut[xLen++] = *pcIn;
+        if (*pcIn++ != '%')
+        {
+            continue;
+        }
+        while (*pcIn != '\0' && strchr("-+ #0123456789.*", *pcIn) != NULL)
+        {
+            if (xLen + 2 >= xOutLen)
+            {
+                return pcFormat;
+            }
+            pcOut[xLen++] = *pcIn++;
+        }
+        if (pcIn[0] == 'l' && pcIn[1] != '\0' && strchr("diouxX", pcIn[1]) != NULL)
+        {
+            pcIn++;
+        }
+        if (*pcIn != '\0')
+        {
+            pcOut[xLen++] = *pcIn++;
+        }
+    }
+    pcOut[xLen] = '\0';
+
+    return pcOut;
+}
+
+int __wrap_vsnprintf(char *pcBuf, size_t xLen, const char *pcFormat, va_list xArgs)
+{
+    char cFormat[SIM_FORMAT_MAX_LEN];
+
+    return __real_vsnprintf(pcBuf, xLen, prvTargetFormat(pcFormat, cFormat, sizeof(cFormat)), xArgs);
+}
+
+int __wrap_snprintf(char *pcBuf, size_t xLen, const char *pcFormat, ...)
+{
+    va_list xArgs;
+    int iLen;
+
+    va_start(xArgs, pcFormat);
+    iLen = __wrap_vsnprintf(pcBuf, xLen, pcFormat, xArgs);
+    va_end(xArgs);
+
+    return iLen;
+}
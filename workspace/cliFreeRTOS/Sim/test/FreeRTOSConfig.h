@@ -0,0 +1,24 @@
+/**
+ ******************************************************************************
+ * @file    FreeRTOSConfig.h
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Kernel configuration of the host tests that link FreeRTOS_CLI.c
+ *          without the kernel: the simulator one with the commands of the
+ *          test registered at run time.
+ ******************************************************************************
+ */
+
+#ifndef TEST_FREERTOS_CONFIG_H
+#define TEST_FREERTOS_CONFIG_H
+
+#include "../inc/FreeRTOSConfig.h"
+
+/* There is no .cli_commands section, the test registers its commands */
+#undef configCOMMAND_INT_STATIC_TABLE
+#define configCOMMAND_INT_STATIC_TABLE 0
+
+/* Command timings read the run time counter of the target */
+#undef CLI_PERF_EN
+#define CLI_PERF_EN 0
+
+#endif /* TEST_FREERTOS_CONFIG_H */
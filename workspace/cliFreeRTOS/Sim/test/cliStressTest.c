@@ -0,0 +1,314 @@
+/**
+ ******************************************************************************
+ * @file    cliStressTest.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host stress test of the re-entrant CLI core: STRESS_THREADS
+ *          pthreads execute commands at the same time, each one in its own
+ *          session with its own sink, scratch buffer and arena.
+ *
+ *          The expected output of every command line is first recorded by
+ *          a single session. Each thread then runs STRESS_COMMANDS lines
+ *          picked at random and compares every output with the recorded
+ *          one. Commands yield in the middle of their work so the threads
+ *          interleave. Critical sections of the CLI map to one recursive
+ *          mutex, as they stop the scheduler on the target. The program
+ *          exits with 1 on any mismatch. Build with -fsanitize=thread to
+ *          also check the shared state.
+ ******************************************************************************
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_CLI.h"
+
+#define STRESS_THREADS                      8
+#define STRESS_COMMANDS                     200000 /* Command lines per thread */
+#define STRESS_OUTPUT_LEN                   1024
+#define STRESS_SCRATCH_LEN                  64
+#define STRESS_ARENA_LEN                    256
+#define STRESS_SUM_WORDS                    16     /* Arena words written by the sum command */
+
+typedef struct
+{
+    char cData[STRESS_OUTPUT_LEN];
+    size_t xUsed;
+} StressOutput_t;
+
+typedef struct
+{
+    pthread_t xThread;
+    uint32_t uSeed;
+    uint32_t uMismatches;
+    StressOutput_t xOutput;
+    char cScratch[STRESS_SCRATCH_LEN];
+    uint32_t uArena[STRESS_ARENA_LEN / sizeof(uint32_t)];  /* Aligned for the arena */
+} StressThread_t;
+
+static BaseType_t prvCommandSum(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandWords(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs);
+static BaseType_t prvCommandLegacy(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString);
+
+static const CLI_Param_Schema_t xSumParams[] =
+{
+    { eCLIParamU32, 0, 0xFFFFFFFF, NULL },
+    { eCLIParamU32, 0, 1000, NULL },
+    { eCLIParamEnum, 0, 0, "add|sub|mul" }
+};
+
+static const CLI_Command_Definition_t xStressCommands[] =
+{
+    { "sum", "\r\nsum <a> <b> <add|sub|mul>: Arithmetic through the session arena.\r\n",
+      NULL, 3, prvCommandSum, xSumParams },
+    { "words", "\r\nwords <...>: Print every parameter on its own line.\r\n",
+      NULL, -1, prvCommandWords, NULL },
+    { "legacy", "\r\nlegacy: Command that writes into the scratch buffer.\r\n",
+      prvCommandLegacy, 0, NULL, NULL },
+};
+
+static const char * const pcLines[] =
+{
+    "sum 1 2 add",
+    "sum 4000000000 1000 sub",
+    "sum 65535 999 mul",
+    "sum 7 1001 add",                   /* Out of range */
+    "sum 7 x add",                      /* Not a number */
+    "sum 7 7 div",                      /* Not a choice */
+    "sum 1 2",                          /* Too few parameters */
+    "words",
+    "words one",
+    "words alpha beta gamma delta epsilon zeta eta theta",
+    "legacy",
+    "legacy now",                       /* Legacy commands take no parameters here */
+    "help",
+    "nosuch",
+    "   sum    3    4    MUL   ",
+};
+
+#define STRESS_LINES                        (sizeof(pcLines) / sizeof(pcLines[0]))
+
+static StressOutput_t xExpected[STRESS_LINES];
+static StressThread_t xThreads[STRESS_THREADS];
+static pthread_mutex_t xCriticalMutex;
+
+/* Critical sections and scheduler suspension stop the other sessions */
+void vTaskSuspendAll(void) { pthread_mutex_lock(&xCriticalMutex); }
+BaseType_t xTaskResumeAll(void) { pthread_mutex_unlock(&xCriticalMutex); return pdFALSE; }
+void vPortEnterCritical(void) { pthread_mutex_lock(&xCriticalMutex); }
+void vPortExitCritical(void) { pthread_mutex_unlock(&xCriticalMutex); }
+
+void vSimAssertCalled(const char *pcFile, int iLine)
+{
+    fprintf(stderr, "Assert failed: %s:%d\n", pcFile, iLine);
+    abort();
+}
+
+/**
+ * @brief Next value of a xorshift generator.
+ * @param *puState Generator state
+ * @retval Pseudo random value
+ */
+static uint32_t prvRandom(uint32_t *puState)
+{
+    uint32_t uX = *puState;
+
+    uX ^= uX << 13;
+    uX ^= uX >> 17;
+    uX ^= uX << 5;
+    *puState = uX;
+
+    return uX;
+}
+
+/**
+ * @brief Sink of a session, appends the output to a StressOutput_t.
+ */
+static BaseType_t prvOutputPut(void *pvContext, const char *pcData, size_t xDataLength)
+{
+    StressOutput_t *pxOutput = pvContext;
+
+    if (xDataLength > sizeof(pxOutput->cData) - pxOutput->xUsed)
+    {
+        return pdFAIL;
+    }
+    memcpy(&pxOutput->cData[pxOutput->xUsed], pcData, xDataLength);
+    pxOutput->xUsed += xDataLength;
+
+    return pdPASS;
+}
+
+/**
+ * @brief Command that computes in the arena of its session and checks that
+ *        no other session wrote to it while it yielded.
+ */
+static BaseType_t prvCommandSum(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    uint32_t *puWords;
+    uint32_t uTag = (uint32_t)(uintptr_t)pxArgs->pxSession;
+    uint32_t uResult;
+    int i;
+
+    puWords = FreeRTOS_CLIArenaAlloc(pxArgs, STRESS_SUM_WORDS * sizeof(uint32_t));
+    if (puWords == NULL)
+    {
+        FreeRTOS_CLIPut(pxSink, "No arena\r\n");
+        return pdFAIL;
+    }
+
+    for (i = 0; i < STRESS_SUM_WORDS; i++)
+    {
+        puWords[i] = uTag + (uint32_t)i;
+    }
+    sched_yield();
+    for (i = 0; i < STRESS_SUM_WORDS; i++)
+    {
+        if (puWords[i] != uTag + (uint32_t)i)
+        {
+            FreeRTOS_CLIPut(pxSink, "Arena overwritten\r\n");
+            return pdFAIL;
+        }
+    }
+
+    switch (pxArgs->ulValue[2])
+    {
+        case 0: uResult = pxArgs->ulValue[0] + pxArgs->ulValue[1]; break;
+        case 1: uResult = pxArgs->ulValue[0] - pxArgs->ulValue[1]; break;
+        default: uResult = pxArgs->ulValue[0] * pxArgs->ulValue[1]; break;
+    }
+    FreeRTOS_CLIPrintf(pxSink, "%lu %lu -> %lu\r\n", (unsigned long)pxArgs->ulValue[0],
+                       (unsigned long)pxArgs->ulValue[1], (unsigned long)uResult);
+
+    return pdPASS;
+}
+
+/**
+ * @brief Command that prints its parameters one by one, yielding between them.
+ */
+static BaseType_t prvCommandWords(CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs)
+{
+    const char *pcWord;
+    size_t xLength;
+    UBaseType_t uxIndex;
+
+    FreeRTOS_CLIPrintf(pxSink, "%u words\r\n", (unsigned)pxArgs->uxCount);
+    for (uxIndex = 0; uxIndex < pxArgs->uxCount; uxIndex++)
+    {
+        pcWord = FreeRTOS_CLIGetArg(pxArgs, uxIndex, &xLength);
+        FreeRTOS_CLIPrintf(pxSink, "%u: %.*s\r\n", (unsigned)uxIndex, (int)xLength, pcWord);
+        sched_yield();
+    }
+
+    return pdPASS;
+}
+
+/**
+ * @brief Legacy command, its output goes through the scratch buffer of the
+ *        session.
+ */
+static BaseType_t prvCommandLegacy(char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString)
+{
+    snprintf(pcWriteBuffer, xWriteBufferLen, "legacy [%s]\r\n", pcCommandString);
+    sched_yield();
+
+    return pdFALSE;
+}
+
+/**
+ * @brief Prepare the session of a thread.
+ * @param *pxStress Thread
+ * @param *pxSession Session
+ * @param *pxSink Sink of the session
+ * @retval void
+ */
+static void prvSessionInit(StressThread_t *pxStress, CLI_Session_t *pxSession, CLI_Output_Sink_t *pxSink)
+{
+    pxSink->pxPut = prvOutputPut;
+    pxSink->pxFlush = NULL;
+    pxSink->pvContext = &pxStress->xOutput;
+    FreeRTOS_CLISessionInit(pxSession, pxSink, pxStress->cScratch, sizeof(pxStress->cScratch));
+    FreeRTOS_CLISessionSetArena(pxSession, pxStress->uArena, sizeof(pxStress->uArena));
+}
+
+/**
+ * @brief Run random command lines in a private session and compare their
+ *        output with the recorded one.
+ * @param *pvParameter StressThread_t of the thread
+ * @retval NULL
+ */
+static void *prvStressThread(void *pvParameter)
+{
+    StressThread_t *pxStress = pvParameter;
+    CLI_Session_t xSession;
+    CLI_Output_Sink_t xSink;
+    uint32_t uCommand;
+    uint32_t uLine;
+
+    prvSessionInit(pxStress, &xSession, &xSink);
+    for (uCommand = 0; uCommand < STRESS_COMMANDS; uCommand++)
+    {
+        uLine = prvRandom(&pxStress->uSeed) % STRESS_LINES;
+        pxStress->xOutput.xUsed = 0;
+        FreeRTOS_CLISessionExecute(&xSession, pcLines[uLine]);
+
+        if (pxStress->xOutput.xUsed != xExpected[uLine].xUsed ||
+            memcmp(pxStress->xOutput.cData, xExpected[uLine].cData, xExpected[uLine].xUsed) != 0)
+        {
+            if (pxStress->uMismatches++ == 0)
+            {
+                fprintf(stderr, "Thread %u, \"%s\":\n%.*s", (unsigned)(pxStress - xThreads), pcLines[uLine],
+                        (int)pxStress->xOutput.xUsed, pxStress->xOutput.cData);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_mutexattr_t xAttr;
+    CLI_Session_t xSession;
+    CLI_Output_Sink_t xSink;
+    uint32_t uMismatches = 0;
+    size_t i;
+
+    pthread_mutexattr_init(&xAttr);
+    pthread_mutexattr_settype(&xAttr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&xCriticalMutex, &xAttr);
+
+    for (i = 0; i < sizeof(xStressCommands) / sizeof(xStressCommands[0]); i++)
+    {
+        FreeRTOS_CLIRegisterCommand(&xStressCommands[i]);
+    }
+
+    /* Expected output of every line, from a single session */
+    prvSessionInit(&xThreads[0], &xSession, &xSink);
+    for (i = 0; i < STRESS_LINES; i++)
+    {
+        xThreads[0].xOutput.xUsed = 0;
+        FreeRTOS_CLISessionExecute(&xSession, pcLines[i]);
+        xExpected[i] = xThreads[0].xOutput;
+    }
+
+    for (i = 0; i < STRESS_THREADS; i++)
+    {
+        xThreads[i].uSeed = 0x2545F491UL + (uint32_t)i * 0x9E3779B9UL;
+        pthread_create(&xThreads[i].xThread, NULL, prvStressThread, &xThreads[i]);
+    }
+    for (i = 0; i < STRESS_THREADS; i++)
+    {
+        pthread_join(xThreads[i].xThread, NULL);
+        uMismatches += xThreads[i].uMismatches;
+    }
+
+    printf("%u threads, %u command lines each, %u output mismatches\n",
+           STRESS_THREADS, STRESS_COMMANDS, (unsigned)uMismatches);
+
+    return (uMismatches == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
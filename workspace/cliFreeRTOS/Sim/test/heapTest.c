@@ -0,0 +1,242 @@
+/**
+ ******************************************************************************
+ * @file    heapTest.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host test of the heap implementations. The same program is built
+ *          against heap_4.c and heap_tlsf.c, see the heapTest4 and
+ *          heapTestTlsf targets, with the configuration of heapBench.
+ *
+ *          Slots are allocated and freed at random with mixed sizes. Every
+ *          block is filled with a pattern of its own, checked again before
+ *          it is freed, and must be aligned and not overlap any live block.
+ *          The free size must drop on every allocation and come back by the
+ *          same amount when the block is freed. Once all the blocks are freed
+ *          the heap must be one free block of the starting size. The program
+ *          exits with 1 on the first failure.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TEST_SLOTS                          256
+#define TEST_OPERATIONS                     500000
+#define TEST_SEED                           0x2545F491UL
+
+typedef struct
+{
+    uint8_t *pucData;
+    size_t xSize;       /* Bytes requested */
+    size_t xTaken;      /* Drop of the free size when the block was allocated */
+    uint8_t ucTag;      /* First byte of the pattern */
+} TestSlot_t;
+
+static TestSlot_t xSlots[TEST_SLOTS];
+
+/* The test runs without the scheduler, the kernel calls of the heap do nothing */
+void vTaskSuspendAll(void) { }
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+void vPortEnterCritical(void) { }
+void vPortExitCritical(void) { }
+
+void vSimAssertCalled(const char *pcFile, int iLine)
+{
+    fprintf(stderr, "Assert failed: %s:%d\n", pcFile, iLine);
+    abort();
+}
+
+/**
+ * @brief Next value of a xorshift generator, the same sequence every run.
+ * @param *puState Generator state
+ * @retval Pseudo random value
+ */
+static uint32_t prvRandom(uint32_t *puState)
+{
+    uint32_t uX = *puState;
+
+    uX ^= uX << 13;
+    uX ^= uX >> 17;
+    uX ^= uX << 5;
+    *puState = uX;
+
+    return uX;
+}
+
+/**
+ * @brief Size of the next allocation: the mix of heapBench, plus sizes
+ *        below the alignment and the header.
+ * @param *puState Generator state
+ * @retval Size in bytes
+ */
+static size_t prvRandomSize(uint32_t *puState)
+{
+    uint32_t uKind = prvRandom(puState) % 100;
+
+    if (uKind < 10)
+    {
+        return 1 + prvRandom(puState) % 16;
+    }
+    else if (uKind < 70)
+    {
+        return 8 + prvRandom(puState) % 88;
+    }
+    else if (uKind < 95)
+    {
+        return 96 + prvRandom(puState) % 672;
+    }
+
+    return 768 + prvRandom(puState) % 2304;
+}
+
+/**
+ * @brief Report a failure and stop.
+ * @param uOperation Operation of the sequence that failed
+ * @param *pcWhat Description
+ * @retval void
+ */
+static void prvFail(uint32_t uOperation, const char *pcWhat)
+{
+    printf("FAIL operation %u: %s\n", (unsigned)uOperation, pcWhat);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Allocate a slot and check the block against the live ones.
+ * @param pxSlot Slot to be allocated
+ * @param xSize Bytes requested
+ * @param uOperation Operation of the sequence
+ * @retval 1 if the block was allocated, 0 if the heap had no room.
+ */
+static int prvAllocate(TestSlot_t *pxSlot, size_t xSize, uint32_t uOperation)
+{
+    size_t xFreeBefore = xPortGetFreeHeapSize();
+    size_t xFreeAfter;
+    size_t i;
+    uint8_t *pucData;
+
+    pucData = pvPortMalloc(xSize);
+    xFreeAfter = xPortGetFreeHeapSize();
+    if (pucData == NULL)
+    {
+        if (xFreeAfter != xFreeBefore)
+        {
+            prvFail(uOperation, "failed allocation changed the free size");
+        }
+        return 0;
+    }
+
+    if (((uintptr_t)pucData & portBYTE_ALIGNMENT_MASK) != 0)
+    {
+        prvFail(uOperation, "block not aligned");
+    }
+    if (xFreeBefore < xFreeAfter || xFreeBefore - xFreeAfter < xSize)
+    {
+        prvFail(uOperation, "free size dropped less than the size requested");
+    }
+    for (i = 0; i < TEST_SLOTS; i++)
+    {
+        if (xSlots[i].pucData != NULL && pucData < xSlots[i].pucData + xSlots[i].xSize &&
+            xSlots[i].pucData < pucData + xSize)
+        {
+            prvFail(uOperation, "block overlaps a live block");
+        }
+    }
+
+    pxSlot->pucData = pucData;
+    pxSlot->xSize = xSize;
+    pxSlot->xTaken = xFreeBefore - xFreeAfter;
+    pxSlot->ucTag = (uint8_t)uOperation;
+    for (i = 0; i < xSize; i++)
+    {
+        pucData[i] = (uint8_t)(pxSlot->ucTag + i);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Check the pattern of a slot and free it.
+ * @param pxSlot Slot to be freed
+ * @param uOperation Operation of the sequence
+ * @retval void
+ */
+static void prvRelease(TestSlot_t *pxSlot, uint32_t uOperation)
+{
+    size_t xFreeBefore = xPortGetFreeHeapSize();
+    size_t i;
+
+    for (i = 0; i < pxSlot->xSize; i++)
+    {
+        if (pxSlot->pucData[i] != (uint8_t)(pxSlot->ucTag + i))
+        {
+            prvFail(uOperation, "block overwritten while allocated");
+        }
+    }
+
+    vPortFree(pxSlot->pucData);
+    if (xPortGetFreeHeapSize() - xFreeBefore != pxSlot->xTaken)
+    {
+        prvFail(uOperation, "free did not return what the allocation took");
+    }
+    pxSlot->pucData = NULL;
+}
+
+int main(void)
+{
+    HeapStats_t xStats;
+    uint32_t uState = TEST_SEED;
+    uint32_t uOperation;
+    uint32_t uSlot;
+    uint32_t uAllocs = 0;
+    uint32_t uFailedAllocs = 0;
+    size_t xStartFree;
+
+    /* The first allocation initialises the heap */
+    vPortFree(pvPortMalloc(1));
+    xStartFree = xPortGetFreeHeapSize();
+
+    for (uOperation = 0; uOperation < TEST_OPERATIONS; uOperation++)
+    {
+        uSlot = prvRandom(&uState) % TEST_SLOTS;
+        if (xSlots[uSlot].pucData != NULL)
+        {
+            prvRelease(&xSlots[uSlot], uOperation);
+        }
+        else if (prvAllocate(&xSlots[uSlot], prvRandomSize(&uState), uOperation))
+        {
+            uAllocs++;
+        }
+        else
+        {
+            uFailedAllocs++;
+        }
+    }
+
+    for (uSlot = 0; uSlot < TEST_SLOTS; uSlot++)
+    {
+        if (xSlots[uSlot].pucData != NULL)
+        {
+            prvRelease(&xSlots[uSlot], uOperation);
+        }
+    }
+
+    /* Every free block must have merged back with its neighbours */
+    vPortGetHeapStats(&xStats);
+    if (xStats.xAvailableHeapSpaceInBytes != xStartFree || xStats.xNumberOfFreeBlocks != 1 ||
+        xStats.xSizeOfLargestFreeBlockInBytes != xStartFree)
+    {
+        printf("FAIL heap not recovered: %lu of %lu bytes free in %lu blocks, largest %lu\n",
+               (unsigned long)xStats.xAvailableHeapSpaceInBytes, (unsigned long)xStartFree,
+               (unsigned long)xStats.xNumberOfFreeBlocks, (unsigned long)xStats.xSizeOfLargestFreeBlockInBytes);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s, %u operations: %u allocations, %u failed for lack of room, %lu bytes recovered\n",
+           (HEAP_TLSF_EN == 1) ? "heap_tlsf.c" : "heap_4.c", TEST_OPERATIONS, (unsigned)uAllocs,
+           (unsigned)uFailedAllocs, (unsigned long)xStartFree);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+/**
+ ******************************************************************************
+ * @file    pwmTimingTest.c
+ * @author  Aaron Escoboza, Github account: https://github.com/aaron-ev
+ * @brief   Host test of the PWM prescaler and period solver of bspPwm.c,
+ *          for a 40 MHz timer clock with a 32 bit and a 16 bit ARR.
+ *
+ *          Every frequency from 1 Hz to 1 kHz and then steps of 0.1 % up
+ *          to the 20 MHz limit is solved. The period of the timer must be
+ *          within half a count of the requested one, the program exits
+ *          with 1 otherwise. It also prints the table of the README.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bspPwm.h"
+
+#define TEST_TIMER_CLOCK                    40000000UL /* APB1 timer clock of the default clock tree */
+#define TEST_MAX_PRESCALER                  0xFFFF
+
+static const uint32_t uMaxPeriods[] = { 0xFFFFFFFF, 0xFFFF };
+
+static const uint32_t uTableFreqs[] =
+{
+    1, 7, 50, 1234, 33333, 1000000, 3000000, 7777777, 20000000
+};
+
+/* bspPwm.c is linked as it is, its timer calls are never reached by the solver */
+HAL_StatusTypeDef HAL_TIM_OC_Init(TIM_HandleTypeDef *htim) { return HAL_ERROR; }
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig,
+                                            uint32_t Channel) { return HAL_ERROR; }
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel) { return HAL_ERROR; }
+uint32_t bspGetApb1TimerClock(void) { return TEST_TIMER_CLOCK; }
+
+/**
+ * @brief Error of a PWM period in ppm of the requested frequency.
+ * @param uFreq Requested frequency in Hz.
+ * @param pxTiming Solved timing.
+ * @retval Error in ppm, positive when the timer runs faster.
+ */
+static double prvErrorPpm(uint32_t uFreq, const PwmTiming_t *pxTiming)
+{
+    double dAchieved = (double)TEST_TIMER_CLOCK /
+                       ((double)(pxTiming->uPrescaler + 1) * ((double)pxTiming->uPeriod + 1));
+
+    return (dAchieved - uFreq) / uFreq * 1e6;
+}
+
+/**
+ * @brief Solve one frequency and check the result.
+ * @param uFreq Requested frequency in Hz.
+ * @param uMaxPeriod Largest ARR of the timer.
+ * @param pxTiming Solved timing.
+ * @retval 1 if the timing is valid, otherwise 0.
+ */
+static int prvCheck(uint32_t uFreq, uint32_t uMaxPeriod, PwmTiming_t *pxTiming)
+{
+    uint64_t uDivider;
+    uint64_t uTicks;
+    uint64_t uPeriodClocks;
+    uint64_t uDiff;
+
+    if (bspPwmSolveTiming(TEST_TIMER_CLOCK, uFreq, uMaxPeriod, pxTiming) != BSP_NO_ERROR)
+    {
+        printf("FAIL %lu Hz, max period 0x%lx: rejected\n", (unsigned long)uFreq, (unsigned long)uMaxPeriod);
+        return 0;
+    }
+
+    uDivider = (uint64_t)pxTiming->uPrescaler + 1;
+    uTicks = (uint64_t)pxTiming->uPeriod + 1;
+    if (pxTiming->uPrescaler > TEST_MAX_PRESCALER || pxTiming->uPeriod < 1 || pxTiming->uPeriod > uMaxPeriod)
+    {
+        printf("FAIL %lu Hz, max period 0x%lx: prescaler %lu, period %lu out of range\n", (unsigned long)uFreq,
+               (unsigned long)uMaxPeriod, (unsigned long)pxTiming->uPrescaler, (unsigned long)pxTiming->uPeriod);
+        return 0;
+    }
+
+    /*
+     * The requested period is TEST_TIMER_CLOCK / (uDivider * uFreq) counts,
+     * it must be within half a count of uTicks. Scaled by 2 * uDivider * uFreq
+     * to stay in integers.
+     */
+    uPeriodClocks = uDivider * uTicks * uFreq;
+    uDiff = (uPeriodClocks > TEST_TIMER_CLOCK) ? uPeriodClocks - TEST_TIMER_CLOCK
+                                               : TEST_TIMER_CLOCK - uPeriodClocks;
+    if (2 * uDiff > uDivider * uFreq)
+    {
+        printf("FAIL %lu Hz, max period 0x%lx: prescaler %lu, period %lu is %.3f counts off\n",
+               (unsigned long)uFreq, (unsigned long)uMaxPeriod, (unsigned long)pxTiming->uPrescaler,
+               (unsigned long)pxTiming->uPeriod, (double)uDiff / (double)(uDivider * uFreq));
+        return 0;
+    }
+
+    /* The frequency printed by pwm-f */
+    if (pxTiming->uFreq != TEST_TIMER_CLOCK / (uDivider * uTicks) ||
+        pxTiming->uFreqMilli != (TEST_TIMER_CLOCK % (uDivider * uTicks)) * 1000 / (uDivider * uTicks))
+    {
+        printf("FAIL %lu Hz, max period 0x%lx: achieved %lu.%03lu Hz\n", (unsigned long)uFreq,
+               (unsigned long)uMaxPeriod, (unsigned long)pxTiming->uFreq, (unsigned long)pxTiming->uFreqMilli);
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Frequencies the solver must reject.
+ * @param void
+ * @retval Number of failures.
+ */
+static unsigned prvCheckLimits(void)
+{
+    PwmTiming_t xTiming;
+    unsigned uFailures = 0;
+
+    if (bspPwmSolveTiming(TEST_TIMER_CLOCK, 0, 0xFFFFFFFF, &xTiming) != BSP_ERROR_EINVAL)
+    {
+        printf("FAIL 0 Hz accepted\n");
+        uFailures++;
+    }
+    if (bspPwmSolveTiming(TEST_TIMER_CLOCK, TEST_TIMER_CLOCK / 2 + 1, 0xFFFFFFFF, &xTiming) != BSP_ERROR_EINVAL)
+    {
+        printf("FAIL %lu Hz accepted, below 2 duty steps\n", TEST_TIMER_CLOCK / 2 + 1);
+        uFailures++;
+    }
+    /* 40 MHz / 65536 / 65536 is below 0.01 Hz, 1 Hz fits even a 16 bit timer */
+    if (bspPwmSolveTiming(TEST_TIMER_CLOCK, 1, 0xFFFF, &xTiming) != BSP_NO_ERROR)
+    {
+        printf("FAIL 1 Hz rejected with a 16 bit period\n");
+        uFailures++;
+    }
+
+    return uFailures;
+}
+
+int main(void)
+{
+    PwmTiming_t xTimings[sizeof(uMaxPeriods) / sizeof(uMaxPeriods[0])];
+    unsigned uFailures = 0;
+    unsigned uSolved = 0;
+    uint32_t uFreq;
+    size_t i;
+    size_t j;
+
+    printf("                        TIM2, 32 bit ARR                     16 bit ARR\n");
+    printf("Requested Hz   PSC    Steps      Achieved Hz       ppm   PSC  Steps       ppm\n");
+    for (i = 0; i < sizeof(uTableFreqs) / sizeof(uTableFreqs[0]); i++)
+    {
+        for (j = 0; j < sizeof(uMaxPeriods) / sizeof(uMaxPeriods[0]); j++)
+        {
+            if (!prvCheck(uTableFreqs[i], uMaxPeriods[j], &xTimings[j]))
+                uFailures++;
+        }
+        printf("%12lu %5lu %8lu %12lu.%03lu %+9.1f %5lu %6lu %+9.1f\n", (unsigned long)uTableFreqs[i],
+               (unsigned long)xTimings[0].uPrescaler, (unsigned long)xTimings[0].uPeriod + 1,
+               (unsigned long)xTimings[0].uFreq, (unsigned long)xTimings[0].uFreqMilli,
+               prvErrorPpm(uTableFreqs[i], &xTimings[0]),
+               (unsigned long)xTimings[1].uPrescaler, (unsigned long)xTimings[1].uPeriod + 1,
+               prvErrorPpm(uTableFreqs[i], &xTimings[1]));
+    }
+
+    for (j = 0; j < sizeof(uMaxPeriods) / sizeof(uMaxPeriods[0]); j++)
+    {
+        for (uFreq = 1; uFreq <= TEST_TIMER_CLOCK / 2; uFreq += (uFreq < 1000) ? 1 : uFreq / 997)
+        {
+            if (!prvCheck(uFreq, uMaxPeriods[j], &xTimings[j]))
+                uFailures++;
+            uSolved++;
+        }
+        if (!prvCheck(TEST_TIMER_CLOCK / 2, uMaxPeriods[j], &xTimings[j]))
+            uFailures++;
+        uSolved++;
+    }
+
+    uFailures += prvCheckLimits();
+    printf("%u frequencies solved, %u failures\n", uSolved, uFailures);
+
+    return (uFailures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
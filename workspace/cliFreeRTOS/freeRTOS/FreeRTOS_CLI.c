@@ -27,6 +27,8 @@
 /* Standard includes. */
 #include <string.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
@@ -35,191 +37,1399 @@
 /* Utils includes. */
 #include "FreeRTOS_CLI.h"
 
-/* If the application writer needs to place the buffer used by the CLI at a
-fixed address then set configAPPLICATION_PROVIDES_cOutputBuffer to 1 in
-FreeRTOSConfig.h, then declare an array with the following name and size in 
-one of the application files:
-	char cOutputBuffer[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];
-*/
-#ifndef configAPPLICATION_PROVIDES_cOutputBuffer
-	#define configAPPLICATION_PROVIDES_cOutputBuffer 0
+/* FreeRTOS_CLIPrintf() formats into a buffer of this size on the stack of the
+calling task before the text is handed to the output sink. */
+#ifndef configCOMMAND_INT_PRINTF_BUFFER_SIZE
+	#define configCOMMAND_INT_PRINTF_BUFFER_SIZE 128
 #endif
 
-typedef struct xCOMMAND_INPUT_LIST
+/* Maximum number of commands that can be registered at run time with
+FreeRTOS_CLIRegisterCommand(), including "help" when the static command table
+is not used. */
+#ifndef configCOMMAND_INT_MAX_COMMANDS
+	#define configCOMMAND_INT_MAX_COMMANDS 32
+#endif
+
+/* Number of slots in the hash table used to look up command names.  Must be a
+power of two and at least twice the total number of commands, static plus
+registered, so that probe sequences stay short. */
+#ifndef configCOMMAND_INT_HASH_SIZE
+	#define configCOMMAND_INT_HASH_SIZE 64
+#endif
+
+#if( ( configCOMMAND_INT_HASH_SIZE & ( configCOMMAND_INT_HASH_SIZE - 1 ) ) != 0 )
+	#error configCOMMAND_INT_HASH_SIZE must be a power of two
+#endif
+
+#if( configCOMMAND_INT_HASH_SIZE < ( 2 * configCOMMAND_INT_MAX_COMMANDS ) )
+	#error configCOMMAND_INT_HASH_SIZE must be at least twice configCOMMAND_INT_MAX_COMMANDS
+#endif
+
+#if( configCOMMAND_INT_HASH_SIZE > 0x10000 )
+	#error configCOMMAND_INT_HASH_SIZE is too large
+#endif
+
+#if( configCOMMAND_INT_STATIC_TABLE == 1 )
+	/* Start and end of the .cli_commands section, provided by the linker
+	script.  Every definition declared with FreeRTOS_CLI_STATIC_COMMAND ends up
+	between the two. */
+	extern const CLI_Command_Definition_t __cli_commands_start[];
+	extern const CLI_Command_Definition_t __cli_commands_end[];
+
+	#define cliSTATIC_COMMAND_COUNT()	( ( UBaseType_t ) ( __cli_commands_end - __cli_commands_start ) )
+#else
+	#define cliSTATIC_COMMAND_COUNT()	( ( UBaseType_t ) 0 )
+#endif
+
+#if( CLI_PERF_EN == 1 )
+	#if( configGENERATE_RUN_TIME_STATS == 0 )
+		#error Command timings need configGENERATE_RUN_TIME_STATS
+	#endif
+
+	#ifndef RUN_TIME_COUNTER_TO_US
+		#error Command timings need RUN_TIME_COUNTER_TO_US() to convert run time counter values to microseconds
+	#endif
+
+	#define cliPERF_NOW()	( ( configRUN_TIME_COUNTER_TYPE ) portGET_RUN_TIME_COUNTER_VALUE() )
+#endif
+
+/* A slot of the command name hash index. */
+typedef struct xCLI_HASH_SLOT
+{
+	uint16_t usCommand;		/* Index of the command plus one, zero marks an empty slot. */
+	uint16_t usTag;			/* Upper half of the hash of the command name. */
+} CLI_Hash_Slot_t;
+
+/* Sink used by FreeRTOS_CLIProcessCommand() to run streaming commands into a
+caller supplied buffer. */
+typedef struct xCLI_BUFFER_SINK_CONTEXT
+{
+	char *pcBuffer;
+	size_t xBufferLength;
+	size_t xUsed;
+} CLI_Buffer_Sink_Context_t;
+
+/*
+ * The callback function that is executed when "help" is entered.  This is the
+ * only default command that is always present.
+ */
+static BaseType_t prvHelpCommand( CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs );
+
+/*
+ * Split pcCommandInput into words, recording them in pxArgs, and search the
+ * registered commands for the command named by the first word.  Returns NULL
+ * if the command was not found, otherwise the index of the command, in the
+ * order of prvGetCommand(), is written to puxIndex.
+ */
+static const CLI_Command_Definition_t *prvFindCommand( const char *pcCommandInput, CLI_Args_t *pxArgs, UBaseType_t *puxIndex );
+
+/*
+ * Check the number of parameters given to pxCommand and, if the command has a
+ * schema, parse their values into pxArgs.  A description of the first problem
+ * found is written to pxSink.  Returns pdPASS if the parameters are correct.
+ */
+static BaseType_t prvCheckParameters( const CLI_Command_Definition_t *pxCommand, CLI_Args_t *pxArgs, CLI_Output_Sink_t *pxSink );
+
+/*
+ * Search the registered commands for the command whose name hashes to
+ * ulCommandId.  Returns NULL if there is no such command, otherwise the index
+ * of the command is written to puxIndex.
+ */
+static const CLI_Command_Definition_t *prvFindCommandById( uint32_t ulCommandId, UBaseType_t *puxIndex );
+
+/*
+ * Record the xParametersLength bytes of packed parameters at pucParameters in
+ * pxArgs, checking them against the schema of pxCommand.  Returns pdPASS if
+ * the parameters are correct.
+ */
+static BaseType_t prvUnpackParameters( const CLI_Command_Definition_t *pxCommand, CLI_Args_t *pxArgs, const uint8_t *pucParameters, size_t xParametersLength );
+
+/*
+ * Call the command found for pxSession, which has correct parameters, and
+ * forward all of its output to the sink of the session.
+ */
+static BaseType_t prvRunCommand( CLI_Session_t *pxSession, const char *pcCommandInput );
+
+/*
+ * Parse the xLength characters at pcString as an unsigned decimal number.
+ * Returns pdFAIL if they are not all digits or the value overflows.
+ */
+static BaseType_t prvParseNumber( const char *pcString, size_t xLength, uint32_t *pulValue );
+
+/*
+ * Find the xLength characters at pcString in the '|' separated list of words
+ * pcChoices, ignoring case, and return the position of the word in *pulValue.
+ */
+static BaseType_t prvParseChoice( const char *pcChoices, const char *pcString, size_t xLength, uint32_t *pulValue );
+
+/*
+ * FNV-1a hash of the word at the start of pcString, which ends at the first
+ * space or NULL.  The length of the word is returned in *pxLength.
+ */
+static uint32_t prvHashCommandName( const char *pcString, size_t *pxLength );
+
+/*
+ * Return the command with index uxIndex.  Commands of the static table come
+ * first, followed by the commands registered at run time.
+ */
+static const CLI_Command_Definition_t *prvGetCommand( UBaseType_t uxIndex );
+
+/*
+ * Record the arena use of the command executed in pxSession against the
+ * command and release the whole arena for the next command.
+ */
+static void prvArenaRelease( CLI_Session_t *pxSession );
+
+/*
+ * Add the command with index uxIndex to the hash index.  Must be called from a
+ * critical section.
+ */
+static BaseType_t prvIndexCommand( UBaseType_t uxIndex );
+
+/*
+ * Build the hash index the first time the interpreter is used, adding the
+ * static command table, or the help command when there is no static table.
+ * Must be called from a critical section.
+ */
+static void prvInitialiseCommandIndex( void );
+
+/*
+ * Output sink that appends to a fixed size buffer, truncating the output if
+ * the buffer is too small.
+ */
+static BaseType_t prvBufferSinkPut( void *pvContext, const char *pcData, size_t xDataLength );
+
+#if( CLI_PERF_EN == 1 )
+
+	/*
+	 * Start timing a command executed in pxSession.  The output of the command
+	 * goes through the timing sink of the session until prvPerfEnd().
+	 */
+	static void prvPerfBegin( CLI_Session_t *pxSession );
+
+	/*
+	 * End the phase being timed and start the next one.  The output time of
+	 * the phase is moved to eCLIPhaseOutput.
+	 */
+	static void prvPerfPhaseEnd( CLI_Session_t *pxSession );
+
+	/*
+	 * End the phase being timed, restore the sink of the session and record
+	 * the timings against the command of the session, if one was found.
+	 */
+	static void prvPerfEnd( CLI_Session_t *pxSession );
+
+	/*
+	 * Output sink that forwards to the sink of the session and adds the time
+	 * spent in it to the output time.
+	 */
+	static BaseType_t prvPerfSinkPut( void *pvContext, const char *pcData, size_t xDataLength );
+	static void prvPerfSinkFlush( void *pvContext );
+
+#endif /* CLI_PERF_EN */
+
+/* The definition of the "help" command.  This command is always present, in
+the static command table or as the first registered command. */
+static const CLI_Command_Definition_t xHelpCommand FreeRTOS_CLI_STATIC_COMMAND =
+{
+	"help",
+	"\r\nhelp:\r\n Lists all the registered commands\r\n\r\n",
+	NULL,
+	0,
+	prvHelpCommand,
+	NULL
+};
+
+/* Messages generated by the interpreter itself. */
+static const char * const pcIncorrectParametersMessage = "Incorrect command parameter(s).  Enter \"help\" to view a list of available commands.\r\n\r\n";
+static const char * const pcCommandNotRecognisedMessage = "Command not recognised.  Enter 'help' to view a list of available commands.\r\n\r\n";
+static const char * const pcNoScratchBufferMessage = "Command not available in this session.\r\n\r\n";
+
+/* Commands registered at run time, in registration order.  They are an
+overlay on top of the static command table, which lives in flash and needs no
+registration at all. */
+static const CLI_Command_Definition_t *pxRegisteredCommands[ configCOMMAND_INT_MAX_COMMANDS ];
+static UBaseType_t uxRegisteredCommandCount = 0;
+
+/* Open addressed hash index over all the commands.  Looking a command up costs
+one hash of the first word of the input plus, in the common case, one string
+compare, however many commands there are. */
+static CLI_Hash_Slot_t xCommandHashIndex[ configCOMMAND_INT_HASH_SIZE ];
+static BaseType_t xCommandIndexReady = pdFALSE;
+
+/* The buffers into which command outputs can be written, the scratch arena and
+the line buffers of the console are declared here, rather than in the command
+console implementation, to allow multiple command consoles to share the same
+buffers.  For example, an application may allow access to the command
+interpreter by UART and by Ethernet.  Sharing buffers is done purely to save
+RAM.  Note, however, that FreeRTOS_CLIProcessCommand() and
+FreeRTOS_CLIProcessCommandToSink() use these buffers and are not re-entrant, so
+no attempt at providing mutual exclusion to them is attempted.  Consoles that
+run concurrently use their own CLI_Session_t, scratch buffer and arena instead.
+The structure is aligned as the heap so any object can be placed in the
+arena. */
+static CLI_IO_Buffers_t xIOBuffers __attribute__( ( aligned( portBYTE_ALIGNMENT ) ) );
+
+/* Largest arena use of one execution, by command index.  prvIndexCommand()
+keeps every index below configCOMMAND_INT_HASH_SIZE / 2. */
+static size_t xArenaPeak[ configCOMMAND_INT_HASH_SIZE / 2 ];
+
+#if( CLI_PERF_EN == 1 )
+	/* Timings of the commands, by command index.  Only updated in critical
+	sections, as commands can be executed from several sessions. */
+	static CLI_Command_Perf_t xCommandPerf[ CLI_PERF_MAX_COMMANDS ];
+#endif
+
+
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister )
+{
+BaseType_t xReturn = pdFAIL;
+
+	/* Check the parameter is not NULL. */
+	configASSERT( pxCommandToRegister );
+
+	taskENTER_CRITICAL();
+	{
+		prvInitialiseCommandIndex();
+
+		if( uxRegisteredCommandCount < configCOMMAND_INT_MAX_COMMANDS )
+		{
+			pxRegisteredCommands[ uxRegisteredCommandCount ] = pxCommandToRegister;
+			xReturn = prvIndexCommand( cliSTATIC_COMMAND_COUNT() + uxRegisteredCommandCount );
+
+			if( xReturn == pdPASS )
+			{
+				uxRegisteredCommandCount++;
+			}
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	/* The command table is full, increase configCOMMAND_INT_MAX_COMMANDS or
+	configCOMMAND_INT_HASH_SIZE. */
+	configASSERT( xReturn == pdPASS );
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static const CLI_Command_Definition_t *prvGetCommand( UBaseType_t uxIndex )
+{
+	#if( configCOMMAND_INT_STATIC_TABLE == 1 )
+	{
+		if( uxIndex < cliSTATIC_COMMAND_COUNT() )
+		{
+			return &__cli_commands_start[ uxIndex ];
+		}
+	}
+	#endif
+
+	return pxRegisteredCommands[ uxIndex - cliSTATIC_COMMAND_COUNT() ];
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvIndexCommand( UBaseType_t uxIndex )
+{
+uint32_t ulHash;
+size_t xLength;
+UBaseType_t uxSlot;
+
+	/* Keep the index at most half full, so there is always an empty slot to
+	end a probe sequence. */
+	if( ( uxIndex + 1 ) > ( configCOMMAND_INT_HASH_SIZE / 2 ) )
+	{
+		return pdFAIL;
+	}
+
+	ulHash = prvHashCommandName( prvGetCommand( uxIndex )->pcCommand, &xLength );
+
+	/* Linear probing.  A command defined twice keeps the first definition, as
+	the lookup stops at the first match along the probe sequence. */
+	uxSlot = ulHash & ( configCOMMAND_INT_HASH_SIZE - 1 );
+	while( xCommandHashIndex[ uxSlot ].usCommand != 0 )
+	{
+		uxSlot = ( uxSlot + 1 ) & ( configCOMMAND_INT_HASH_SIZE - 1 );
+	}
+
+	xCommandHashIndex[ uxSlot ].usCommand = ( uint16_t ) ( uxIndex + 1 );
+	xCommandHashIndex[ uxSlot ].usTag = ( uint16_t ) ( ulHash >> 16 );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitialiseCommandIndex( void )
+{
+UBaseType_t uxIndex;
+BaseType_t xIndexed;
+
+	if( xCommandIndexReady != pdFALSE )
+	{
+		return;
+	}
+
+	#if( configCOMMAND_INT_STATIC_TABLE == 1 )
+	{
+		/* The static table is in flash already, only its names are hashed. */
+		for( uxIndex = 0; uxIndex < cliSTATIC_COMMAND_COUNT(); uxIndex++ )
+		{
+			xIndexed = prvIndexCommand( uxIndex );
+
+			/* Too many static commands, increase configCOMMAND_INT_HASH_SIZE. */
+			configASSERT( xIndexed == pdPASS );
+			( void ) xIndexed;
+		}
+	}
+	#else
+	{
+		pxRegisteredCommands[ 0 ] = &xHelpCommand;
+		uxRegisteredCommandCount = 1;
+		xIndexed = prvIndexCommand( 0 );
+		( void ) xIndexed;
+		( void ) uxIndex;
+	}
+	#endif
+
+	xCommandIndexReady = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHashCommandName( const char *pcString, size_t *pxLength )
+{
+uint32_t ulHash = 2166136261UL;
+const char *pcStart = pcString;
+
+	while( ( *pcString != 0x00 ) && ( *pcString != ' ' ) )
+	{
+		ulHash ^= ( uint8_t ) *pcString;
+		ulHash *= 16777619UL;
+		pcString++;
+	}
+
+	*pxLength = ( size_t ) ( pcString - pcStart );
+
+	return ulHash;
+}
+/*-----------------------------------------------------------*/
+
+static const CLI_Command_Definition_t *prvFindCommand( const char *pcCommandInput, CLI_Args_t *pxArgs, UBaseType_t *puxIndex )
+{
+const CLI_Command_Definition_t *pxCommand = NULL;
+const CLI_Command_Definition_t *pxCandidate;
+const char *pcWord;
+const char *pcWordStart;
+uint32_t ulHash;
+size_t xCommandStringLength;
+UBaseType_t uxSlot;
+
+	if( xCommandIndexReady == pdFALSE )
+	{
+		taskENTER_CRITICAL();
+		{
+			prvInitialiseCommandIndex();
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	/* Single pass over the command line: the command name is hashed, then the
+	start and length of each parameter is recorded. */
+	ulHash = prvHashCommandName( pcCommandInput, &xCommandStringLength );
+
+	pxArgs->pcCommandString = pcCommandInput;
+	pxArgs->uxCount = 0;
+	pcWord = pcCommandInput + xCommandStringLength;
+
+	for( ;; )
+	{
+		while( *pcWord == ' ' )
+		{
+			pcWord++;
+		}
+
+		if( *pcWord == 0x00 )
+		{
+			break;
+		}
+
+		pcWordStart = pcWord;
+		while( ( *pcWord != 0x00 ) && ( *pcWord != ' ' ) )
+		{
+			pcWord++;
+		}
+
+		/* Parameters that do not fit are counted but not recorded. */
+		if( pxArgs->uxCount < configCOMMAND_INT_MAX_PARAMETERS )
+		{
+			pxArgs->usOffset[ pxArgs->uxCount ] = ( uint16_t ) ( pcWordStart - pcCommandInput );
+			pxArgs->usLength[ pxArgs->uxCount ] = ( uint16_t ) ( pcWord - pcWordStart );
+			pxArgs->ulValue[ pxArgs->uxCount ] = 0;
+		}
+
+		pxArgs->uxCount++;
+	}
+
+	/* Walk the probe sequence of the hash until an empty slot is found.  The
+	string compare only runs for entries whose hash tag matches, and the length
+	check ensures a sub-string of a longer command is not picked up. */
+	uxSlot = ulHash & ( configCOMMAND_INT_HASH_SIZE - 1 );
+	while( xCommandHashIndex[ uxSlot ].usCommand != 0 )
+	{
+		if( xCommandHashIndex[ uxSlot ].usTag == ( uint16_t ) ( ulHash >> 16 ) )
+		{
+			pxCandidate = prvGetCommand( ( UBaseType_t ) xCommandHashIndex[ uxSlot ].usCommand - 1 );
+
+			if( ( strncmp( pcCommandInput, pxCandidate->pcCommand, xCommandStringLength ) == 0 ) &&
+				( pxCandidate->pcCommand[ xCommandStringLength ] == 0x00 ) )
+			{
+				pxCommand = pxCandidate;
+				*puxIndex = ( UBaseType_t ) xCommandHashIndex[ uxSlot ].usCommand - 1;
+				break;
+			}
+		}
+
+		uxSlot = ( uxSlot + 1 ) & ( configCOMMAND_INT_HASH_SIZE - 1 );
+	}
+
+	return pxCommand;
+}
+/*-----------------------------------------------------------*/
+
+static const CLI_Command_Definition_t *prvFindCommandById( uint32_t ulCommandId, UBaseType_t *puxIndex )
+{
+const CLI_Command_Definition_t *pxCandidate;
+size_t xLength;
+UBaseType_t uxSlot;
+
+	if( xCommandIndexReady == pdFALSE )
+	{
+		taskENTER_CRITICAL();
+		{
+			prvInitialiseCommandIndex();
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	/* Same probe sequence as prvFindCommand(), there is no name to compare so
+	the whole hash of the candidate is compared instead. */
+	uxSlot = ulCommandId & ( configCOMMAND_INT_HASH_SIZE - 1 );
+	while( xCommandHashIndex[ uxSlot ].usCommand != 0 )
+	{
+		if( xCommandHashIndex[ uxSlot ].usTag == ( uint16_t ) ( ulCommandId >> 16 ) )
+		{
+			pxCandidate = prvGetCommand( ( UBaseType_t ) xCommandHashIndex[ uxSlot ].usCommand - 1 );
+
+			if( prvHashCommandName( pxCandidate->pcCommand, &xLength ) == ulCommandId )
+			{
+				*puxIndex = ( UBaseType_t ) xCommandHashIndex[ uxSlot ].usCommand - 1;
+				return pxCandidate;
+			}
+		}
+
+		uxSlot = ( uxSlot + 1 ) & ( configCOMMAND_INT_HASH_SIZE - 1 );
+	}
+
+	return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvCheckParameters( const CLI_Command_Definition_t *pxCommand, CLI_Args_t *pxArgs, CLI_Output_Sink_t *pxSink )
+{
+const CLI_Param_Schema_t *pxSchema;
+const char *pcParameter;
+uint32_t ulMax;
+UBaseType_t uxIndex;
+BaseType_t xReturn = pdPASS;
+
+	/* If cExpectedNumberOfParameters is -1, then there could be a variable
+	number of parameters and no check is made.  Streaming commands only see the
+	parameters that were recorded. */
+	if( ( ( pxCommand->cExpectedNumberOfParameters >= 0 ) && ( pxArgs->uxCount != ( UBaseType_t ) pxCommand->cExpectedNumberOfParameters ) ) ||
+		( ( pxCommand->pxStreamInterpreter != NULL ) && ( pxArgs->uxCount > configCOMMAND_INT_MAX_PARAMETERS ) ) )
+	{
+		FreeRTOS_CLIPut( pxSink, pcIncorrectParametersMessage );
+		return pdFAIL;
+	}
+
+	if( pxCommand->pxParameterSchema == NULL )
+	{
+		return pdPASS;
+	}
+
+	/* A schema describes a fixed number of parameters. */
+	configASSERT( pxCommand->cExpectedNumberOfParameters >= 0 );
+
+	for( uxIndex = 0; ( uxIndex < pxArgs->uxCount ) && ( xReturn == pdPASS ); uxIndex++ )
+	{
+		pxSchema = &pxCommand->pxParameterSchema[ uxIndex ];
+		pcParameter = &pxArgs->pcCommandString[ pxArgs->usOffset[ uxIndex ] ];
+
+		switch( pxSchema->eType )
+		{
+			case eCLIParamU8:
+			case eCLIParamU32:
+				ulMax = pxSchema->ulMax;
+				if( ( pxSchema->eType == eCLIParamU8 ) && ( ulMax > 0xffUL ) )
+				{
+					ulMax = 0xffUL;
+				}
+
+				if( ( prvParseNumber( pcParameter, pxArgs->usLength[ uxIndex ], &pxArgs->ulValue[ uxIndex ] ) != pdPASS ) ||
+					( pxArgs->ulValue[ uxIndex ] < pxSchema->ulMin ) ||
+					( pxArgs->ulValue[ uxIndex ] > ulMax ) )
+				{
+					FreeRTOS_CLIPrintf( pxSink, "Parameter %u: expected a number from %lu to %lu.\r\n",
+										( unsigned ) ( uxIndex + 1 ), ( unsigned long ) pxSchema->ulMin, ( unsigned long ) ulMax );
+					xReturn = pdFAIL;
+				}
+				break;
+
+			case eCLIParamChar:
+				pxArgs->ulValue[ uxIndex ] = ( uint8_t ) *pcParameter;
+
+				if( ( pxArgs->usLength[ uxIndex ] != 1 ) ||
+					( pxArgs->ulValue[ uxIndex ] < pxSchema->ulMin ) ||
+					( pxArgs->ulValue[ uxIndex ] > pxSchema->ulMax ) )
+				{
+					FreeRTOS_CLIPrintf( pxSink, "Parameter %u: expected a character from '%c' to '%c'.\r\n",
+										( unsigned ) ( uxIndex + 1 ), ( char ) pxSchema->ulMin, ( char ) pxSchema->ulMax );
+					xReturn = pdFAIL;
+				}
+				break;
+
+			case eCLIParamEnum:
+				if( prvParseChoice( pxSchema->pcChoices, pcParameter, pxArgs->usLength[ uxIndex ], &pxArgs->ulValue[ uxIndex ] ) != pdPASS )
+				{
+					FreeRTOS_CLIPrintf( pxSink, "Parameter %u: expected one of %s.\r\n",
+										( unsigned ) ( uxIndex + 1 ), pxSchema->pcChoices );
+					xReturn = pdFAIL;
+				}
+				break;
+
+			case eCLIParamString:
+			default:
+				break;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvUnpackParameters( const CLI_Command_Definition_t *pxCommand, CLI_Args_t *pxArgs, const uint8_t *pucParameters, size_t xParametersLength )
+{
+const CLI_Param_Schema_t *pxSchema = NULL;
+const char *pcChoice;
+CLI_Param_Type_t eType = eCLIParamString;
+uint32_t ulMin = 0;
+uint32_t ulMax = 0;
+uint32_t ulValue;
+size_t xPosition = 0;
+size_t xLength;
+
+	pxArgs->pcCommandString = ( const char * ) pucParameters;
+	pxArgs->uxCount = 0;
+
+	/* Commands that do not stream their output read the command line, which
+	does not exist here. */
+	if( ( pxCommand->pxStreamInterpreter == NULL ) && ( xParametersLength > 0 ) )
+	{
+		return pdFAIL;
+	}
+
+	while( xPosition < xParametersLength )
+	{
+		if( ( pxArgs->uxCount >= configCOMMAND_INT_MAX_PARAMETERS ) ||
+			( ( pxCommand->cExpectedNumberOfParameters >= 0 ) && ( pxArgs->uxCount >= ( UBaseType_t ) pxCommand->cExpectedNumberOfParameters ) ) )
+		{
+			return pdFAIL;
+		}
+
+		if( pxCommand->pxParameterSchema != NULL )
+		{
+			pxSchema = &pxCommand->pxParameterSchema[ pxArgs->uxCount ];
+			eType = pxSchema->eType;
+			ulMin = pxSchema->ulMin;
+			ulMax = pxSchema->ulMax;
+		}
+
+		switch( eType )
+		{
+			case eCLIParamU32:
+				xLength = sizeof( uint32_t );
+				if( ( xParametersLength - xPosition ) < xLength )
+				{
+					return pdFAIL;
+				}
+
+				ulValue = ( uint32_t ) pucParameters[ xPosition ] |
+						  ( ( uint32_t ) pucParameters[ xPosition + 1 ] << 8 ) |
+						  ( ( uint32_t ) pucParameters[ xPosition + 2 ] << 16 ) |
+						  ( ( uint32_t ) pucParameters[ xPosition + 3 ] << 24 );
+				break;
+
+			case eCLIParamEnum:
+				/* The value is the position of the word, count the words. */
+				ulMax = 0;
+				for( pcChoice = pxSchema->pcChoices; *pcChoice != 0x00; pcChoice++ )
+				{
+					if( *pcChoice == '|' )
+					{
+						ulMax++;
+					}
+				}
+				/* Fall through. */
+
+			case eCLIParamU8:
+			case eCLIParamChar:
+				xLength = 1;
+				ulValue = pucParameters[ xPosition ];
+				break;
+
+			case eCLIParamString:
+			default:
+				/* A length byte, then the characters. */
+				xLength = ( size_t ) pucParameters[ xPosition ] + 1;
+				if( ( xParametersLength - xPosition ) < xLength )
+				{
+					return pdFAIL;
+				}
+
+				ulValue = 0;
+				ulMin = 0;
+				ulMax = 0;
+				pxArgs->usOffset[ pxArgs->uxCount ] = ( uint16_t ) ( xPosition + 1 );
+				pxArgs->usLength[ pxArgs->uxCount ] = ( uint16_t ) ( xLength - 1 );
+				break;
+		}
+
+		if( ( ulValue < ulMin ) || ( ulValue > ulMax ) )
+		{
+			return pdFAIL;
+		}
+
+		if( eType != eCLIParamString )
+		{
+			pxArgs->usOffset[ pxArgs->uxCount ] = ( uint16_t ) xPosition;
+			pxArgs->usLength[ pxArgs->uxCount ] = ( uint16_t ) xLength;
+		}
+
+		pxArgs->ulValue[ pxArgs->uxCount ] = ulValue;
+		pxArgs->uxCount++;
+		xPosition += xLength;
+	}
+
+	if( ( pxCommand->cExpectedNumberOfParameters >= 0 ) && ( pxArgs->uxCount != ( UBaseType_t ) pxCommand->cExpectedNumberOfParameters ) )
+	{
+		return pdFAIL;
+	}
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseNumber( const char *pcString, size_t xLength, uint32_t *pulValue )
+{
+uint32_t ulValue = 0;
+uint32_t ulDigit;
+
+	if( xLength == 0 )
+	{
+		return pdFAIL;
+	}
+
+	while( xLength > 0 )
+	{
+		if( ( *pcString < '0' ) || ( *pcString > '9' ) )
+		{
+			return pdFAIL;
+		}
+
+		ulDigit = ( uint32_t ) ( *pcString - '0' );
+
+		/* Reject values that do not fit in 32 bits. */
+		if( ulValue > ( ( 0xffffffffUL - ulDigit ) / 10UL ) )
+		{
+			return pdFAIL;
+		}
+
+		ulValue = ( ulValue * 10UL ) + ulDigit;
+		pcString++;
+		xLength--;
+	}
+
+	*pulValue = ulValue;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvParseChoice( const char *pcChoices, const char *pcString, size_t xLength, uint32_t *pulValue )
+{
+uint32_t ulChoice = 0;
+size_t xMatched;
+
+	configASSERT( pcChoices );
+
+	while( *pcChoices != 0x00 )
+	{
+		/* Compare the parameter with the current word, ignoring case. */
+		xMatched = 0;
+		while( ( xMatched < xLength ) && ( pcChoices[ xMatched ] != 0x00 ) && ( pcChoices[ xMatched ] != '|' ) &&
+			   ( ( pcChoices[ xMatched ] | 0x20 ) == ( pcString[ xMatched ] | 0x20 ) ) )
+		{
+			xMatched++;
+		}
+
+		if( ( xMatched == xLength ) && ( ( pcChoices[ xMatched ] == 0x00 ) || ( pcChoices[ xMatched ] == '|' ) ) )
+		{
+			*pulValue = ulChoice;
+			return pdPASS;
+		}
+
+		/* Move on to the next word. */
+		while( ( *pcChoices != 0x00 ) && ( *pcChoices != '|' ) )
+		{
+			pcChoices++;
+		}
+
+		if( *pcChoices == '|' )
+		{
+			pcChoices++;
+		}
+
+		ulChoice++;
+	}
+
+	return pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  )
+{
+static CLI_Session_t xSession = { NULL, NULL, 0, NULL };
+BaseType_t xReturn = pdFALSE;
+CLI_Buffer_Sink_Context_t xBufferContext;
+CLI_Output_Sink_t xBufferSink;
+
+	/* Note:  This function is not re-entrant.  It must not be called from more
+	thank one task.  Use FreeRTOS_CLISessionExecute() instead. */
+
+	/* Messages from the interpreter and the output of streaming commands are
+	written into the caller's buffer.  Output that does not fit is lost. */
+	xBufferContext.pcBuffer = pcWriteBuffer;
+	xBufferContext.xBufferLength = xWriteBufferLen;
+	xBufferContext.xUsed = 0;
+	xBufferSink.pxPut = prvBufferSinkPut;
+	xBufferSink.pxFlush = NULL;
+	xBufferSink.pvContext = &xBufferContext;
+	xSession.pxSink = &xBufferSink;
+
+	if( xSession.pxCommand == NULL )
+	{
+		if( xWriteBufferLen > 0 )
+		{
+			pcWriteBuffer[ 0 ] = 0x00;
+		}
+
+		xSession.xArgs.pxSession = &xSession;
+		xSession.pxCommand = prvFindCommand( pcCommandInput, &xSession.xArgs, &xSession.uxCommandIndex );
+
+		if( xSession.pxCommand == NULL )
+		{
+			/* The command was not found. */
+			FreeRTOS_CLIPut( &xBufferSink, pcCommandNotRecognisedMessage );
+		}
+		else if( prvCheckParameters( xSession.pxCommand, &xSession.xArgs, &xBufferSink ) != pdPASS )
+		{
+			/* The command was found, but its parameters are not correct. */
+			xSession.pxCommand = NULL;
+		}
+		else if( xSession.pxCommand->pxStreamInterpreter != NULL )
+		{
+			/* Streaming commands produce all their output in one call. */
+			FreeRTOS_CLISessionSetArena( &xSession, FreeRTOS_CLIGetArena(), configCOMMAND_INT_ARENA_SIZE );
+			( void ) xSession.pxCommand->pxStreamInterpreter( &xBufferSink, &xSession.xArgs );
+			prvArenaRelease( &xSession );
+			xSession.pxCommand = NULL;
+		}
+	}
+
+	if( xSession.pxCommand != NULL )
+	{
+		/* Call the callback function that is registered to this command. */
+		xReturn = xSession.pxCommand->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
+
+		/* If xReturn is pdFALSE, then no further strings will be returned
+		after this one, and	pxCommand can be reset to NULL ready to search
+		for the next entered command. */
+		if( xReturn == pdFALSE )
+		{
+			xSession.pxCommand = NULL;
+		}
+	}
+
+	xSession.pxSink = NULL;
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLISessionInit( CLI_Session_t *pxSession, CLI_Output_Sink_t *pxSink, char *pcScratchBuffer, size_t xScratchBufferLength )
+{
+	configASSERT( pxSession );
+	configASSERT( pxSink );
+
+	memset( pxSession, 0x00, sizeof( CLI_Session_t ) );
+	pxSession->pxSink = pxSink;
+	pxSession->pcScratchBuffer = pcScratchBuffer;
+	pxSession->xScratchBufferLength = xScratchBufferLength;
+	pxSession->xArgs.pxSession = pxSession;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLISessionSetArena( CLI_Session_t *pxSession, void *pvArena, size_t xArenaLength )
+{
+	configASSERT( pxSession );
+	configASSERT( ( ( ( size_t ) pvArena ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+	pxSession->pucArena = ( uint8_t * ) pvArena;
+	pxSession->xArenaLength = ( pvArena != NULL ) ? xArenaLength : 0;
+	pxSession->xArenaUsed = 0;
+}
+/*-----------------------------------------------------------*/
+
+void FreeRTOS_CLISessionSetInteractive( CLI_Session_t *pxSession, BaseType_t xInteractive )
+{
+	configASSERT( pxSession );
+
+	pxSession->xInteractive = xInteractive;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIIsInteractive( const CLI_Args_t *pxArgs )
+{
+	return pxArgs->pxSession->xInteractive;
+}
+/*-----------------------------------------------------------*/
+
+void *FreeRTOS_CLIArenaAlloc( const CLI_Args_t *pxArgs, size_t xSize )
+{
+CLI_Session_t *pxSession = pxArgs->pxSession;
+void *pvReturn = NULL;
+
+	xSize = ( xSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	/* xArenaUsed stays aligned, so every allocation is. */
+	if( ( xSize != 0 ) && ( xSize <= ( pxSession->xArenaLength - pxSession->xArenaUsed ) ) )
+	{
+		pvReturn = &pxSession->pucArena[ pxSession->xArenaUsed ];
+		pxSession->xArenaUsed += xSize;
+	}
+
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+static void prvArenaRelease( CLI_Session_t *pxSession )
+{
+UBaseType_t uxIndex = pxSession->uxCommandIndex;
+
+	/* Nothing is freed during a command, what is in use now is its peak. */
+	if( ( pxSession->pxCommand != NULL ) && ( pxSession->xArenaUsed != 0 ) )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( ( uxIndex < ( configCOMMAND_INT_HASH_SIZE / 2 ) ) && ( pxSession->xArenaUsed > xArenaPeak[ uxIndex ] ) )
+			{
+				xArenaPeak[ uxIndex ] = pxSession->xArenaUsed;
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+	pxSession->xArenaUsed = 0;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIGetArenaPeak( UBaseType_t uxIndex, const char **ppcCommand, size_t *pxPeak )
 {
-	const CLI_Command_Definition_t *pxCommandLineDefinition;
-	struct xCOMMAND_INPUT_LIST *pxNext;
-} CLI_Definition_List_Item_t;
+	configASSERT( ppcCommand );
+	configASSERT( pxPeak );
 
-/*
- * The callback function that is executed when "help" is entered.  This is the
- * only default command that is always present.
- */
-static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
+	if( uxIndex >= ( cliSTATIC_COMMAND_COUNT() + uxRegisteredCommandCount ) )
+	{
+		return pdFAIL;
+	}
 
-/*
- * Return the number of parameters that follow the command name.
- */
-static int8_t prvGetNumberOfParameters( const char *pcCommandString );
+	*ppcCommand = prvGetCommand( uxIndex )->pcCommand;
+	*pxPeak = xArenaPeak[ uxIndex ];
 
-/* The definition of the "help" command.  This command is always at the front
-of the list of registered commands. */
-static const CLI_Command_Definition_t xHelpCommand =
-{
-	"help",
-	"\r\nhelp:\r\n Lists all the registered commands\r\n\r\n",
-	prvHelpCommand,
-	0
-};
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
 
-/* The definition of the list of commands.  Commands that are registered are
-added to this list. */
-static CLI_Definition_List_Item_t xRegisteredCommands =
+BaseType_t FreeRTOS_CLISessionExecute( CLI_Session_t *pxSession, const char * const pcCommandInput )
 {
-	&xHelpCommand,	/* The first command in the list is always the help command, defined in this file. */
-	NULL			/* The next pointer is initialised to NULL, as there are no other registered commands yet. */
-};
+BaseType_t xReturn;
 
-/* A buffer into which command outputs can be written is declared here, rather
-than in the command console implementation, to allow multiple command consoles
-to share the same buffer.  For example, an application may allow access to the
-command interpreter by UART and by Ethernet.  Sharing a buffer is done purely
-to save RAM.  Note, however, that the command console itself is not re-entrant,
-so only one command interpreter interface can be used at any one time.  For that
-reason, no attempt at providing mutual exclusion to the cOutputBuffer array is
-attempted.
-
-configAPPLICATION_PROVIDES_cOutputBuffer is provided to allow the application
-writer to provide their own cOutputBuffer declaration in cases where the
-buffer needs to be placed at a fixed address (rather than by the linker). */
-#if( configAPPLICATION_PROVIDES_cOutputBuffer == 0 )
-	static char cOutputBuffer[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];
-#else
-	extern char cOutputBuffer[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];
-#endif
+	configASSERT( pxSession );
+
+	#if( CLI_PERF_EN == 1 )
+	{
+		prvPerfBegin( pxSession );
+	}
+	#endif
+
+	/* Everything the command needs lives in the session, so sessions used by
+	different tasks do not share any state. */
+	pxSession->pxCommand = prvFindCommand( pcCommandInput, &pxSession->xArgs, &pxSession->uxCommandIndex );
+
+	#if( CLI_PERF_EN == 1 )
+	{
+		prvPerfPhaseEnd( pxSession );
+	}
+	#endif
+
+	if( pxSession->pxCommand == NULL )
+	{
+		FreeRTOS_CLIPut( pxSession->pxSink, pcCommandNotRecognisedMessage );
+		xReturn = pdFAIL;
+	}
+	else if( prvCheckParameters( pxSession->pxCommand, &pxSession->xArgs, pxSession->pxSink ) != pdPASS )
+	{
+		xReturn = pdFAIL;
+	}
+	else
+	{
+		#if( CLI_PERF_EN == 1 )
+		{
+			prvPerfPhaseEnd( pxSession );
+		}
+		#endif
+
+		xReturn = prvRunCommand( pxSession, pcCommandInput );
+	}
 
+	FreeRTOS_CLIFlush( pxSession->pxSink );
 
+	#if( CLI_PERF_EN == 1 )
+	{
+		prvPerfEnd( pxSession );
+	}
+	#endif
+
+	/* The command returned, its scratch memory goes back in one step. */
+	prvArenaRelease( pxSession );
+	pxSession->pxCommand = NULL;
+
+	return xReturn;
+}
 /*-----------------------------------------------------------*/
 
-BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister )
+CLI_Packed_Status_t FreeRTOS_CLISessionExecutePacked( CLI_Session_t *pxSession, uint32_t ulCommandId, const uint8_t *pucParameters, size_t xParametersLength )
 {
-static CLI_Definition_List_Item_t *pxLastCommandInList = &xRegisteredCommands;
-CLI_Definition_List_Item_t *pxNewListItem;
-BaseType_t xReturn = pdFAIL;
+CLI_Packed_Status_t eReturn;
 
-	/* Check the parameter is not NULL. */
-	configASSERT( pxCommandToRegister );
+	configASSERT( pxSession );
+	configASSERT( ( pucParameters != NULL ) || ( xParametersLength == 0 ) );
+
+	#if( CLI_PERF_EN == 1 )
+	{
+		prvPerfBegin( pxSession );
+	}
+	#endif
 
-	/* Create a new list item that will reference the command being registered. */
-	pxNewListItem = ( CLI_Definition_List_Item_t * ) pvPortMalloc( sizeof( CLI_Definition_List_Item_t ) );
-	configASSERT( pxNewListItem );
+	/* Commands that do not stream their output are only accepted without
+	parameters, so the command name is all of their command line. */
+	pxSession->pxCommand = prvFindCommandById( ulCommandId, &pxSession->uxCommandIndex );
 
-	if( pxNewListItem != NULL )
+	#if( CLI_PERF_EN == 1 )
 	{
-		taskENTER_CRITICAL();
+		prvPerfPhaseEnd( pxSession );
+	}
+	#endif
+
+	if( pxSession->pxCommand == NULL )
+	{
+		eReturn = eCLIPackedUnknownCommand;
+	}
+	else if( prvUnpackParameters( pxSession->pxCommand, &pxSession->xArgs, pucParameters, xParametersLength ) != pdPASS )
+	{
+		eReturn = eCLIPackedBadParameters;
+	}
+	else
+	{
+		#if( CLI_PERF_EN == 1 )
 		{
-			/* Reference the command being registered from the newly created
-			list item. */
-			pxNewListItem->pxCommandLineDefinition = pxCommandToRegister;
+			prvPerfPhaseEnd( pxSession );
+		}
+		#endif
+
+		eReturn = ( prvRunCommand( pxSession, pxSession->pxCommand->pcCommand ) == pdPASS ) ? eCLIPackedOk : eCLIPackedFailed;
+	}
 
-			/* The new list item will get added to the end of the list, so
-			pxNext has nowhere to point. */
-			pxNewListItem->pxNext = NULL;
+	FreeRTOS_CLIFlush( pxSession->pxSink );
 
-			/* Add the newly created list item to the end of the already existing
-			list. */
-			pxLastCommandInList->pxNext = pxNewListItem;
+	#if( CLI_PERF_EN == 1 )
+	{
+		prvPerfEnd( pxSession );
+	}
+	#endif
 
-			/* Set the end of list marker to the new list item. */
-			pxLastCommandInList = pxNewListItem;
-		}
-		taskEXIT_CRITICAL();
+	/* The command returned, its scratch memory goes back in one step. */
+	prvArenaRelease( pxSession );
+	pxSession->pxCommand = NULL;
+
+	return eReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvRunCommand( CLI_Session_t *pxSession, const char *pcCommandInput )
+{
+CLI_Output_Sink_t *pxSink = pxSession->pxSink;
+BaseType_t xMoreDataToProcess;
+
+	if( pxSession->pxCommand->pxStreamInterpreter != NULL )
+	{
+		return pxSession->pxCommand->pxStreamInterpreter( pxSink, &pxSession->xArgs );
+	}
+
+	if( ( pxSession->pcScratchBuffer == NULL ) || ( pxSession->xScratchBufferLength == 0 ) )
+	{
+		/* The session cannot run commands that need an output buffer. */
+		FreeRTOS_CLIPut( pxSink, pcNoScratchBufferMessage );
+		return pdFAIL;
+	}
+
+	/* Adapter for commands written against pdCOMMAND_LINE_CALLBACK: each
+	string they generate goes through the scratch buffer of the session and is
+	forwarded to the sink straight away. */
+	do
+	{
+		pxSession->pcScratchBuffer[ 0 ] = 0x00;
+		xMoreDataToProcess = pxSession->pxCommand->pxCommandInterpreter( pxSession->pcScratchBuffer, pxSession->xScratchBufferLength, pcCommandInput );
+		pxSession->pcScratchBuffer[ pxSession->xScratchBufferLength - 1 ] = 0x00;
+		FreeRTOS_CLIPut( pxSink, pxSession->pcScratchBuffer );
+	} while( xMoreDataToProcess != pdFALSE );
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t FreeRTOS_CLICommandId( const char *pcCommand )
+{
+size_t xLength;
+
+	return prvHashCommandName( pcCommand, &xLength );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIProcessCommandToSink( const char * const pcCommandInput, CLI_Output_Sink_t *pxSink )
+{
+static CLI_Session_t xSession;
+
+	FreeRTOS_CLISessionInit( &xSession, pxSink, xIOBuffers.cOutput, configCOMMAND_INT_MAX_OUTPUT_SIZE );
+	FreeRTOS_CLISessionSetArena( &xSession, FreeRTOS_CLIGetArena(), configCOMMAND_INT_ARENA_SIZE );
+
+	return FreeRTOS_CLISessionExecute( &xSession, pcCommandInput );
+}
+/*-----------------------------------------------------------*/
 
-		xReturn = pdPASS;
+BaseType_t FreeRTOS_CLIWrite( CLI_Output_Sink_t *pxSink, const char *pcData, size_t xLength )
+{
+	if( xLength == 0 )
+	{
+		return pdPASS;
+	}
+
+	return pxSink->pxPut( pxSink->pvContext, pcData, xLength );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIPut( CLI_Output_Sink_t *pxSink, const char *pcString )
+{
+	return FreeRTOS_CLIWrite( pxSink, pcString, strlen( pcString ) );
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t FreeRTOS_CLIPrintf( CLI_Output_Sink_t *pxSink, const char *pcFormat, ... )
+{
+char cLine[ configCOMMAND_INT_PRINTF_BUFFER_SIZE ];
+va_list xArgs;
+int iLength;
+BaseType_t xReturn = pdPASS;
+
+	va_start( xArgs, pcFormat );
+	iLength = vsnprintf( cLine, sizeof( cLine ), pcFormat, xArgs );
+	va_end( xArgs );
+
+	if( iLength <= 0 )
+	{
+		return ( iLength == 0 ) ? pdPASS : pdFAIL;
+	}
+
+	/* Anything longer than the line buffer is truncated, the caller is told
+	so it does not go unnoticed. */
+	if( iLength >= ( int ) sizeof( cLine ) )
+	{
+		iLength = sizeof( cLine ) - 1;
+		xReturn = pdFAIL;
+	}
+
+	if( pxSink->pxPut( pxSink->pvContext, cLine, ( size_t ) iLength ) != pdPASS )
+	{
+		xReturn = pdFAIL;
 	}
 
 	return xReturn;
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  )
+void FreeRTOS_CLIFlush( CLI_Output_Sink_t *pxSink )
 {
-static const CLI_Definition_List_Item_t *pxCommand = NULL;
-BaseType_t xReturn = pdTRUE;
-const char *pcRegisteredCommandString;
-size_t xCommandStringLength;
+	if( pxSink->pxFlush != NULL )
+	{
+		pxSink->pxFlush( pxSink->pvContext );
+	}
+}
+/*-----------------------------------------------------------*/
 
-	/* Note:  This function is not re-entrant.  It must not be called from more
-	thank one task. */
+static BaseType_t prvBufferSinkPut( void *pvContext, const char *pcData, size_t xDataLength )
+{
+CLI_Buffer_Sink_Context_t *pxContext = ( CLI_Buffer_Sink_Context_t * ) pvContext;
+size_t xSpace;
+
+	if( pxContext->xUsed + 1 >= pxContext->xBufferLength )
+	{
+		return pdFAIL;
+	}
 
-	if( pxCommand == NULL )
+	/* Keep room for the terminating NULL. */
+	xSpace = pxContext->xBufferLength - pxContext->xUsed - 1;
+	if( xDataLength > xSpace )
 	{
-		/* Search for the command string in the list of registered commands. */
-		for( pxCommand = &xRegisteredCommands; pxCommand != NULL; pxCommand = pxCommand->pxNext )
+		xDataLength = xSpace;
+	}
+
+	memcpy( &pxContext->pcBuffer[ pxContext->xUsed ], pcData, xDataLength );
+	pxContext->xUsed += xDataLength;
+	pxContext->pcBuffer[ pxContext->xUsed ] = 0x00;
+
+	return pdPASS;
+}
+/*-----------------------------------------------------------*/
+
+#if( CLI_PERF_EN == 1 )
+
+	static void prvPerfBegin( CLI_Session_t *pxSession )
+	{
+		memset( pxSession->xPerfPhase, 0x00, sizeof( pxSession->xPerfPhase ) );
+		pxSession->xPerfOutput = 0;
+		pxSession->ePerfPhase = eCLIPhaseLookup;
+
+		/* Output written by the interpreter and by the command is timed on its
+		way to the sink of the session. */
+		pxSession->pxPerfTarget = pxSession->pxSink;
+		pxSession->xPerfSink.pxPut = prvPerfSinkPut;
+		pxSession->xPerfSink.pxFlush = prvPerfSinkFlush;
+		pxSession->xPerfSink.pvContext = pxSession;
+		pxSession->pxSink = &pxSession->xPerfSink;
+
+		pxSession->xPerfMark = cliPERF_NOW();
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvPerfPhaseEnd( CLI_Session_t *pxSession )
+	{
+	configRUN_TIME_COUNTER_TYPE xNow = cliPERF_NOW();
+
+		pxSession->xPerfPhase[ pxSession->ePerfPhase ] += ( xNow - pxSession->xPerfMark ) - pxSession->xPerfOutput;
+		pxSession->xPerfPhase[ eCLIPhaseOutput ] += pxSession->xPerfOutput;
+		pxSession->xPerfOutput = 0;
+		pxSession->xPerfMark = xNow;
+
+		/* The handler is the last phase, the output is timed along the way. */
+		if( pxSession->ePerfPhase < eCLIPhaseHandler )
+		{
+			pxSession->ePerfPhase = ( CLI_Perf_Phase_t ) ( pxSession->ePerfPhase + 1 );
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvPerfRecord( CLI_Perf_Stat_t *pxStat, configRUN_TIME_COUNTER_TYPE xTime, BaseType_t xFirst )
+	{
+	uint32_t ulTime = ( xTime > UINT32_MAX ) ? UINT32_MAX : ( uint32_t ) xTime;
+
+		if( ( xFirst != pdFALSE ) || ( ulTime < pxStat->ulMin ) )
 		{
-			pcRegisteredCommandString = pxCommand->pxCommandLineDefinition->pcCommand;
-			xCommandStringLength = strlen( pcRegisteredCommandString );
+			pxStat->ulMin = ulTime;
+		}
 
-			/* To ensure the string lengths match exactly, so as not to pick up
-			a sub-string of a longer command, check the byte after the expected
-			end of the string is either the end of the string or a space before
-			a parameter. */
-			if( strncmp( pcCommandInput, pcRegisteredCommandString, xCommandStringLength ) == 0 )
-			{
-				if( ( pcCommandInput[ xCommandStringLength ] == ' ' ) || ( pcCommandInput[ xCommandStringLength ] == 0x00 ) )
-				{
-					/* The command has been found.  Check it has the expected
-					number of parameters.  If cExpectedNumberOfParameters is -1,
-					then there could be a variable number of parameters and no
-					check is made. */
-					if( pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters >= 0 )
-					{
-						if( prvGetNumberOfParameters( pcCommandInput ) != pxCommand->pxCommandLineDefinition->cExpectedNumberOfParameters )
-						{
-							xReturn = pdFALSE;
-						}
-					}
+		if( ulTime > pxStat->ulMax )
+		{
+			pxStat->ulMax = ulTime;
+		}
 
-					break;
-				}
+		pxStat->ullSum += xTime;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvPerfEnd( CLI_Session_t *pxSession )
+	{
+	CLI_Command_Perf_t *pxPerf;
+	configRUN_TIME_COUNTER_TYPE xTotal = 0;
+	uint64_t ullMicroseconds;
+	UBaseType_t uxIndex;
+	UBaseType_t uxPhase;
+	UBaseType_t uxBin = 0;
+	BaseType_t xFirst;
+
+		prvPerfPhaseEnd( pxSession );
+		pxSession->pxSink = pxSession->pxPerfTarget;
+
+		if( pxSession->pxCommand == NULL )
+		{
+			/* Unknown commands are not recorded. */
+			return;
+		}
+
+		uxIndex = pxSession->uxCommandIndex;
+
+		if( uxIndex >= CLI_PERF_MAX_COMMANDS )
+		{
+			return;
+		}
+
+		for( uxPhase = 0; uxPhase < eCLIPhaseCount; uxPhase++ )
+		{
+			xTotal += pxSession->xPerfPhase[ uxPhase ];
+		}
+
+		/* Bin is the number of significant bits of the total time in us. */
+		ullMicroseconds = RUN_TIME_COUNTER_TO_US( ( uint64_t ) xTotal );
+		while( ( ullMicroseconds != 0 ) && ( uxBin < ( CLI_PERF_BINS - 1 ) ) )
+		{
+			ullMicroseconds >>= 1;
+			uxBin++;
+		}
+
+		pxPerf = &xCommandPerf[ uxIndex ];
+
+		taskENTER_CRITICAL();
+		{
+			xFirst = ( pxPerf->ulCount == 0 ) ? pdTRUE : pdFALSE;
+
+			for( uxPhase = 0; uxPhase < eCLIPhaseCount; uxPhase++ )
+			{
+				prvPerfRecord( &pxPerf->xPhase[ uxPhase ], pxSession->xPerfPhase[ uxPhase ], xFirst );
 			}
+
+			prvPerfRecord( &pxPerf->xTotal, xTotal, xFirst );
+			pxPerf->ulBins[ uxBin ]++;
+			pxPerf->ulCount++;
 		}
+		taskEXIT_CRITICAL();
 	}
+	/*-----------------------------------------------------------*/
 
-	if( ( pxCommand != NULL ) && ( xReturn == pdFALSE ) )
+	static BaseType_t prvPerfSinkPut( void *pvContext, const char *pcData, size_t xDataLength )
 	{
-		/* The command was found, but the number of parameters with the command
-		was incorrect. */
-		strncpy( pcWriteBuffer, "Incorrect command parameter(s).  Enter \"help\" to view a list of available commands.\r\n\r\n", xWriteBufferLen );
-		pxCommand = NULL;
+	CLI_Session_t *pxSession = ( CLI_Session_t * ) pvContext;
+	configRUN_TIME_COUNTER_TYPE xStart = cliPERF_NOW();
+	BaseType_t xReturn;
+
+		xReturn = pxSession->pxPerfTarget->pxPut( pxSession->pxPerfTarget->pvContext, pcData, xDataLength );
+		pxSession->xPerfOutput += cliPERF_NOW() - xStart;
+
+		return xReturn;
 	}
-	else if( pxCommand != NULL )
+	/*-----------------------------------------------------------*/
+
+	static void prvPerfSinkFlush( void *pvContext )
 	{
-		/* Call the callback function that is registered to this command. */
-		xReturn = pxCommand->pxCommandLineDefinition->pxCommandInterpreter( pcWriteBuffer, xWriteBufferLen, pcCommandInput );
+	CLI_Session_t *pxSession = ( CLI_Session_t * ) pvContext;
+	configRUN_TIME_COUNTER_TYPE xStart = cliPERF_NOW();
 
-		/* If xReturn is pdFALSE, then no further strings will be returned
-		after this one, and	pxCommand can be reset to NULL ready to search
-		for the next entered command. */
-		if( xReturn == pdFALSE )
+		FreeRTOS_CLIFlush( pxSession->pxPerfTarget );
+		pxSession->xPerfOutput += cliPERF_NOW() - xStart;
+	}
+	/*-----------------------------------------------------------*/
+
+	BaseType_t FreeRTOS_CLIGetCommandPerf( UBaseType_t uxIndex, const char **ppcCommand, CLI_Command_Perf_t *pxPerf )
+	{
+		configASSERT( ppcCommand );
+		configASSERT( pxPerf );
+
+		/* Commands past CLI_PERF_MAX_COMMANDS are not timed */
+		if( ( uxIndex >= ( cliSTATIC_COMMAND_COUNT() + uxRegisteredCommandCount ) ) ||
+			( uxIndex >= CLI_PERF_MAX_COMMANDS ) )
+		{
+			return pdFAIL;
+		}
+
+		*ppcCommand = prvGetCommand( uxIndex )->pcCommand;
+
+		taskENTER_CRITICAL();
 		{
-			pxCommand = NULL;
+			*pxPerf = xCommandPerf[ uxIndex ];
 		}
+		taskEXIT_CRITICAL();
+
+		return pdPASS;
 	}
-	else
+	/*-----------------------------------------------------------*/
+
+	void FreeRTOS_CLIResetCommandPerf( void )
 	{
-		/* pxCommand was NULL, the command was not found. */
-		strncpy( pcWriteBuffer, "Command not recognised.  Enter 'help' to view a list of available commands.\r\n\r\n", xWriteBufferLen );
-		xReturn = pdFALSE;
+		taskENTER_CRITICAL();
+		{
+			memset( xCommandPerf, 0x00, sizeof( xCommandPerf ) );
+		}
+		taskEXIT_CRITICAL();
 	}
+	/*-----------------------------------------------------------*/
 
-	return xReturn;
+#endif /* CLI_PERF_EN */
+
+char *FreeRTOS_CLIGetOutputBuffer( void )
+{
+	return xIOBuffers.cOutput;
 }
 /*-----------------------------------------------------------*/
 
-char *FreeRTOS_CLIGetOutputBuffer( void )
+void *FreeRTOS_CLIGetArena( void )
+{
+	#if( configCOMMAND_INT_ARENA_SIZE > 0 )
+	{
+		return xIOBuffers.ucArena;
+	}
+	#else
+	{
+		return NULL;
+	}
+	#endif
+}
+/*-----------------------------------------------------------*/
+
+CLI_IO_Buffers_t *FreeRTOS_CLIGetIOBuffers( void )
+{
+	return &xIOBuffers;
+}
+/*-----------------------------------------------------------*/
+
+const char *FreeRTOS_CLIGetArg( const CLI_Args_t *pxArgs, UBaseType_t uxParameter, size_t *pxLength )
 {
-	return cOutputBuffer;
+	if( ( uxParameter >= pxArgs->uxCount ) || ( uxParameter >= configCOMMAND_INT_MAX_PARAMETERS ) )
+	{
+		*pxLength = 0;
+		return NULL;
+	}
+
+	*pxLength = pxArgs->usLength[ uxParameter ];
+
+	return &pxArgs->pcCommandString[ pxArgs->usOffset[ uxParameter ] ];
 }
 /*-----------------------------------------------------------*/
 
@@ -279,72 +1489,21 @@ const char *pcReturn = NULL;
 }
 /*-----------------------------------------------------------*/
 
-static BaseType_t prvHelpCommand( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString )
+static BaseType_t prvHelpCommand( CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs )
 {
-static const CLI_Definition_List_Item_t * pxCommand = NULL;
-BaseType_t xReturn;
-
-	( void ) pcCommandString;
-
-	if( pxCommand == NULL )
-	{
-		/* Reset the pxCommand pointer back to the start of the list. */
-		pxCommand = &xRegisteredCommands;
-	}
+UBaseType_t uxIndex;
+UBaseType_t uxCommandCount;
 
-	/* Return the next command help string, before moving the pointer on to
-	the next command in the list. */
-	strncpy( pcWriteBuffer, pxCommand->pxCommandLineDefinition->pcHelpString, xWriteBufferLen );
-	pxCommand = pxCommand->pxNext;
+	( void ) pxArgs;
 
-	if( pxCommand == NULL )
-	{
-		/* There are no more commands in the list, so there will be no more
-		strings to return after this one and pdFALSE should be returned. */
-		xReturn = pdFALSE;
-	}
-	else
+	/* Stream the help string of every command, static ones first, then the
+	registered ones in registration order. */
+	uxCommandCount = cliSTATIC_COMMAND_COUNT() + uxRegisteredCommandCount;
+	for( uxIndex = 0; uxIndex < uxCommandCount; uxIndex++ )
 	{
-		xReturn = pdTRUE;
+		FreeRTOS_CLIPut( pxSink, prvGetCommand( uxIndex )->pcHelpString );
 	}
 
-	return xReturn;
+	return pdPASS;
 }
 /*-----------------------------------------------------------*/
-
-static int8_t prvGetNumberOfParameters( const char *pcCommandString )
-{
-int8_t cParameters = 0;
-BaseType_t xLastCharacterWasSpace = pdFALSE;
-
-	/* Count the number of space delimited words in pcCommandString. */
-	while( *pcCommandString != 0x00 )
-	{
-		if( ( *pcCommandString ) == ' ' )
-		{
-			if( xLastCharacterWasSpace != pdTRUE )
-			{
-				cParameters++;
-				xLastCharacterWasSpace = pdTRUE;
-			}
-		}
-		else
-		{
-			xLastCharacterWasSpace = pdFALSE;
-		}
-
-		pcCommandString++;
-	}
-
-	/* If the command string ended with spaces, then there will have been too
-	many parameters counted. */
-	if( xLastCharacterWasSpace == pdTRUE )
-	{
-		cParameters--;
-	}
-
-	/* The value returned is one less than the number of space delimited words,
-	as the first word should be the command itself. */
-	return cParameters;
-}
-
@@ -886,6 +886,10 @@
     #define configUSE_POSIX_ERRNO    0
 #endif
 
+#ifndef configUSE_QUEUE_STATS
+    #define configUSE_QUEUE_STATS    0
+#endif
+
 #ifndef portTICK_TYPE_IS_ATOMIC
     #define portTICK_TYPE_IS_ATOMIC    0
 #endif
@@ -1228,6 +1232,26 @@ typedef struct xSTATIC_TCB
     #endif
 } StaticTask_t;
 
+#if ( configUSE_QUEUE_STATS == 1 )
+
+/*
+ * Contention statistics kept by each queue, semaphore and mutex when
+ * configUSE_QUEUE_STATS is 1.  Blocked times are in run time counter units.
+ * Read them with uxQueueGetRegistryStats().
+ */
+    typedef struct xQUEUE_STATS
+    {
+        UBaseType_t uxPeakMessagesWaiting;            /*< Highest number of items, or semaphore count. */
+        uint32_t ulSendBlocks;                        /*< Sends and gives that blocked because the queue was full. */
+        uint32_t ulReceiveBlocks;                     /*< Receives and takes that blocked because the queue was empty. */
+        uint32_t ulSendFails;                         /*< Sends that failed, from tasks and interrupts. */
+        uint32_t ulReceiveTimeouts;                   /*< Receives and takes that blocked and timed out. */
+        uint32_t ulInheritances;                      /*< Times a mutex holder inherited the priority of a blocked task. */
+        configRUN_TIME_COUNTER_TYPE ulBlockedTime;    /*< Total time tasks spent blocked. */
+        configRUN_TIME_COUNTER_TYPE ulMaxBlockedTime; /*< Longest time one call was blocked. */
+    } QueueStats_t;
+#endif
+
 /*
  * In line with software engineering best practice, especially when supplying a
  * library that is likely to change in future versions, FreeRTOS implements a
@@ -1268,6 +1292,10 @@ typedef struct xSTATIC_QUEUE
         UBaseType_t uxDummy8;
         uint8_t ucDummy9;
     #endif
+
+    #if ( configUSE_QUEUE_STATS == 1 )
+        QueueStats_t xDummy10;
+    #endif
 } StaticQueue_t;
 typedef StaticQueue_t StaticSemaphore_t;
 
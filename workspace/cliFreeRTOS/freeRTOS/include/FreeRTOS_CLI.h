@@ -33,6 +33,43 @@
 #endif
 /* *INDENT-ON* */
 
+/* Set configCOMMAND_INT_STATIC_TABLE to 1 in FreeRTOSConfig.h to build the
+command table at link time.  Command definitions declared with
+FreeRTOS_CLI_STATIC_COMMAND, in any module, are then collected by the linker
+into the .cli_commands section in flash and are available without calling
+FreeRTOS_CLIRegisterCommand().  The linker script must place that section
+between the __cli_commands_start and __cli_commands_end symbols.  Commands can
+still be registered at run time, on top of the static ones. */
+#ifndef configCOMMAND_INT_STATIC_TABLE
+	#define configCOMMAND_INT_STATIC_TABLE 0
+#endif
+
+#if( configCOMMAND_INT_STATIC_TABLE == 1 )
+	#define FreeRTOS_CLI_STATIC_COMMAND __attribute__( ( section( ".cli_commands" ), used, aligned( 4 ) ) )
+#else
+	#define FreeRTOS_CLI_STATIC_COMMAND
+#endif
+
+/* Set CLI_PERF_EN to 1 to time the phases of every command execution with the
+run time stats clock, see FreeRTOS_CLIGetCommandPerf(). */
+#ifndef CLI_PERF_EN
+	#define CLI_PERF_EN 0
+#endif
+
+/* Size in bytes of the scratch arena returned by FreeRTOS_CLIGetArena(), used
+by the session of FreeRTOS_CLIProcessCommandToSink().  Streaming commands take
+their temporary memory from the arena of their session with
+FreeRTOS_CLIArenaAlloc() instead of the heap or their stack. */
+#ifndef configCOMMAND_INT_ARENA_SIZE
+	#define configCOMMAND_INT_ARENA_SIZE 512
+#endif
+
+/* Size in bytes of the line being edited and of the previous line kept by the
+console, see CLI_IO_Buffers_t. */
+#ifndef configCOMMAND_INT_MAX_INPUT_SIZE
+	#define configCOMMAND_INT_MAX_INPUT_SIZE 300
+#endif
+
 /* The prototype to which callback functions used to process command line
 commands must comply.  pcWriteBuffer is a buffer into which the output from
 executing the command can be written, xWriteBufferLen is the length, in bytes of
@@ -40,24 +77,162 @@ the pcWriteBuffer buffer, and pcCommandString is the entire string as input by
 the user (from which parameters can be extracted).*/
 typedef BaseType_t (*pdCOMMAND_LINE_CALLBACK)( char *pcWriteBuffer, size_t xWriteBufferLen, const char *pcCommandString );
 
+/* An output sink receives the output of a command as it is produced, so the
+command does not need a buffer large enough to hold its whole output.  pxPut is
+called with each chunk of output, pxFlush is called when the output produced so
+far must reach the transport (it may be NULL), and pvContext is passed back to
+both functions untouched. */
+typedef struct xCLI_OUTPUT_SINK
+{
+	BaseType_t ( *pxPut )( void *pvContext, const char *pcData, size_t xDataLength );
+	void ( *pxFlush )( void *pvContext );
+	void *pvContext;
+} CLI_Output_Sink_t;
+
+/* Maximum number of parameters, after the command name, that are tokenised and
+passed to streaming commands. */
+#ifndef configCOMMAND_INT_MAX_PARAMETERS
+	#define configCOMMAND_INT_MAX_PARAMETERS 8
+#endif
+
+/* Types of parameter that can be declared in a command schema. */
+typedef enum
+{
+	eCLIParamString = 0,	/* Any word, no value is parsed. */
+	eCLIParamU8,			/* Decimal number from ulMin to ulMax, which must not exceed 255. */
+	eCLIParamU32,			/* Decimal number from ulMin to ulMax. */
+	eCLIParamChar,			/* A single character from ulMin to ulMax, the value is the character. */
+	eCLIParamEnum			/* One of the '|' separated words in pcChoices, not case sensitive.  The value is the position of the word, starting at 0. */
+} CLI_Param_Type_t;
+
+/* Description of one command parameter.  A command schema is an array of
+cExpectedNumberOfParameters of these.  The interpreter checks every parameter
+against the schema before the command is called, so the command only ever sees
+values that are in range. */
+typedef struct xCLI_PARAM_SCHEMA
+{
+	CLI_Param_Type_t eType;
+	uint32_t ulMin;
+	uint32_t ulMax;
+	const char *pcChoices;
+} CLI_Param_Schema_t;
+
+struct xCLI_SESSION;
+
+/* Phases of a command execution timed when CLI_PERF_EN is 1. */
+typedef enum
+{
+	eCLIPhaseLookup = 0,	/* Splitting the command line and finding the command. */
+	eCLIPhaseParse,			/* Checking and parsing the parameters. */
+	eCLIPhaseHandler,		/* The command itself, over all its calls, without the output time. */
+	eCLIPhaseOutput,		/* Writing and flushing the output to the sink. */
+	eCLIPhaseCount
+} CLI_Perf_Phase_t;
+
+#if( CLI_PERF_EN == 1 )
+	/* Times in run time counter ticks, see portGET_RUN_TIME_COUNTER_VALUE(). */
+	typedef struct xCLI_PERF_STAT
+	{
+		uint32_t ulMin;
+		uint32_t ulMax;
+		uint64_t ullSum;
+	} CLI_Perf_Stat_t;
+
+	/* Timings of one command.  Bin 0 of the histogram counts executions that
+	took less than 1us, bin n counts 2^(n-1) to 2^n - 1 us and the last bin
+	counts everything above. */
+	typedef struct xCLI_COMMAND_PERF
+	{
+		uint32_t ulCount;
+		CLI_Perf_Stat_t xPhase[ eCLIPhaseCount ];
+		CLI_Perf_Stat_t xTotal;
+		uint32_t ulBins[ CLI_PERF_BINS ];
+	} CLI_Command_Perf_t;
+#endif
+
+/* The command line after it has been split into words, done once per command.
+Parameter 0 is the first word after the command name.  Parameters are not NULL
+terminated, use FreeRTOS_CLIGetArg() or usOffset[] and usLength[]. */
+typedef struct xCLI_ARGS
+{
+	struct xCLI_SESSION *pxSession;	/* The session the command is executed in. */
+	const char *pcCommandString;	/* The entire string as input by the user. */
+	UBaseType_t uxCount;			/* Number of parameters that follow the command name. */
+	uint16_t usOffset[ configCOMMAND_INT_MAX_PARAMETERS ];	/* Start of each parameter in pcCommandString. */
+	uint16_t usLength[ configCOMMAND_INT_MAX_PARAMETERS ];	/* Length of each parameter. */
+	uint32_t ulValue[ configCOMMAND_INT_MAX_PARAMETERS ];	/* Value of each parameter, as declared in the command schema. */
+} CLI_Args_t;
+
+/* The prototype to which streaming callback functions must comply.  The
+command writes its whole output to pxSink using FreeRTOS_CLIPut(),
+FreeRTOS_CLIPrintf() and FreeRTOS_CLIFlush(), then returns pdPASS, or pdFAIL if
+the command could not be executed.  pxArgs holds the tokenised command line
+and, when the command has a schema, the parsed parameter values. */
+typedef BaseType_t (*pdCOMMAND_LINE_STREAM_CALLBACK)( CLI_Output_Sink_t *pxSink, const CLI_Args_t *pxArgs );
+
 /* The structure that defines command line commands.  A command line command
-should be defined by declaring a const structure of this type. */
+should be defined by declaring a const structure of this type.  Either
+pxCommandInterpreter or pxStreamInterpreter is set, the other one is NULL. */
 typedef struct xCOMMAND_LINE_INPUT
 {
 	const char * const pcCommand;				/* The command that causes pxCommandInterpreter to be executed.  For example "help".  Must be all lower case. */
 	const char * const pcHelpString;			/* String that describes how to use the command.  Should start with the command itself, and end with "\r\n".  For example "help: Returns a list of all the commands\r\n". */
 	const pdCOMMAND_LINE_CALLBACK pxCommandInterpreter;	/* A pointer to the callback function that will return the output generated by the command. */
 	int8_t cExpectedNumberOfParameters;			/* Commands expect a fixed number of parameters, which may be zero. */
+	const pdCOMMAND_LINE_STREAM_CALLBACK pxStreamInterpreter;	/* A pointer to the callback function that streams the output of the command to a sink. */
+	const CLI_Param_Schema_t * const pxParameterSchema;	/* cExpectedNumberOfParameters parameter descriptions, or NULL if the parameters are not checked. */
 } CLI_Command_Definition_t;
 
 /* For backward compatibility. */
 #define xCommandLineInput CLI_Command_Definition_t
 
+/* A session holds everything the interpreter needs while it executes a
+command, so commands can be executed concurrently from several tasks, each with
+its own session.  A session must only be used by one task at a time.  Create
+sessions with FreeRTOS_CLISessionInit(), the members are private. */
+typedef struct xCLI_SESSION
+{
+	CLI_Output_Sink_t *pxSink;					/* Receives the output of the commands. */
+	char *pcScratchBuffer;						/* Output buffer for commands that use the pdCOMMAND_LINE_CALLBACK prototype, may be NULL if there are none. */
+	size_t xScratchBufferLength;
+	const CLI_Command_Definition_t *pxCommand;	/* Command that has more output to generate, see FreeRTOS_CLIProcessCommand(). */
+	UBaseType_t uxCommandIndex;					/* Position of pxCommand in the command table, found by the hash lookup. */
+	CLI_Args_t xArgs;							/* The command line of the command being executed. */
+	uint8_t *pucArena;							/* Scratch memory for the command being executed, may be NULL. */
+	size_t xArenaLength;
+	size_t xArenaUsed;							/* Bytes handed out to the command being executed. */
+	BaseType_t xInteractive;					/* pdTRUE if a user at a terminal reads the sink, see FreeRTOS_CLISessionSetInteractive(). */
+	#if( CLI_PERF_EN == 1 )
+		CLI_Output_Sink_t xPerfSink;				/* Times the output and forwards it to pxPerfTarget. */
+		CLI_Output_Sink_t *pxPerfTarget;			/* Sink of the session while a command is timed. */
+		CLI_Perf_Phase_t ePerfPhase;				/* Phase being timed. */
+		configRUN_TIME_COUNTER_TYPE xPerfMark;		/* Start of the phase being timed. */
+		configRUN_TIME_COUNTER_TYPE xPerfOutput;	/* Output time during the phase being timed. */
+		configRUN_TIME_COUNTER_TYPE xPerfPhase[ eCLIPhaseCount ];
+	#endif
+} CLI_Session_t;
+
+/* The one set of I/O buffers of the command interpreter and its console, see
+FreeRTOS_CLIGetIOBuffers(). */
+typedef struct xCLI_IO_BUFFERS
+{
+	#if( configCOMMAND_INT_ARENA_SIZE > 0 )
+		uint8_t ucArena[ configCOMMAND_INT_ARENA_SIZE ];	/* First, it has the alignment of the structure. */
+	#endif
+	char cOutput[ configCOMMAND_INT_MAX_OUTPUT_SIZE ];	/* Scratch buffer of legacy commands. */
+	char cInput[ configCOMMAND_INT_MAX_INPUT_SIZE ];		/* Line being edited. */
+	char cHistory[ configCOMMAND_INT_MAX_INPUT_SIZE ];	/* Previous line. */
+} CLI_IO_Buffers_t;
+
 /*
  * Register the command passed in using the pxCommandToRegister parameter.
  * Registering a command adds the command to the list of commands that are
  * handled by the command interpreter.  Once a command has been registered it
- * can be executed from the command line.
+ * can be executed from the command line.  Registered commands are kept in a
+ * fixed table of configCOMMAND_INT_MAX_COMMANDS entries, indexed by a hash of
+ * the command name, so no heap is used and pdFAIL is returned when the table
+ * is full.  Commands declared with FreeRTOS_CLI_STATIC_COMMAND must not be
+ * registered.
  */
 BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const pxCommandToRegister );
 
@@ -74,6 +249,131 @@ BaseType_t FreeRTOS_CLIRegisterCommand( const CLI_Command_Definition_t * const p
  */
 BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char * pcWriteBuffer, size_t xWriteBufferLen  );
 
+/*
+ * Prepare pxSession to execute commands, writing their output to pxSink.
+ * pcScratchBuffer is used to run commands that use the pdCOMMAND_LINE_CALLBACK
+ * prototype, it can be NULL if the session never executes such a command.
+ */
+void FreeRTOS_CLISessionInit( CLI_Session_t *pxSession, CLI_Output_Sink_t *pxSink, char *pcScratchBuffer, size_t xScratchBufferLength );
+
+/*
+ * Give pxSession xArenaLength bytes of scratch memory at pvArena, handed out to
+ * the commands it executes by FreeRTOS_CLIArenaAlloc().  Sessions that can
+ * execute commands at the same time need their own arena.
+ */
+void FreeRTOS_CLISessionSetArena( CLI_Session_t *pxSession, void *pvArena, size_t xArenaLength );
+
+/*
+ * Mark pxSession as read by a user at a terminal, who can also send keys to
+ * the commands it executes.  Commands such as top refresh their output in
+ * place only in an interactive session, see FreeRTOS_CLIIsInteractive().
+ * Sessions are not interactive after FreeRTOS_CLISessionInit().
+ */
+void FreeRTOS_CLISessionSetInteractive( CLI_Session_t *pxSession, BaseType_t xInteractive );
+
+/*
+ * Return pdTRUE if the command described by pxArgs is executed in an
+ * interactive session.  The sink passed to the command may wrap the sink of
+ * the session, so commands must not compare sinks to find out.
+ */
+BaseType_t FreeRTOS_CLIIsInteractive( const CLI_Args_t *pxArgs );
+
+/*
+ * Runs the command interpreter for the command string "pcCommandInput" in
+ * pxSession and writes all of its output to the sink of the session.
+ * Streaming commands write directly to the sink, commands that use the
+ * pdCOMMAND_LINE_CALLBACK prototype are called until they return pdFALSE and
+ * each string they generate, in the scratch buffer of the session, is
+ * forwarded to the sink.  Returns pdPASS if the command executed successfully,
+ * otherwise pdFAIL.
+ *
+ * FreeRTOS_CLISessionExecute can be called from several tasks at the same time
+ * as long as each task uses its own session.
+ */
+BaseType_t FreeRTOS_CLISessionExecute( CLI_Session_t *pxSession, const char * const pcCommandInput );
+
+/*
+ * Same as FreeRTOS_CLISessionExecute, in a session shared by all callers that
+ * uses the buffer returned by FreeRTOS_CLIGetOutputBuffer() as scratch buffer.
+ *
+ * FreeRTOS_CLIProcessCommandToSink is not reentrant.
+ */
+BaseType_t FreeRTOS_CLIProcessCommandToSink( const char * const pcCommandInput, CLI_Output_Sink_t *pxSink );
+
+/* Outcome of FreeRTOS_CLISessionExecutePacked(). */
+typedef enum
+{
+	eCLIPackedOk = 0,			/* The command was executed and returned pdPASS. */
+	eCLIPackedFailed,			/* The command was executed and returned pdFAIL. */
+	eCLIPackedUnknownCommand,	/* No command has the requested identifier. */
+	eCLIPackedBadParameters		/* The packed parameters do not match the command. */
+} CLI_Packed_Status_t;
+
+/*
+ * Return the identifier used to execute the command named pcCommand with
+ * FreeRTOS_CLISessionExecutePacked(), which is the 32 bit FNV-1a hash of the
+ * name.  The identifier does not depend on the order or the number of the
+ * commands, so hosts can compute it from the command name.
+ */
+uint32_t FreeRTOS_CLICommandId( const char *pcCommand );
+
+/*
+ * Execute the command with identifier ulCommandId in pxSession, taking the
+ * parameters from their packed form instead of a command line.  Parameters are
+ * packed one after the other, as declared in the command schema: eCLIParamU8,
+ * eCLIParamChar and eCLIParamEnum are one byte, eCLIParamU32 is four bytes,
+ * least significant byte first, and eCLIParamString is a length byte followed
+ * by the characters.  All the parameters of commands without a schema are
+ * strings.  Values are checked against the schema as for command lines, but no
+ * message is written to the sink when they are wrong.
+ *
+ * Commands that use the pdCOMMAND_LINE_CALLBACK prototype can only be executed
+ * this way if they take no parameter.
+ */
+CLI_Packed_Status_t FreeRTOS_CLISessionExecutePacked( CLI_Session_t *pxSession, uint32_t ulCommandId, const uint8_t *pucParameters, size_t xParametersLength );
+
+/*
+ * Allocate xSize bytes from the arena of the session executing a streaming
+ * command, aligned to portBYTE_ALIGNMENT.  Allocation is a pointer increment
+ * and nothing is freed one by one: the whole arena is released when the
+ * command returns, whatever it returns, so the memory must not be kept after
+ * that.  Returns NULL when the arena is exhausted or the session has none.
+ */
+void *FreeRTOS_CLIArenaAlloc( const CLI_Args_t *pxArgs, size_t xSize );
+
+/*
+ * Copy the largest number of arena bytes used by one execution of the command
+ * with index uxIndex, in the order listed by "help", into *pxPeak and its name
+ * into *ppcCommand.  Returns pdFAIL when there is no such command.
+ */
+BaseType_t FreeRTOS_CLIGetArenaPeak( UBaseType_t uxIndex, const char **ppcCommand, size_t *pxPeak );
+
+/*
+ * Output helpers for streaming commands.  FreeRTOS_CLIPut writes a NULL
+ * terminated string, FreeRTOS_CLIWrite writes xLength bytes,
+ * FreeRTOS_CLIPrintf formats up to configCOMMAND_INT_PRINTF_BUFFER_SIZE - 1
+ * characters per call and FreeRTOS_CLIFlush pushes the output produced so far
+ * to the transport.  They return pdFAIL if the sink rejected the output.
+ * FreeRTOS_CLIPrintf also returns pdFAIL if the formatted text was longer
+ * than its buffer, in which case only the characters that fit are written.
+ */
+BaseType_t FreeRTOS_CLIWrite( CLI_Output_Sink_t *pxSink, const char *pcData, size_t xLength );
+BaseType_t FreeRTOS_CLIPut( CLI_Output_Sink_t *pxSink, const char *pcString );
+BaseType_t FreeRTOS_CLIPrintf( CLI_Output_Sink_t *pxSink, const char *pcFormat, ... );
+void FreeRTOS_CLIFlush( CLI_Output_Sink_t *pxSink );
+
+/*
+ * Copy the timings of the command with index uxIndex, in the order listed by
+ * "help", into *pxPerf and its name into *ppcCommand.  Commands are timed when
+ * executed by FreeRTOS_CLISessionExecute(), FreeRTOS_CLIProcessCommandToSink()
+ * or FreeRTOS_CLISessionExecutePacked(), only the first CLI_PERF_MAX_COMMANDS
+ * commands are timed.  Returns pdFAIL when there is no such command.
+ */
+#if( CLI_PERF_EN == 1 )
+	BaseType_t FreeRTOS_CLIGetCommandPerf( UBaseType_t uxIndex, const char **ppcCommand, CLI_Command_Perf_t *pxPerf );
+	void FreeRTOS_CLIResetCommandPerf( void );
+#endif
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -89,11 +389,33 @@ BaseType_t FreeRTOS_CLIProcessCommand( const char * const pcCommandInput, char *
  */
 char *FreeRTOS_CLIGetOutputBuffer( void );
 
+/*
+ * Like the output buffer, a scratch arena of configCOMMAND_INT_ARENA_SIZE bytes
+ * is declared in the command interpreter so consoles that never execute
+ * commands at the same time can share it.  FreeRTOS_CLIGetArena() returns its
+ * address, or NULL if configCOMMAND_INT_ARENA_SIZE is 0.
+ */
+void *FreeRTOS_CLIGetArena( void );
+
+/*
+ * The output buffer and the arena are part of CLI_IO_Buffers_t, which also
+ * holds the line buffers of the console feeding the command interpreter.
+ * FreeRTOS_CLIGetIOBuffers() returns its address.
+ */
+CLI_IO_Buffers_t *FreeRTOS_CLIGetIOBuffers( void );
+
 /*
  * Return a pointer to the xParameterNumber'th word in pcCommandString.
  */
 const char *FreeRTOS_CLIGetParameter( const char *pcCommandString, UBaseType_t uxWantedParameter, BaseType_t *pxParameterStringLength );
 
+/*
+ * Return a pointer to parameter uxParameter, counting from 0, of a tokenised
+ * command line and set *pxLength to its length.  The parameter is not NULL
+ * terminated.  Returns NULL if there is no such parameter.
+ */
+const char *FreeRTOS_CLIGetArg( const CLI_Args_t *pxArgs, UBaseType_t uxParameter, size_t *pxLength );
+
 /* *INDENT-OFF* */
 #ifdef __cplusplus
     }
@@ -1540,6 +1540,42 @@ BaseType_t xQueueGiveMutexRecursive( QueueHandle_t xMutex ) PRIVILEGED_FUNCTION;
     const char * pcQueueGetName( QueueHandle_t xQueue ) PRIVILEGED_FUNCTION; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
 #endif
 
+/*
+ * Statistics of one queue, semaphore or mutex in the queue registry, see
+ * uxQueueGetRegistryStats().
+ */
+#if ( configQUEUE_REGISTRY_SIZE > 0 ) && ( configUSE_QUEUE_STATS == 1 )
+    typedef struct xQUEUE_REGISTRY_STATS
+    {
+        const char * pcQueueName; /*lint !e971 Unqualified char types are allowed for strings and single characters only. */
+        uint8_t ucQueueType;      /*< One of the queueQUEUE_TYPE_ values. */
+        UBaseType_t uxLength;
+        UBaseType_t uxMessagesWaiting;
+        QueueStats_t xStats;
+    } QueueRegistryStats_t;
+#endif
+
+/*
+ * Copy the contention statistics of the queues, semaphores and mutexes in the
+ * queue registry.  Only available when configUSE_QUEUE_STATS is 1.
+ *
+ * @param pxStats Array that receives the statistics.
+ * @param uxMaxEntries Number of entries in pxStats.
+ * @return The number of entries written.
+ */
+#if ( configQUEUE_REGISTRY_SIZE > 0 ) && ( configUSE_QUEUE_STATS == 1 )
+    UBaseType_t uxQueueGetRegistryStats( QueueRegistryStats_t * const pxStats,
+                                         const UBaseType_t uxMaxEntries ) PRIVILEGED_FUNCTION;
+#endif
+
+/*
+ * Clear the contention statistics of the queues, semaphores and mutexes in the
+ * queue registry.  The peak number of items restarts from the current one.
+ */
+#if ( configQUEUE_REGISTRY_SIZE > 0 ) && ( configUSE_QUEUE_STATS == 1 )
+    void vQueueResetRegistryStats( void ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Generic version of the function used to create a queue using dynamic memory
  * allocation.  This is called by other functions and macros that create other
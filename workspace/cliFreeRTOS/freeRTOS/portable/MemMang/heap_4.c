@@ -46,6 +46,15 @@
 
 #undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
 
+/* heap_tlsf.c provides the heap instead when HEAP_TLSF_EN is 1, and there is
+ * no heap when STATIC_ALLOCATION_EN is 1. */
+#if ( HEAP_TLSF_EN == 0 ) && ( STATIC_ALLOCATION_EN == 0 )
+
+#if ( HEAP_PROFILER_EN == 1 )
+    #include "stm32f4xx.h"
+    #include "heapProfiler.h"
+#endif
+
 #if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
     #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
 #endif
@@ -74,6 +83,32 @@ typedef struct A_BLOCK_LINK
     size_t xBlockSize;                     /*<< The size of the free block. */
 } BlockLink_t;
 
+#if ( HEAP_PROFILER_EN == 1 )
+
+/* The call site of an allocated block is kept in bits of xBlockSize that a
+ * heap smaller than 16 MB never uses, so the block header does not grow. */
+    #define heapSITE_SHIFT    ( 24U )
+    #define heapSITE_MASK     ( ( size_t ) 0x7F << heapSITE_SHIFT )
+
+    #if ( HEAP_PROFILER_SITES >= 0x7F )
+        #error The heap profiler keeps less than 127 call sites
+    #endif
+
+    PRIVILEGED_DATA static HeapProfile_t xHeapProfile;
+
+/*
+ * Find the call site of a caller, a new site is taken while there are free
+ * ones.  Returns the index of the site.
+ */
+    static size_t prvHeapSiteIndex( void * pvCaller ) PRIVILEGED_FUNCTION;
+
+/*
+ * Add the cycles since uStart to the time of an allocator function.
+ */
+    static void prvHeapTimingAdd( HeapTiming_t * pxTiming,
+                                  uint32_t uStart ) PRIVILEGED_FUNCTION;
+#endif /* HEAP_PROFILER_EN */
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -119,6 +154,12 @@ void * pvPortMalloc( size_t xWantedSize )
     BlockLink_t * pxBlock, * pxPreviousBlock, * pxNewBlockLink;
     void * pvReturn = NULL;
 
+    #if ( HEAP_PROFILER_EN == 1 )
+        uint32_t uStart = DWT->CYCCNT;
+        size_t xRequestedSize = xWantedSize;
+        size_t xSite;
+    #endif
+
     vTaskSuspendAll();
     {
         /* If this is the first call to malloc then the heap will require
@@ -232,6 +273,22 @@ void * pvPortMalloc( size_t xWantedSize )
 
                     /* The block is being returned - it is allocated and owned
                      * by the application and has no "next" block. */
+                    #if ( HEAP_PROFILER_EN == 1 )
+                        {
+                            xSite = prvHeapSiteIndex( __builtin_return_address( 0 ) );
+                            xHeapProfile.xSites[ xSite ].uAllocs++;
+                            xHeapProfile.xSites[ xSite ].uLiveBytes += pxBlock->xBlockSize;
+
+                            if( xRequestedSize > xHeapProfile.xSites[ xSite ].uMaxRequest )
+                            {
+                                xHeapProfile.xSites[ xSite ].uMaxRequest = xRequestedSize;
+                            }
+
+                            xHeapProfile.uLiveBlocks++;
+                            pxBlock->xBlockSize |= xSite << heapSITE_SHIFT;
+                        }
+                    #endif
+
                     pxBlock->xBlockSize |= xBlockAllocatedBit;
                     pxBlock->pxNextFreeBlock = NULL;
                     xNumberOfSuccessfulAllocations++;
@@ -252,6 +309,19 @@ void * pvPortMalloc( size_t xWantedSize )
         }
 
         traceMALLOC( pvReturn, xWantedSize );
+
+        /* The time taken to resume the scheduler is not counted, a task
+         * switch there would add the run time of other tasks. */
+        #if ( HEAP_PROFILER_EN == 1 )
+            {
+                if( pvReturn == NULL )
+                {
+                    xHeapProfile.uFailedAllocs++;
+                }
+
+                prvHeapTimingAdd( &xHeapProfile.xMalloc, uStart );
+            }
+        #endif
     }
     ( void ) xTaskResumeAll();
 
@@ -279,6 +349,11 @@ void vPortFree( void * pv )
     uint8_t * puc = ( uint8_t * ) pv;
     BlockLink_t * pxLink;
 
+    #if ( HEAP_PROFILER_EN == 1 )
+        uint32_t uStart = DWT->CYCCNT;
+        size_t xSite;
+    #endif
+
     if( pv != NULL )
     {
         /* The memory being freed will have an BlockLink_t structure immediately
@@ -300,13 +375,35 @@ void vPortFree( void * pv )
                  * allocated. */
                 pxLink->xBlockSize &= ~xBlockAllocatedBit;
 
+                #if ( HEAP_PROFILER_EN == 1 )
+                    {
+                        xSite = ( pxLink->xBlockSize & heapSITE_MASK ) >> heapSITE_SHIFT;
+                        pxLink->xBlockSize &= ~heapSITE_MASK;
+                    }
+                #endif
+
                 vTaskSuspendAll();
                 {
                     /* Add this block to the list of free blocks. */
                     xFreeBytesRemaining += pxLink->xBlockSize;
                     traceFREE( pv, pxLink->xBlockSize );
+
+                    #if ( HEAP_PROFILER_EN == 1 )
+                        {
+                            xHeapProfile.xSites[ xSite ].uFrees++;
+                            xHeapProfile.xSites[ xSite ].uLiveBytes -= pxLink->xBlockSize;
+                            xHeapProfile.uLiveBlocks--;
+                        }
+                    #endif
+
                     prvInsertBlockIntoFreeList( ( ( BlockLink_t * ) pxLink ) );
                     xNumberOfSuccessfulFrees++;
+
+                    #if ( HEAP_PROFILER_EN == 1 )
+                        {
+                            prvHeapTimingAdd( &xHeapProfile.xFree, uStart );
+                        }
+                    #endif
                 }
                 ( void ) xTaskResumeAll();
             }
@@ -348,6 +445,11 @@ static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
     size_t uxAddress;
     size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
 
+    #if ( HEAP_PROFILER_EN == 1 )
+        /* Block sizes must leave the call site bits free. */
+        configASSERT( xTotalHeapSize < ( ( size_t ) 1 << heapSITE_SHIFT ) );
+    #endif
+
     /* Ensure the heap starts on a correctly aligned boundary. */
     uxAddress = ( size_t ) ucHeap;
 
@@ -502,3 +604,89 @@ void vPortGetHeapStats( HeapStats_t * pxHeapStats )
     }
     taskEXIT_CRITICAL();
 }
+/*-----------------------------------------------------------*/
+
+#if ( HEAP_PROFILER_EN == 1 )
+
+    static size_t prvHeapSiteIndex( void * pvCaller ) /* PRIVILEGED_FUNCTION */
+    {
+        size_t xSite;
+
+        for( xSite = 0; xSite < HEAP_PROFILER_SITES; xSite++ )
+        {
+            if( xHeapProfile.xSites[ xSite ].pvCaller == pvCaller )
+            {
+                break;
+            }
+            else if( xHeapProfile.xSites[ xSite ].pvCaller == NULL )
+            {
+                xHeapProfile.xSites[ xSite ].pvCaller = pvCaller;
+                break;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        /* When the table is full the last entry collects the other sites. */
+        return xSite;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvHeapTimingAdd( HeapTiming_t * pxTiming,
+                                  uint32_t uStart ) /* PRIVILEGED_FUNCTION */
+    {
+        uint32_t uCycles = DWT->CYCCNT - uStart;
+
+        pxTiming->uCalls++;
+        pxTiming->uSum += uCycles;
+
+        if( uCycles > pxTiming->uMax )
+        {
+            pxTiming->uMax = uCycles;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    void vPortGetHeapProfile( HeapProfile_t * pxProfile )
+    {
+        BlockLink_t * pxBlock;
+        uint32_t uBin;
+
+        vTaskSuspendAll();
+        {
+            *pxProfile = xHeapProfile;
+            pxProfile->uFreeBytes = xFreeBytesRemaining;
+            pxBlock = xStart.pxNextFreeBlock;
+
+            /* pxBlock will be NULL if the heap has not been initialised. */
+            while( ( pxBlock != NULL ) && ( pxBlock != pxEnd ) )
+            {
+                pxProfile->uFreeBlocks++;
+
+                if( pxBlock->xBlockSize > pxProfile->uLargestFree )
+                {
+                    pxProfile->uLargestFree = pxBlock->xBlockSize;
+                }
+
+                /* Bin 0 holds the blocks below 32 bytes, each next bin
+                 * doubles the size. */
+                uBin = ( 32U - ( uint32_t ) __CLZ( pxBlock->xBlockSize ) );
+                uBin = ( uBin > 5U ) ? ( uBin - 5U ) : 0U;
+
+                if( uBin >= HEAP_PROFILER_BINS )
+                {
+                    uBin = HEAP_PROFILER_BINS - 1;
+                }
+
+                pxProfile->uFreeBins[ uBin ]++;
+                pxBlock = pxBlock->pxNextFreeBlock;
+            }
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+#endif /* HEAP_PROFILER_EN */
+
+#endif /* HEAP_TLSF_EN, STATIC_ALLOCATION_EN */
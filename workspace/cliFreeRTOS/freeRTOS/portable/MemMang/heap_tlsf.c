@@ -0,0 +1,828 @@
+/*
+ * FreeRTOS Kernel V10.4.6
+ * Copyright (C) 2021 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * https://www.FreeRTOS.org
+ * https://github.com/FreeRTOS
+ *
+ */
+
+/*
+ * An implementation of pvPortMalloc() and vPortFree() with the same contract
+ * as heap_4.c, based on a Two Level Segregated Fit allocator, so the time taken
+ * by both functions does not depend on the number of free blocks.
+ *
+ * Free blocks are kept in lists of blocks of similar size.  The first level
+ * splits sizes by powers of two, the second level splits each power of two
+ * into tlsfSL_COUNT ranges of equal width, and two bitmaps record which lists
+ * are not empty.  A free block of the wanted size is found with two bit scans,
+ * and adjacent free blocks are merged as they are freed, using a pointer to
+ * the previous block in memory kept in the header of each block.
+ *
+ * Selected instead of heap_4.c by setting HEAP_TLSF_EN to 1.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+ * all the API functions to use the MPU wrappers.  That should only be done when
+ * task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* There is no heap when STATIC_ALLOCATION_EN is 1. */
+#if ( HEAP_TLSF_EN == 1 ) && ( STATIC_ALLOCATION_EN == 0 )
+
+#if ( HEAP_PROFILER_EN == 1 )
+    #include "stm32f4xx.h"
+    #include "heapProfiler.h"
+#endif
+
+#if ( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+    #error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Number of second level lists per power of two, as a power of two. */
+#define tlsfSL_COUNT_LOG2    ( 4U )
+#define tlsfSL_COUNT         ( 1U << tlsfSL_COUNT_LOG2 )
+
+#if ( portBYTE_ALIGNMENT == 8 )
+    #define tlsfALIGNMENT_LOG2    ( 3U )
+#elif ( portBYTE_ALIGNMENT == 4 )
+    #define tlsfALIGNMENT_LOG2    ( 2U )
+#else
+    #error heap_tlsf.c supports a portBYTE_ALIGNMENT of 4 or 8
+#endif
+
+/* Blocks below tlsfSMALL_BLOCK_SIZE are all in first level list 0, split into
+ * second level lists one alignment unit wide. */
+#define tlsfFL_SHIFT            ( tlsfSL_COUNT_LOG2 + tlsfALIGNMENT_LOG2 )
+#define tlsfSMALL_BLOCK_SIZE    ( ( size_t ) 1 << tlsfFL_SHIFT )
+
+/* Blocks are smaller than 2^tlsfFL_INDEX_MAX bytes, only the first level lists
+ * that the heap can fill are allocated. */
+#define tlsfFL_INDEX_MAX                                   \
+    ( ( configTOTAL_HEAP_SIZE <= ( 1UL << 16 ) ) ? 16U :   \
+      ( configTOTAL_HEAP_SIZE <= ( 1UL << 20 ) ) ? 20U :   \
+      ( configTOTAL_HEAP_SIZE <= ( 1UL << 24 ) ) ? 24U : 31U )
+#define tlsfFL_COUNT    ( tlsfFL_INDEX_MAX - tlsfFL_SHIFT + 1U )
+
+/* Set in xBlockSize while the block is free.  Sizes are multiples of
+ * portBYTE_ALIGNMENT, so the low bits are available. */
+#define tlsfBLOCK_FREE    ( ( size_t ) 1 )
+
+/* Assumes 8bit bytes! */
+#define heapBITS_PER_BYTE    ( ( size_t ) 8 )
+
+#if ( HEAP_PROFILER_EN == 1 )
+
+/* The call site of an allocated block is kept in bits of xBlockSize that a
+ * heap smaller than 16 MB never uses, so the block header does not grow. */
+    #define heapSITE_SHIFT    ( 24U )
+    #define heapSITE_MASK     ( ( size_t ) 0x7F << heapSITE_SHIFT )
+
+    #if ( HEAP_PROFILER_SITES >= 0x7F )
+        #error The heap profiler keeps less than 127 call sites
+    #endif
+#else
+    #define heapSITE_MASK    ( ( size_t ) 0 )
+#endif
+
+/* Size of a block, without the flags and the call site. */
+#define tlsfBLOCK_SIZE( pxBlock )    ( ( pxBlock )->xBlockSize & ~( ( size_t ) portBYTE_ALIGNMENT_MASK | heapSITE_MASK ) )
+
+/* Allocate the memory for the heap. */
+#if ( configAPPLICATION_ALLOCATED_HEAP == 1 )
+
+/* The application writer has already defined the array used for the RTOS
+* heap - probably so it can be placed in a special segment or address. */
+    extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+    PRIVILEGED_DATA static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* Header at the start of every block, free or allocated.  The blocks cover the
+ * heap without gaps, so the next block in memory starts xBlockSize bytes after
+ * this one. */
+typedef struct TLSF_BLOCK_LINK
+{
+    struct TLSF_BLOCK_LINK * pxPrevPhysBlock; /*<< The block just below this one in memory, NULL for the first block. */
+    size_t xBlockSize;                        /*<< The size of the block, header included, and tlsfBLOCK_FREE. */
+} TlsfBlockLink_t;
+
+/* A free block also links the other free blocks of its list, in the space that
+ * is handed to the application once the block is allocated. */
+typedef struct TLSF_FREE_BLOCK
+{
+    TlsfBlockLink_t xHeader;
+    struct TLSF_FREE_BLOCK * pxNextFree;
+    struct TLSF_FREE_BLOCK * pxPrevFree;
+} TlsfFreeBlock_t;
+
+#if ( HEAP_PROFILER_EN == 1 )
+    PRIVILEGED_DATA static HeapProfile_t xHeapProfile;
+
+/*
+ * Find the call site of a caller, a new site is taken while there are free
+ * ones.  Returns the index of the site.
+ */
+    static size_t prvHeapSiteIndex( void * pvCaller ) PRIVILEGED_FUNCTION;
+
+/*
+ * Add the cycles since uStart to the time of an allocator function.
+ */
+    static void prvHeapTimingAdd( HeapTiming_t * pxTiming,
+                                  uint32_t uStart ) PRIVILEGED_FUNCTION;
+#endif /* HEAP_PROFILER_EN */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Compute the lists that hold blocks of xSize bytes.
+ */
+static void prvMappingInsert( size_t xSize,
+                              UBaseType_t * puxFl,
+                              UBaseType_t * puxSl ) PRIVILEGED_FUNCTION;
+
+/*
+ * Find a free block of at least xSize bytes and take it out of its list.
+ * Returns NULL if there is none.
+ */
+static TlsfFreeBlock_t * prvTakeSuitableBlock( size_t xSize ) PRIVILEGED_FUNCTION;
+
+/*
+ * Add a free block to, or remove it from, the list that holds its size.
+ */
+static void prvInsertFreeBlock( TlsfFreeBlock_t * pxBlock ) PRIVILEGED_FUNCTION;
+static void prvRemoveFreeBlock( TlsfFreeBlock_t * pxBlock ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called automatically to setup the required heap structures the first time
+ * pvPortMalloc() is called.
+ */
+static void prvHeapInit( void ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+/* The size of the structure placed at the beginning of each allocated memory
+ * block must by correctly byte aligned. */
+static const size_t xHeapStructSize = ( sizeof( TlsfBlockLink_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* Blocks must hold the free list links once they are freed. */
+static const size_t xMinimumBlockSize = ( sizeof( TlsfFreeBlock_t ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* Bit n of ulFlBitmap is set when a list of first level n is not empty, bit m
+ * of ulSlBitmap[ n ] when the list of second level m is not empty. */
+PRIVILEGED_DATA static uint32_t ulFlBitmap = 0U;
+PRIVILEGED_DATA static uint32_t ulSlBitmap[ tlsfFL_COUNT ];
+PRIVILEGED_DATA static TlsfFreeBlock_t * pxFreeLists[ tlsfFL_COUNT ][ tlsfSL_COUNT ];
+
+/* Zero sized allocated block at the end of the heap, it stops the merge of the
+ * last block. */
+PRIVILEGED_DATA static TlsfBlockLink_t * pxEnd = NULL;
+
+/* Keeps track of the number of calls to allocate and free memory as well as the
+ * number of free bytes remaining, but says nothing about fragmentation. */
+PRIVILEGED_DATA static size_t xFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xMinimumEverFreeBytesRemaining = 0U;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulAllocations = 0;
+PRIVILEGED_DATA static size_t xNumberOfSuccessfulFrees = 0;
+
+/* Gets set to the top bit of an size_t type.  Requested sizes with this bit
+ * set are rejected, as in heap_4.c. */
+PRIVILEGED_DATA static size_t xBlockAllocatedBit = 0;
+
+/*-----------------------------------------------------------*/
+
+void * pvPortMalloc( size_t xWantedSize )
+{
+    TlsfFreeBlock_t * pxBlock;
+    TlsfFreeBlock_t * pxNewBlock;
+    TlsfBlockLink_t * pxNextBlock;
+    size_t xBlockSize;
+    void * pvReturn = NULL;
+
+    #if ( HEAP_PROFILER_EN == 1 )
+        uint32_t uStart = DWT->CYCCNT;
+        size_t xRequestedSize = xWantedSize;
+        size_t xSite;
+    #endif
+
+    vTaskSuspendAll();
+    {
+        /* If this is the first call to malloc then the heap will require
+         * initialisation to setup the lists of free blocks. */
+        if( pxEnd == NULL )
+        {
+            prvHeapInit();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        if( ( xWantedSize & xBlockAllocatedBit ) == 0 )
+        {
+            /* The wanted size must be increased so it can contain a
+             * TlsfBlockLink_t structure in addition to the requested amount of
+             * bytes, and rounded up so the next block stays aligned. */
+            if( ( xWantedSize > 0 ) &&
+                ( ( xWantedSize + xHeapStructSize + portBYTE_ALIGNMENT_MASK ) > xWantedSize ) ) /* Overflow check */
+            {
+                xWantedSize = ( xWantedSize + xHeapStructSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+                if( xWantedSize < xMinimumBlockSize )
+                {
+                    xWantedSize = xMinimumBlockSize;
+                }
+            }
+            else
+            {
+                xWantedSize = 0;
+            }
+
+            if( ( xWantedSize > 0 ) && ( xWantedSize <= xFreeBytesRemaining ) )
+            {
+                pxBlock = prvTakeSuitableBlock( xWantedSize );
+
+                if( pxBlock != NULL )
+                {
+                    xBlockSize = tlsfBLOCK_SIZE( &( pxBlock->xHeader ) );
+
+                    /* If the block is larger than required it can be split into
+                     * two, the second part goes back to the free lists. */
+                    if( ( xBlockSize - xWantedSize ) >= xMinimumBlockSize )
+                    {
+                        pxNewBlock = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+                        configASSERT( ( ( ( size_t ) pxNewBlock ) & portBYTE_ALIGNMENT_MASK ) == 0 );
+
+                        pxNewBlock->xHeader.pxPrevPhysBlock = &( pxBlock->xHeader );
+                        pxNewBlock->xHeader.xBlockSize = xBlockSize - xWantedSize;
+                        pxNextBlock = ( void * ) ( ( ( uint8_t * ) pxNewBlock ) + pxNewBlock->xHeader.xBlockSize );
+                        pxNextBlock->pxPrevPhysBlock = &( pxNewBlock->xHeader );
+                        prvInsertFreeBlock( pxNewBlock );
+
+                        xBlockSize = xWantedSize;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    /* The block is being returned - it is allocated and owned
+                     * by the application. */
+                    pxBlock->xHeader.xBlockSize = xBlockSize;
+                    xFreeBytesRemaining -= xBlockSize;
+
+                    if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+                    {
+                        xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+                    }
+                    else
+                    {
+                        mtCOVERAGE_TEST_MARKER();
+                    }
+
+                    #if ( HEAP_PROFILER_EN == 1 )
+                        {
+                            xSite = prvHeapSiteIndex( __builtin_return_address( 0 ) );
+                            xHeapProfile.xSites[ xSite ].uAllocs++;
+                            xHeapProfile.xSites[ xSite ].uLiveBytes += xBlockSize;
+
+                            if( xRequestedSize > xHeapProfile.xSites[ xSite ].uMaxRequest )
+                            {
+                                xHeapProfile.xSites[ xSite ].uMaxRequest = xRequestedSize;
+                            }
+
+                            xHeapProfile.uLiveBlocks++;
+                            pxBlock->xHeader.xBlockSize |= xSite << heapSITE_SHIFT;
+                        }
+                    #endif
+
+                    /* Return the memory space pointed to - jumping over the
+                     * TlsfBlockLink_t structure at its start. */
+                    pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+                    xNumberOfSuccessfulAllocations++;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+
+        traceMALLOC( pvReturn, xWantedSize );
+
+        /* The time taken to resume the scheduler is not counted, a task
+         * switch there would add the run time of other tasks. */
+        #if ( HEAP_PROFILER_EN == 1 )
+            {
+                if( pvReturn == NULL )
+                {
+                    xHeapProfile.uFailedAllocs++;
+                }
+
+                prvHeapTimingAdd( &xHeapProfile.xMalloc, uStart );
+            }
+        #endif
+    }
+    ( void ) xTaskResumeAll();
+
+    #if ( configUSE_MALLOC_FAILED_HOOK == 1 )
+        {
+            if( pvReturn == NULL )
+            {
+                extern void vApplicationMallocFailedHook( void );
+                vApplicationMallocFailedHook();
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+    #endif /* if ( configUSE_MALLOC_FAILED_HOOK == 1 ) */
+
+    configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void * pv )
+{
+    TlsfFreeBlock_t * pxBlock;
+    TlsfBlockLink_t * pxNeighbour;
+    size_t xBlockSize;
+
+    #if ( HEAP_PROFILER_EN == 1 )
+        uint32_t uStart = DWT->CYCCNT;
+        size_t xSite;
+    #endif
+
+    if( pv != NULL )
+    {
+        /* The memory being freed will have a TlsfBlockLink_t structure
+         * immediately before it. */
+        pxBlock = ( void * ) ( ( ( uint8_t * ) pv ) - xHeapStructSize );
+
+        /* Check the block is actually allocated. */
+        configASSERT( ( pxBlock->xHeader.xBlockSize & tlsfBLOCK_FREE ) == 0 );
+
+        if( ( pxBlock->xHeader.xBlockSize & tlsfBLOCK_FREE ) == 0 )
+        {
+            #if ( HEAP_PROFILER_EN == 1 )
+                {
+                    xSite = ( pxBlock->xHeader.xBlockSize & heapSITE_MASK ) >> heapSITE_SHIFT;
+                }
+            #endif
+
+            xBlockSize = tlsfBLOCK_SIZE( &( pxBlock->xHeader ) );
+
+            vTaskSuspendAll();
+            {
+                xFreeBytesRemaining += xBlockSize;
+                traceFREE( pv, xBlockSize );
+
+                #if ( HEAP_PROFILER_EN == 1 )
+                    {
+                        xHeapProfile.xSites[ xSite ].uFrees++;
+                        xHeapProfile.xSites[ xSite ].uLiveBytes -= xBlockSize;
+                        xHeapProfile.uLiveBlocks--;
+                    }
+                #endif
+
+                /* Merge with the block above it in memory if that one is free.
+                 * The block at the end of the heap is never free. */
+                pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+
+                if( ( pxNeighbour->xBlockSize & tlsfBLOCK_FREE ) != 0 )
+                {
+                    prvRemoveFreeBlock( ( TlsfFreeBlock_t * ) pxNeighbour );
+                    xBlockSize += tlsfBLOCK_SIZE( pxNeighbour );
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                /* Merge with the block below it in memory if that one is free. */
+                pxNeighbour = pxBlock->xHeader.pxPrevPhysBlock;
+
+                if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & tlsfBLOCK_FREE ) != 0 ) )
+                {
+                    prvRemoveFreeBlock( ( TlsfFreeBlock_t * ) pxNeighbour );
+                    xBlockSize += tlsfBLOCK_SIZE( pxNeighbour );
+                    pxBlock = ( TlsfFreeBlock_t * ) pxNeighbour;
+                }
+                else
+                {
+                    mtCOVERAGE_TEST_MARKER();
+                }
+
+                pxBlock->xHeader.xBlockSize = xBlockSize;
+                pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+                pxNeighbour->pxPrevPhysBlock = &( pxBlock->xHeader );
+                prvInsertFreeBlock( pxBlock );
+                xNumberOfSuccessfulFrees++;
+
+                #if ( HEAP_PROFILER_EN == 1 )
+                    {
+                        prvHeapTimingAdd( &xHeapProfile.xFree, uStart );
+                    }
+                #endif
+            }
+            ( void ) xTaskResumeAll();
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void ) /* PRIVILEGED_FUNCTION */
+{
+    TlsfFreeBlock_t * pxFirstFreeBlock;
+    size_t uxAddress;
+    size_t xTotalHeapSize = configTOTAL_HEAP_SIZE;
+
+    #if ( HEAP_PROFILER_EN == 1 )
+        /* Block sizes must leave the call site bits free. */
+        configASSERT( xTotalHeapSize < ( ( size_t ) 1 << heapSITE_SHIFT ) );
+    #endif
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    uxAddress = ( size_t ) ucHeap;
+
+    if( ( uxAddress & portBYTE_ALIGNMENT_MASK ) != 0 )
+    {
+        uxAddress += ( portBYTE_ALIGNMENT - 1 );
+        uxAddress &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+        xTotalHeapSize -= uxAddress - ( size_t ) ucHeap;
+    }
+
+    pxFirstFreeBlock = ( void * ) uxAddress;
+
+    /* pxEnd marks the end of the heap, it is inserted at the end of the heap
+     * space and looks like an allocated block, so it is never merged. */
+    uxAddress += xTotalHeapSize;
+    uxAddress -= xHeapStructSize;
+    uxAddress &= ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+    pxEnd = ( void * ) uxAddress;
+    pxEnd->xBlockSize = 0;
+    pxEnd->pxPrevPhysBlock = &( pxFirstFreeBlock->xHeader );
+
+    /* To start with there is a single free block that is sized to take up the
+     * entire heap space, minus the space taken by pxEnd. */
+    pxFirstFreeBlock->xHeader.pxPrevPhysBlock = NULL;
+    pxFirstFreeBlock->xHeader.xBlockSize = uxAddress - ( size_t ) pxFirstFreeBlock;
+
+    /* Only one block exists - and it covers the entire usable heap space. */
+    xMinimumEverFreeBytesRemaining = pxFirstFreeBlock->xHeader.xBlockSize;
+    xFreeBytesRemaining = pxFirstFreeBlock->xHeader.xBlockSize;
+
+    prvInsertFreeBlock( pxFirstFreeBlock );
+
+    /* Work out the position of the top bit in a size_t variable. */
+    xBlockAllocatedBit = ( ( size_t ) 1 ) << ( ( sizeof( size_t ) * heapBITS_PER_BYTE ) - 1 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvMappingInsert( size_t xSize,
+                              UBaseType_t * puxFl,
+                              UBaseType_t * puxSl ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxFl;
+
+    if( xSize < tlsfSMALL_BLOCK_SIZE )
+    {
+        /* Small blocks are in first level 0, one list per alignment unit. */
+        *puxFl = 0;
+        *puxSl = ( UBaseType_t ) ( xSize >> tlsfALIGNMENT_LOG2 );
+    }
+    else
+    {
+        /* uxFl is the position of the top bit of the size, the second level
+         * is given by the tlsfSL_COUNT_LOG2 bits below it. */
+        uxFl = ( UBaseType_t ) ( 31U - ( uint32_t ) __builtin_clz( ( uint32_t ) xSize ) );
+        *puxSl = ( UBaseType_t ) ( ( xSize >> ( uxFl - tlsfSL_COUNT_LOG2 ) ) ^ tlsfSL_COUNT );
+        *puxFl = uxFl - ( tlsfFL_SHIFT - 1U );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static TlsfFreeBlock_t * prvTakeSuitableBlock( size_t xSize ) /* PRIVILEGED_FUNCTION */
+{
+    TlsfFreeBlock_t * pxBlock = NULL;
+    UBaseType_t uxFl;
+    UBaseType_t uxSl;
+    uint32_t ulMap;
+    size_t xRoundedSize = xSize;
+
+    /* Round the size up to the start of the next list, so that every block of
+     * the list found is large enough and the first one can be taken. */
+    if( xSize >= tlsfSMALL_BLOCK_SIZE )
+    {
+        xRoundedSize += ( ( size_t ) 1 << ( 31U - ( uint32_t ) __builtin_clz( ( uint32_t ) xSize ) - tlsfSL_COUNT_LOG2 ) ) - 1U;
+    }
+
+    prvMappingInsert( xRoundedSize, &uxFl, &uxSl );
+
+    if( uxFl < tlsfFL_COUNT )
+    {
+        /* A list of the same first level with larger blocks, or else the first
+         * list of the next first level that is not empty. */
+        ulMap = ulSlBitmap[ uxFl ] & ( ~0UL << uxSl );
+
+        if( ulMap == 0U )
+        {
+            ulMap = ( uxFl + 1U < 32U ) ? ( ulFlBitmap & ( ~0UL << ( uxFl + 1U ) ) ) : 0U;
+
+            if( ulMap != 0U )
+            {
+                uxFl = ( UBaseType_t ) __builtin_ctz( ulMap );
+                ulMap = ulSlBitmap[ uxFl ];
+            }
+        }
+
+        if( ulMap != 0U )
+        {
+            uxSl = ( UBaseType_t ) __builtin_ctz( ulMap );
+            pxBlock = pxFreeLists[ uxFl ][ uxSl ];
+        }
+    }
+
+    if( pxBlock == NULL )
+    {
+        /* Rounding up skipped the list that holds xSize, its first block may
+         * still be large enough, as when the largest free block is asked for. */
+        prvMappingInsert( xSize, &uxFl, &uxSl );
+
+        if( ( uxFl < tlsfFL_COUNT ) &&
+            ( pxFreeLists[ uxFl ][ uxSl ] != NULL ) &&
+            ( tlsfBLOCK_SIZE( &( pxFreeLists[ uxFl ][ uxSl ]->xHeader ) ) >= xSize ) )
+        {
+            pxBlock = pxFreeLists[ uxFl ][ uxSl ];
+        }
+    }
+
+    if( pxBlock != NULL )
+    {
+        prvRemoveFreeBlock( pxBlock );
+    }
+
+    return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( TlsfFreeBlock_t * pxBlock ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxFl;
+    UBaseType_t uxSl;
+
+    prvMappingInsert( pxBlock->xHeader.xBlockSize, &uxFl, &uxSl );
+
+    pxBlock->xHeader.xBlockSize |= tlsfBLOCK_FREE;
+    pxBlock->pxPrevFree = NULL;
+    pxBlock->pxNextFree = pxFreeLists[ uxFl ][ uxSl ];
+
+    if( pxBlock->pxNextFree != NULL )
+    {
+        pxBlock->pxNextFree->pxPrevFree = pxBlock;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    pxFreeLists[ uxFl ][ uxSl ] = pxBlock;
+    ulFlBitmap |= 1UL << uxFl;
+    ulSlBitmap[ uxFl ] |= 1UL << uxSl;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( TlsfFreeBlock_t * pxBlock ) /* PRIVILEGED_FUNCTION */
+{
+    UBaseType_t uxFl;
+    UBaseType_t uxSl;
+
+    pxBlock->xHeader.xBlockSize &= ~tlsfBLOCK_FREE;
+    prvMappingInsert( pxBlock->xHeader.xBlockSize, &uxFl, &uxSl );
+
+    if( pxBlock->pxNextFree != NULL )
+    {
+        pxBlock->pxNextFree->pxPrevFree = pxBlock->pxPrevFree;
+    }
+    else
+    {
+        mtCOVERAGE_TEST_MARKER();
+    }
+
+    if( pxBlock->pxPrevFree != NULL )
+    {
+        pxBlock->pxPrevFree->pxNextFree = pxBlock->pxNextFree;
+    }
+    else
+    {
+        /* The block was the head of its list. */
+        pxFreeLists[ uxFl ][ uxSl ] = pxBlock->pxNextFree;
+
+        if( pxBlock->pxNextFree == NULL )
+        {
+            ulSlBitmap[ uxFl ] &= ~( 1UL << uxSl );
+
+            if( ulSlBitmap[ uxFl ] == 0U )
+            {
+                ulFlBitmap &= ~( 1UL << uxFl );
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t * pxHeapStats )
+{
+    TlsfFreeBlock_t * pxBlock;
+    size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+    UBaseType_t uxFl;
+    UBaseType_t uxSl;
+
+    vTaskSuspendAll();
+    {
+        /* Unlike the allocation, the statistics walk every free block. */
+        for( uxFl = 0; uxFl < tlsfFL_COUNT; uxFl++ )
+        {
+            for( uxSl = 0; uxSl < tlsfSL_COUNT; uxSl++ )
+            {
+                for( pxBlock = pxFreeLists[ uxFl ][ uxSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+                {
+                    xBlocks++;
+
+                    if( tlsfBLOCK_SIZE( &( pxBlock->xHeader ) ) > xMaxSize )
+                    {
+                        xMaxSize = tlsfBLOCK_SIZE( &( pxBlock->xHeader ) );
+                    }
+
+                    if( tlsfBLOCK_SIZE( &( pxBlock->xHeader ) ) < xMinSize )
+                    {
+                        xMinSize = tlsfBLOCK_SIZE( &( pxBlock->xHeader ) );
+                    }
+                }
+            }
+        }
+    }
+    ( void ) xTaskResumeAll();
+
+    pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+    pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+    pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+    taskENTER_CRITICAL();
+    {
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+    }
+    taskEXIT_CRITICAL();
+}
+/*-----------------------------------------------------------*/
+
+#if ( HEAP_PROFILER_EN == 1 )
+
+    static size_t prvHeapSiteIndex( void * pvCaller ) /* PRIVILEGED_FUNCTION */
+    {
+        size_t xSite;
+
+        for( xSite = 0; xSite < HEAP_PROFILER_SITES; xSite++ )
+        {
+            if( xHeapProfile.xSites[ xSite ].pvCaller == pvCaller )
+            {
+                break;
+            }
+            else if( xHeapProfile.xSites[ xSite ].pvCaller == NULL )
+            {
+                xHeapProfile.xSites[ xSite ].pvCaller = pvCaller;
+                break;
+            }
+            else
+            {
+                mtCOVERAGE_TEST_MARKER();
+            }
+        }
+
+        /* When the table is full the last entry collects the other sites. */
+        return xSite;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvHeapTimingAdd( HeapTiming_t * pxTiming,
+                                  uint32_t uStart ) /* PRIVILEGED_FUNCTION */
+    {
+        uint32_t uCycles = DWT->CYCCNT - uStart;
+
+        pxTiming->uCalls++;
+        pxTiming->uSum += uCycles;
+
+        if( uCycles > pxTiming->uMax )
+        {
+            pxTiming->uMax = uCycles;
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    void vPortGetHeapProfile( HeapProfile_t * pxProfile )
+    {
+        TlsfFreeBlock_t * pxBlock;
+        UBaseType_t uxFl;
+        UBaseType_t uxSl;
+        uint32_t uBin;
+
+        vTaskSuspendAll();
+        {
+            *pxProfile = xHeapProfile;
+            pxProfile->uFreeBytes = xFreeBytesRemaining;
+
+            for( uxFl = 0; uxFl < tlsfFL_COUNT; uxFl++ )
+            {
+                for( uxSl = 0; uxSl < tlsfSL_COUNT; uxSl++ )
+                {
+                    for( pxBlock = pxFreeLists[ uxFl ][ uxSl ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFree )
+                    {
+                        pxProfile->uFreeBlocks++;
+
+                        if( tlsfBLOCK_SIZE( &( pxBlock->xHeader ) ) > pxProfile->uLargestFree )
+                        {
+                            pxProfile->uLargestFree = tlsfBLOCK_SIZE( &( pxBlock->xHeader ) );
+                        }
+
+                        /* Bin 0 holds the blocks below 32 bytes, each next bin
+                         * doubles the size. */
+                        uBin = ( 32U - ( uint32_t ) __CLZ( tlsfBLOCK_SIZE( &( pxBlock->xHeader ) ) ) );
+                        uBin = ( uBin > 5U ) ? ( uBin - 5U ) : 0U;
+
+                        if( uBin >= HEAP_PROFILER_BINS )
+                        {
+                            uBin = HEAP_PROFILER_BINS - 1;
+                        }
+
+                        pxProfile->uFreeBins[ uBin ]++;
+                    }
+                }
+            }
+        }
+        ( void ) xTaskResumeAll();
+    }
+
+#endif /* HEAP_PROFILER_EN */
+
+#endif /* HEAP_TLSF_EN, STATIC_ALLOCATION_EN */
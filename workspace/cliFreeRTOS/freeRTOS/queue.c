@@ -130,6 +130,10 @@ typedef struct QueueDefinition /* The old naming convention is used to prevent b
         UBaseType_t uxQueueNumber;
         uint8_t ucQueueType;
     #endif
+
+    #if ( configUSE_QUEUE_STATS == 1 )
+        QueueStats_t xStats; /*< Contention statistics, see uxQueueGetRegistryStats(). */
+    #endif
 } xQUEUE;
 
 /* The old xQUEUE name is maintained above then typedefed to the new Queue_t
@@ -165,6 +169,39 @@ typedef xQUEUE Queue_t;
 
 #endif /* configQUEUE_REGISTRY_SIZE */
 
+#if ( configUSE_QUEUE_STATS == 1 )
+    #if ( configGENERATE_RUN_TIME_STATS == 0 ) || ( configUSE_TRACE_FACILITY == 0 )
+        #error Queue statistics need configGENERATE_RUN_TIME_STATS and configUSE_TRACE_FACILITY
+    #endif
+
+/*
+ * Count a call that is about to block, only the first time the call blocks.
+ */
+    static void prvStatsBlocking( BaseType_t * const pxHasBlocked,
+                                  configRUN_TIME_COUNTER_TYPE * const pxBlockStart,
+                                  uint32_t * const pulBlocks ) PRIVILEGED_FUNCTION;
+
+/*
+ * Called when a send or receive call returns.  Adds the time the call was
+ * blocked, if it blocked, and counts a failure when pulFails is not NULL.
+ */
+    static void prvStatsReturn( Queue_t * const pxQueue,
+                                const BaseType_t xHasBlocked,
+                                const configRUN_TIME_COUNTER_TYPE xBlockStart,
+                                uint32_t * const pulFails ) PRIVILEGED_FUNCTION;
+
+/*
+ * Record the peak number of items, called each time an item is added.
+ */
+    #define prvStatsPeak( pxQueue )                                                          \
+    do {                                                                                     \
+        if( ( pxQueue )->uxMessagesWaiting > ( pxQueue )->xStats.uxPeakMessagesWaiting )     \
+        {                                                                                    \
+            ( pxQueue )->xStats.uxPeakMessagesWaiting = ( pxQueue )->uxMessagesWaiting;      \
+        }                                                                                    \
+    } while( 0 )
+#endif /* configUSE_QUEUE_STATS */
+
 /*
  * Unlocks a queue locked by a call to prvLockQueue.  Locking a queue does not
  * prevent an ISR from adding or removing items to the queue, but does prevent
@@ -497,6 +534,12 @@ static void prvInitialiseNewQueue( const UBaseType_t uxQueueLength,
         }
     #endif /* configUSE_TRACE_FACILITY */
 
+    #if ( configUSE_QUEUE_STATS == 1 )
+        {
+            ( void ) memset( &( pxNewQueue->xStats ), 0x00, sizeof( QueueStats_t ) );
+        }
+    #endif
+
     #if ( configUSE_QUEUE_SETS == 1 )
         {
             pxNewQueue->pxQueueSetContainer = NULL;
@@ -811,6 +854,11 @@ BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
     TimeOut_t xTimeOut;
     Queue_t * const pxQueue = xQueue;
 
+    #if ( configUSE_QUEUE_STATS == 1 )
+        BaseType_t xHasBlocked = pdFALSE;
+        configRUN_TIME_COUNTER_TYPE xBlockStart = 0;
+    #endif
+
     configASSERT( pxQueue );
     configASSERT( !( ( pvItemToQueue == NULL ) && ( pxQueue->uxItemSize != ( UBaseType_t ) 0U ) ) );
     configASSERT( !( ( xCopyPosition == queueOVERWRITE ) && ( pxQueue->uxLength != 1 ) ) );
@@ -931,6 +979,12 @@ BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
                     }
                 #endif /* configUSE_QUEUE_SETS */
 
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, NULL );
+                    }
+                #endif
+
                 taskEXIT_CRITICAL();
                 return pdPASS;
             }
@@ -940,6 +994,12 @@ BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
                 {
                     /* The queue was full and no block time is specified (or
                      * the block time has expired) so leave now. */
+                    #if ( configUSE_QUEUE_STATS == 1 )
+                        {
+                            prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, &( pxQueue->xStats.ulSendFails ) );
+                        }
+                    #endif
+
                     taskEXIT_CRITICAL();
 
                     /* Return to the original privilege level before exiting
@@ -975,6 +1035,13 @@ BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
             if( prvIsQueueFull( pxQueue ) != pdFALSE )
             {
                 traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsBlocking( &xHasBlocked, &xBlockStart, &( pxQueue->xStats.ulSendBlocks ) );
+                    }
+                #endif
+
                 vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
 
                 /* Unlocking the queue means queue events can effect the
@@ -1007,6 +1074,12 @@ BaseType_t xQueueGenericSend( QueueHandle_t xQueue,
             prvUnlockQueue( pxQueue );
             ( void ) xTaskResumeAll();
 
+            #if ( configUSE_QUEUE_STATS == 1 )
+                {
+                    prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, &( pxQueue->xStats.ulSendFails ) );
+                }
+            #endif
+
             traceQUEUE_SEND_FAILED( pxQueue );
             return errQUEUE_FULL;
         }
@@ -1173,6 +1246,12 @@ BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue,
         {
             traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
             xReturn = errQUEUE_FULL;
+
+            #if ( configUSE_QUEUE_STATS == 1 )
+                {
+                    pxQueue->xStats.ulSendFails++;
+                }
+            #endif
         }
     }
     portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
@@ -1242,6 +1321,12 @@ BaseType_t xQueueGiveFromISR( QueueHandle_t xQueue,
              * messages (semaphores) available. */
             pxQueue->uxMessagesWaiting = uxMessagesWaiting + ( UBaseType_t ) 1;
 
+            #if ( configUSE_QUEUE_STATS == 1 )
+                {
+                    prvStatsPeak( pxQueue );
+                }
+            #endif
+
             /* The event list is not altered if the queue is locked.  This will
              * be done when the queue is unlocked later. */
             if( cTxLock == queueUNLOCKED )
@@ -1341,6 +1426,12 @@ BaseType_t xQueueGiveFromISR( QueueHandle_t xQueue,
         {
             traceQUEUE_SEND_FROM_ISR_FAILED( pxQueue );
             xReturn = errQUEUE_FULL;
+
+            #if ( configUSE_QUEUE_STATS == 1 )
+                {
+                    pxQueue->xStats.ulSendFails++;
+                }
+            #endif
         }
     }
     portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
@@ -1357,6 +1448,11 @@ BaseType_t xQueueReceive( QueueHandle_t xQueue,
     TimeOut_t xTimeOut;
     Queue_t * const pxQueue = xQueue;
 
+    #if ( configUSE_QUEUE_STATS == 1 )
+        BaseType_t xHasBlocked = pdFALSE;
+        configRUN_TIME_COUNTER_TYPE xBlockStart = 0;
+    #endif
+
     /* Check the pointer is not NULL. */
     configASSERT( ( pxQueue ) );
 
@@ -1408,6 +1504,12 @@ BaseType_t xQueueReceive( QueueHandle_t xQueue,
                     mtCOVERAGE_TEST_MARKER();
                 }
 
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, NULL );
+                    }
+                #endif
+
                 taskEXIT_CRITICAL();
                 return pdPASS;
             }
@@ -1451,6 +1553,12 @@ BaseType_t xQueueReceive( QueueHandle_t xQueue,
             if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
             {
                 traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsBlocking( &xHasBlocked, &xBlockStart, &( pxQueue->xStats.ulReceiveBlocks ) );
+                    }
+                #endif
                 vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
                 prvUnlockQueue( pxQueue );
 
@@ -1480,6 +1588,12 @@ BaseType_t xQueueReceive( QueueHandle_t xQueue,
 
             if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
             {
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, &( pxQueue->xStats.ulReceiveTimeouts ) );
+                    }
+                #endif
+
                 traceQUEUE_RECEIVE_FAILED( pxQueue );
                 return errQUEUE_EMPTY;
             }
@@ -1499,6 +1613,11 @@ BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue,
     TimeOut_t xTimeOut;
     Queue_t * const pxQueue = xQueue;
 
+    #if ( configUSE_QUEUE_STATS == 1 )
+        BaseType_t xHasBlocked = pdFALSE;
+        configRUN_TIME_COUNTER_TYPE xBlockStart = 0;
+    #endif
+
     #if ( configUSE_MUTEXES == 1 )
         BaseType_t xInheritanceOccurred = pdFALSE;
     #endif
@@ -1571,6 +1690,12 @@ BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue,
                     mtCOVERAGE_TEST_MARKER();
                 }
 
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, NULL );
+                    }
+                #endif
+
                 taskEXIT_CRITICAL();
                 return pdPASS;
             }
@@ -1626,6 +1751,12 @@ BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue,
             {
                 traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
 
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsBlocking( &xHasBlocked, &xBlockStart, &( pxQueue->xStats.ulReceiveBlocks ) );
+                    }
+                #endif
+
                 #if ( configUSE_MUTEXES == 1 )
                     {
                         if( pxQueue->uxQueueType == queueQUEUE_IS_MUTEX )
@@ -1633,6 +1764,15 @@ BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue,
                             taskENTER_CRITICAL();
                             {
                                 xInheritanceOccurred = xTaskPriorityInherit( pxQueue->u.xSemaphore.xMutexHolder );
+
+                                #if ( configUSE_QUEUE_STATS == 1 )
+                                    {
+                                        if( xInheritanceOccurred != pdFALSE )
+                                        {
+                                            pxQueue->xStats.ulInheritances++;
+                                        }
+                                    }
+                                #endif
                             }
                             taskEXIT_CRITICAL();
                         }
@@ -1699,6 +1839,12 @@ BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue,
                     }
                 #endif /* configUSE_MUTEXES */
 
+                #if ( configUSE_QUEUE_STATS == 1 )
+                    {
+                        prvStatsReturn( pxQueue, xHasBlocked, xBlockStart, &( pxQueue->xStats.ulReceiveTimeouts ) );
+                    }
+                #endif
+
                 traceQUEUE_RECEIVE_FAILED( pxQueue );
                 return errQUEUE_EMPTY;
             }
@@ -2236,6 +2382,12 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue,
 
     pxQueue->uxMessagesWaiting = uxMessagesWaiting + ( UBaseType_t ) 1;
 
+    #if ( configUSE_QUEUE_STATS == 1 )
+        {
+            prvStatsPeak( pxQueue );
+        }
+    #endif
+
     return xReturn;
 }
 /*-----------------------------------------------------------*/
@@ -2862,6 +3014,122 @@ BaseType_t xQueueIsQueueFullFromISR( const QueueHandle_t xQueue )
 #endif /* configQUEUE_REGISTRY_SIZE */
 /*-----------------------------------------------------------*/
 
+#if ( configUSE_QUEUE_STATS == 1 )
+
+    static void prvStatsBlocking( BaseType_t * const pxHasBlocked,
+                                  configRUN_TIME_COUNTER_TYPE * const pxBlockStart,
+                                  uint32_t * const pulBlocks )
+    {
+        /* The scheduler is suspended and only tasks block, so the count can
+         * be updated outside of a critical section. */
+        if( *pxHasBlocked == pdFALSE )
+        {
+            *pxHasBlocked = pdTRUE;
+            *pxBlockStart = portGET_RUN_TIME_COUNTER_VALUE();
+            ( *pulBlocks )++;
+        }
+        else
+        {
+            mtCOVERAGE_TEST_MARKER();
+        }
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvStatsReturn( Queue_t * const pxQueue,
+                                const BaseType_t xHasBlocked,
+                                const configRUN_TIME_COUNTER_TYPE xBlockStart,
+                                uint32_t * const pulFails )
+    {
+        configRUN_TIME_COUNTER_TYPE xBlockedTime;
+
+        if( ( xHasBlocked == pdFALSE ) && ( pulFails == NULL ) )
+        {
+            return;
+        }
+
+        /* May be called from within a critical section, they nest. */
+        taskENTER_CRITICAL();
+        {
+            if( pulFails != NULL )
+            {
+                ( *pulFails )++;
+            }
+
+            if( xHasBlocked != pdFALSE )
+            {
+                xBlockedTime = portGET_RUN_TIME_COUNTER_VALUE() - xBlockStart;
+                pxQueue->xStats.ulBlockedTime += xBlockedTime;
+
+                if( xBlockedTime > pxQueue->xStats.ulMaxBlockedTime )
+                {
+                    pxQueue->xStats.ulMaxBlockedTime = xBlockedTime;
+                }
+            }
+        }
+        taskEXIT_CRITICAL();
+    }
+/*-----------------------------------------------------------*/
+
+    #if ( configQUEUE_REGISTRY_SIZE > 0 )
+
+        UBaseType_t uxQueueGetRegistryStats( QueueRegistryStats_t * const pxStats,
+                                             const UBaseType_t uxMaxEntries )
+        {
+            UBaseType_t ux;
+            UBaseType_t uxCount = 0;
+            Queue_t * pxQueue;
+
+            for( ux = ( UBaseType_t ) 0U; ( ux < ( UBaseType_t ) configQUEUE_REGISTRY_SIZE ) && ( uxCount < uxMaxEntries ); ux++ )
+            {
+                taskENTER_CRITICAL();
+                {
+                    pxQueue = xQueueRegistry[ ux ].xHandle;
+
+                    if( ( xQueueRegistry[ ux ].pcQueueName != NULL ) && ( pxQueue != NULL ) )
+                    {
+                        pxStats[ uxCount ].pcQueueName = xQueueRegistry[ ux ].pcQueueName;
+                        pxStats[ uxCount ].ucQueueType = pxQueue->ucQueueType;
+                        pxStats[ uxCount ].uxLength = pxQueue->uxLength;
+                        pxStats[ uxCount ].uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+                        pxStats[ uxCount ].xStats = pxQueue->xStats;
+                        uxCount++;
+                    }
+                }
+                taskEXIT_CRITICAL();
+            }
+
+            return uxCount;
+        }
+/*-----------------------------------------------------------*/
+
+        void vQueueResetRegistryStats( void )
+        {
+            UBaseType_t ux;
+            Queue_t * pxQueue;
+
+            for( ux = ( UBaseType_t ) 0U; ux < ( UBaseType_t ) configQUEUE_REGISTRY_SIZE; ux++ )
+            {
+                taskENTER_CRITICAL();
+                {
+                    pxQueue = xQueueRegistry[ ux ].xHandle;
+
+                    if( ( xQueueRegistry[ ux ].pcQueueName != NULL ) && ( pxQueue != NULL ) )
+                    {
+                        ( void ) memset( &( pxQueue->xStats ), 0x00, sizeof( QueueStats_t ) );
+
+                        /* The peak starts from the items there are now. */
+                        pxQueue->xStats.uxPeakMessagesWaiting = pxQueue->uxMessagesWaiting;
+                    }
+                }
+                taskEXIT_CRITICAL();
+            }
+        }
+
+    #endif /* configQUEUE_REGISTRY_SIZE */
+
+#endif /* configUSE_QUEUE_STATS */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TIMERS == 1 )
 
     void vQueueWaitForMessageRestricted( QueueHandle_t xQueue,